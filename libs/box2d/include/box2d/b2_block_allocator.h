@@ -27,12 +27,34 @@
 
 const int32 b2_blockSizeCount = 14;
 
+/// Number of blocks a b2BlockCache takes from or returns to its allocator at once.
+const int32 b2_blockCacheBatch = 32;
+
 struct b2Block;
 struct b2Chunk;
+struct b2BlockLock;
+
+/// Memory use of a b2BlockAllocator.
+struct b2BlockAllocatorStats
+{
+	/// Blocks in use per size class and their bytes. Blocks held by a b2BlockCache count as used.
+	int32 blockCounts[b2_blockSizeCount];
+	int32 blockBytes[b2_blockSizeCount];
+
+	/// Allocations larger than b2_maxBlockSize, passed to b2Alloc.
+	int32 largeCount;
+	int32 largeBytes;
+
+	/// Chunks taken from b2Alloc and their bytes, used or not.
+	int32 chunkCount;
+	int32 chunkBytes;
+};
 
 /// This is a small object allocator used for allocating small
 /// objects that persist for more than one time step.
 /// See: http://www.codeproject.com/useritems/Small_Block_Allocator.asp
+/// The allocator is not thread-safe by default, see SetThreadSafe. Threads allocating
+/// often should go through a b2BlockCache each, so they rarely contend for the lock.
 class b2BlockAllocator
 {
 public:
@@ -47,13 +69,75 @@ public:
 
 	void Clear();
 
+	/// Guard the allocator by a lock, so it can be shared by threads, e.g. by b2BlockCache
+	/// of each thread. Without it no lock is taken. Don't change it while the allocator is in use
+	/// by other threads.
+	void SetThreadSafe(bool flag) { m_threadSafe = flag; }
+	bool IsThreadSafe() const { return m_threadSafe; }
+
+	/// Return the chunks without used blocks to b2Free, e.g. after a world was cleared.
+	/// Blocks held by caches are used, flush the caches first to release them too.
+	void Compact();
+
+	/// Get the current memory use.
+	void GetStats(b2BlockAllocatorStats* stats) const;
+
+	/// Get the size of the blocks of a size class.
+	static int32 GetBlockSize(int32 sizeClass);
+
 private:
 
+	friend class b2BlockCache;
+
+	b2Block* AllocateBlock(int32 index);
+	void FreeBlock(b2Block* block, int32 index);
+
+	// Used by b2BlockCache, these lock once for the whole batch.
+	b2Block* AllocateBatch(int32 index, int32 count);
+	void FreeBatch(b2Block* blocks, int32 index, int32 count);
+
+	b2BlockLock* m_lock;
+	bool m_threadSafe;
+
 	b2Chunk* m_chunks;
 	int32 m_chunkCount;
 	int32 m_chunkSpace;
 
 	b2Block* m_freeLists[b2_blockSizeCount];
+
+	int32 m_blockCounts[b2_blockSizeCount];
+	int32 m_largeCount;
+	int32 m_largeBytes;
+};
+
+/// A per thread cache of a shared b2BlockAllocator. Blocks are taken from and returned
+/// to the allocator in batches of b2_blockCacheBatch, so most allocations do not lock.
+/// Caches on several threads need a thread-safe allocator, see b2BlockAllocator::SetThreadSafe.
+/// A cache must be used by one thread at a time. A block may be freed to another cache
+/// or to the allocator than the one it was allocated from.
+class b2BlockCache
+{
+public:
+	b2BlockCache(b2BlockAllocator* allocator);
+
+	/// Returns the cached blocks to the allocator.
+	~b2BlockCache();
+
+	/// Allocate memory. Larger allocations than b2_maxBlockSize go to the allocator.
+	void* Allocate(int32 size);
+
+	/// Free memory.
+	void Free(void* p, int32 size);
+
+	/// Return all cached blocks to the allocator.
+	void Flush();
+
+private:
+
+	b2BlockAllocator* m_allocator;
+
+	b2Block* m_freeLists[b2_blockSizeCount];
+	int32 m_counts[b2_blockSizeCount];
 };
 
 #endif
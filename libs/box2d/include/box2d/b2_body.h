@@ -26,6 +26,7 @@
 #include "b2_math.h"
 #include "b2_shape.h"
 
+class b2Body;
 class b2Fixture;
 class b2Joint;
 class b2Contact;
@@ -46,6 +47,24 @@ enum b2BodyType
 	b2_dynamicBody
 };
 
+#define b2_nullState (-1)
+
+/// State of all bodies of a world in contiguous arrays, indexed by b2Body::GetStateIndex.
+/// See b2World::GetBodyStateArrays. This is where bodies keep their state, the island
+/// solver reads and writes it directly, so it's cheap to read for many bodies at once,
+/// e.g. for drawing. Do not modify it, use the body. Slots of destroyed bodies are reused,
+/// their body is null. The c0 and alpha0 of sweeps are internal to continuous collision.
+struct b2BodyStateArrays
+{
+	b2Transform* transforms;
+	b2Sweep* sweeps;
+	b2Vec2* linearVelocities;
+	float* angularVelocities;
+	b2Body** bodies;
+	int32 count;
+	int32 capacity;
+};
+
 /// A body definition holds all the data needed to construct a rigid body.
 /// You can safely re-use body definitions. Shapes are added to a body after construction.
 struct b2BodyDef
@@ -60,6 +79,7 @@ struct b2BodyDef
 		linearDamping = 0.0f;
 		angularDamping = 0.0f;
 		allowSleep = true;
+		sleepThreshold = b2_linearSleepTolerance;
 		awake = true;
 		fixedRotation = false;
 		bullet = false;
@@ -101,6 +121,10 @@ struct b2BodyDef
 	/// this increases CPU usage.
 	bool allowSleep;
 
+	/// The body may fall asleep when its linear speed stays below this threshold, in meters
+	/// per second. The angular tolerance is scaled by the same ratio.
+	float sleepThreshold;
+
 	/// Is this body initially awake or sleeping?
 	bool awake;
 
@@ -323,6 +347,12 @@ public:
 	/// Is this body allowed to sleep
 	bool IsSleepingAllowed() const;
 
+	/// Set the linear speed below which the body may fall asleep, see b2BodyDef::sleepThreshold.
+	void SetSleepThreshold(float speed);
+
+	/// Get the sleep threshold of the body.
+	float GetSleepThreshold() const;
+
 	/// Set the sleep state of the body. A sleeping body has very
 	/// low CPU cost.
 	/// @param flag set to true to wake the body, false to put it to sleep.
@@ -384,6 +414,10 @@ public:
 	b2World* GetWorld();
 	const b2World* GetWorld() const;
 
+	/// Get the slot of this body in the body state arrays of the world. The slot doesn't
+	/// change while the body exists.
+	int32 GetStateIndex() const;
+
 	/// Dump this body to a file
 	void Dump();
 
@@ -394,6 +428,7 @@ private:
 	friend class b2ContactManager;
 	friend class b2ContactSolver;
 	friend class b2Contact;
+	friend class b2TOITask;
 	
 	friend class b2DistanceJoint;
 	friend class b2FrictionJoint;
@@ -425,6 +460,16 @@ private:
 	void SynchronizeFixtures();
 	void SynchronizeTransform();
 
+	// State of the body in the arrays of the world.
+	b2Transform& Transform();
+	const b2Transform& Transform() const;
+	b2Sweep& Sweep();
+	const b2Sweep& Sweep() const;
+	b2Vec2& LinearVelocity();
+	const b2Vec2& LinearVelocity() const;
+	float& AngularVelocity();
+	float AngularVelocity() const;
+
 	// This is used to prevent connected bodies from colliding.
 	// It may lie, depending on the collideConnected flag.
 	bool ShouldCollide(const b2Body* other) const;
@@ -437,11 +482,9 @@ private:
 
 	int32 m_islandIndex;
 
-	b2Transform m_xf;		// the body origin transform
-	b2Sweep m_sweep;		// the swept motion for CCD
-
-	b2Vec2 m_linearVelocity;
-	float m_angularVelocity;
+	// Transform, sweep and velocities live in the arrays of the world, see b2BodyStateArrays.
+	b2BodyStateArrays* m_states;
+	int32 m_stateIndex;
 
 	b2Vec2 m_force;
 	float m_torque;
@@ -466,6 +509,7 @@ private:
 	float m_gravityScale;
 
 	float m_sleepTime;
+	float m_sleepThreshold;
 
 	b2BodyUserData m_userData;
 };
@@ -477,27 +521,27 @@ inline b2BodyType b2Body::GetType() const
 
 inline const b2Transform& b2Body::GetTransform() const
 {
-	return m_xf;
+	return Transform();
 }
 
 inline const b2Vec2& b2Body::GetPosition() const
 {
-	return m_xf.p;
+	return Transform().p;
 }
 
 inline float b2Body::GetAngle() const
 {
-	return m_sweep.a;
+	return Sweep().a;
 }
 
 inline const b2Vec2& b2Body::GetWorldCenter() const
 {
-	return m_sweep.c;
+	return Sweep().c;
 }
 
 inline const b2Vec2& b2Body::GetLocalCenter() const
 {
-	return m_sweep.localCenter;
+	return Sweep().localCenter;
 }
 
 inline void b2Body::SetLinearVelocity(const b2Vec2& v)
@@ -512,12 +556,12 @@ inline void b2Body::SetLinearVelocity(const b2Vec2& v)
 		SetAwake(true);
 	}
 
-	m_linearVelocity = v;
+	LinearVelocity() = v;
 }
 
 inline const b2Vec2& b2Body::GetLinearVelocity() const
 {
-	return m_linearVelocity;
+	return LinearVelocity();
 }
 
 inline void b2Body::SetAngularVelocity(float w)
@@ -532,12 +576,12 @@ inline void b2Body::SetAngularVelocity(float w)
 		SetAwake(true);
 	}
 
-	m_angularVelocity = w;
+	AngularVelocity() = w;
 }
 
 inline float b2Body::GetAngularVelocity() const
 {
-	return m_angularVelocity;
+	return AngularVelocity();
 }
 
 inline float b2Body::GetMass() const
@@ -547,39 +591,41 @@ inline float b2Body::GetMass() const
 
 inline float b2Body::GetInertia() const
 {
-	return m_I + m_mass * b2Dot(m_sweep.localCenter, m_sweep.localCenter);
+	const b2Vec2& localCenter = Sweep().localCenter;
+	return m_I + m_mass * b2Dot(localCenter, localCenter);
 }
 
 inline void b2Body::GetMassData(b2MassData* data) const
 {
+	const b2Vec2& localCenter = Sweep().localCenter;
 	data->mass = m_mass;
-	data->I = m_I + m_mass * b2Dot(m_sweep.localCenter, m_sweep.localCenter);
-	data->center = m_sweep.localCenter;
+	data->I = m_I + m_mass * b2Dot(localCenter, localCenter);
+	data->center = localCenter;
 }
 
 inline b2Vec2 b2Body::GetWorldPoint(const b2Vec2& localPoint) const
 {
-	return b2Mul(m_xf, localPoint);
+	return b2Mul(Transform(), localPoint);
 }
 
 inline b2Vec2 b2Body::GetWorldVector(const b2Vec2& localVector) const
 {
-	return b2Mul(m_xf.q, localVector);
+	return b2Mul(Transform().q, localVector);
 }
 
 inline b2Vec2 b2Body::GetLocalPoint(const b2Vec2& worldPoint) const
 {
-	return b2MulT(m_xf, worldPoint);
+	return b2MulT(Transform(), worldPoint);
 }
 
 inline b2Vec2 b2Body::GetLocalVector(const b2Vec2& worldVector) const
 {
-	return b2MulT(m_xf.q, worldVector);
+	return b2MulT(Transform().q, worldVector);
 }
 
 inline b2Vec2 b2Body::GetLinearVelocityFromWorldPoint(const b2Vec2& worldPoint) const
 {
-	return m_linearVelocity + b2Cross(m_angularVelocity, worldPoint - m_sweep.c);
+	return LinearVelocity() + b2Cross(AngularVelocity(), worldPoint - Sweep().c);
 }
 
 inline b2Vec2 b2Body::GetLinearVelocityFromLocalPoint(const b2Vec2& localPoint) const
@@ -650,8 +696,8 @@ inline void b2Body::SetAwake(bool flag)
 	{
 		m_flags &= ~e_awakeFlag;
 		m_sleepTime = 0.0f;
-		m_linearVelocity.SetZero();
-		m_angularVelocity = 0.0f;
+		LinearVelocity().SetZero();
+		AngularVelocity() = 0.0f;
 		m_force.SetZero();
 		m_torque = 0.0f;
 	}
@@ -690,6 +736,17 @@ inline bool b2Body::IsSleepingAllowed() const
 	return (m_flags & e_autoSleepFlag) == e_autoSleepFlag;
 }
 
+inline void b2Body::SetSleepThreshold(float speed)
+{
+	b2Assert(speed >= 0.0f);
+	m_sleepThreshold = speed;
+}
+
+inline float b2Body::GetSleepThreshold() const
+{
+	return m_sleepThreshold;
+}
+
 inline b2Fixture* b2Body::GetFixtureList()
 {
 	return m_fixtureList;
@@ -751,7 +808,7 @@ inline void b2Body::ApplyForce(const b2Vec2& force, const b2Vec2& point, bool wa
 	if (m_flags & e_awakeFlag)
 	{
 		m_force += force;
-		m_torque += b2Cross(point - m_sweep.c, force);
+		m_torque += b2Cross(point - Sweep().c, force);
 	}
 }
 
@@ -808,8 +865,8 @@ inline void b2Body::ApplyLinearImpulse(const b2Vec2& impulse, const b2Vec2& poin
 	// Don't accumulate velocity if the body is sleeping
 	if (m_flags & e_awakeFlag)
 	{
-		m_linearVelocity += m_invMass * impulse;
-		m_angularVelocity += m_invI * b2Cross(point - m_sweep.c, impulse);
+		LinearVelocity() += m_invMass * impulse;
+		AngularVelocity() += m_invI * b2Cross(point - Sweep().c, impulse);
 	}
 }
 
@@ -828,7 +885,7 @@ inline void b2Body::ApplyLinearImpulseToCenter(const b2Vec2& impulse, bool wake)
 	// Don't accumulate velocity if the body is sleeping
 	if (m_flags & e_awakeFlag)
 	{
-		m_linearVelocity += m_invMass * impulse;
+		LinearVelocity() += m_invMass * impulse;
 	}
 }
 
@@ -847,24 +904,29 @@ inline void b2Body::ApplyAngularImpulse(float impulse, bool wake)
 	// Don't accumulate velocity if the body is sleeping
 	if (m_flags & e_awakeFlag)
 	{
-		m_angularVelocity += m_invI * impulse;
+		AngularVelocity() += m_invI * impulse;
 	}
 }
 
 inline void b2Body::SynchronizeTransform()
 {
-	m_xf.q.Set(m_sweep.a);
-	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+	b2Transform& xf = Transform();
+	const b2Sweep& sweep = Sweep();
+	xf.q.Set(sweep.a);
+	xf.p = sweep.c - b2Mul(xf.q, sweep.localCenter);
 }
 
 inline void b2Body::Advance(float alpha)
 {
 	// Advance to the new safe time. This doesn't sync the broad-phase.
-	m_sweep.Advance(alpha);
-	m_sweep.c = m_sweep.c0;
-	m_sweep.a = m_sweep.a0;
-	m_xf.q.Set(m_sweep.a);
-	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+	b2Sweep& sweep = Sweep();
+	sweep.Advance(alpha);
+	sweep.c = sweep.c0;
+	sweep.a = sweep.a0;
+
+	b2Transform& xf = Transform();
+	xf.q.Set(sweep.a);
+	xf.p = sweep.c - b2Mul(xf.q, sweep.localCenter);
 }
 
 inline b2World* b2Body::GetWorld()
@@ -877,4 +939,49 @@ inline const b2World* b2Body::GetWorld() const
 	return m_world;
 }
 
+inline int32 b2Body::GetStateIndex() const
+{
+	return m_stateIndex;
+}
+
+inline b2Transform& b2Body::Transform()
+{
+	return m_states->transforms[m_stateIndex];
+}
+
+inline const b2Transform& b2Body::Transform() const
+{
+	return m_states->transforms[m_stateIndex];
+}
+
+inline b2Sweep& b2Body::Sweep()
+{
+	return m_states->sweeps[m_stateIndex];
+}
+
+inline const b2Sweep& b2Body::Sweep() const
+{
+	return m_states->sweeps[m_stateIndex];
+}
+
+inline b2Vec2& b2Body::LinearVelocity()
+{
+	return m_states->linearVelocities[m_stateIndex];
+}
+
+inline const b2Vec2& b2Body::LinearVelocity() const
+{
+	return m_states->linearVelocities[m_stateIndex];
+}
+
+inline float& b2Body::AngularVelocity()
+{
+	return m_states->angularVelocities[m_stateIndex];
+}
+
+inline float b2Body::AngularVelocity() const
+{
+	return m_states->angularVelocities[m_stateIndex];
+}
+
 #endif
@@ -26,6 +26,7 @@
 #include "b2_settings.h"
 #include "b2_collision.h"
 #include "b2_dynamic_tree.h"
+#include "b2_uniform_grid.h"
 
 struct b2Pair
 {
@@ -33,9 +34,114 @@ struct b2Pair
 	int32 proxyIdB;
 };
 
+/// The structure storing the broad-phase proxies.
+enum b2BroadPhaseType
+{
+	/// b2DynamicTree, adapts to any distribution of proxy sizes.
+	b2_dynamicTreeBroadPhase,
+
+	/// b2UniformGrid, fast for many proxies of similar size.
+	b2_uniformGridBroadPhase
+};
+
+/// Passes the proxies of the static tree or the dynamic structure to the client with
+/// the proxy ids of the broad-phase. The client does not interact with this directly.
+template <typename T>
+struct b2BroadPhaseCallback
+{
+	bool QueryCallback(int32 proxyId)
+	{
+		bool proceed = callback->QueryCallback((proxyId << 1) | staticBit);
+		terminated = proceed == false;
+		return proceed;
+	}
+
+	float RayCastCallback(const b2RayCastInput& input, int32 proxyId)
+	{
+		float value = callback->RayCastCallback(input, (proxyId << 1) | staticBit);
+		if (value > 0.0f)
+		{
+			maxFraction = value;
+		}
+		terminated = value == 0.0f;
+		return value;
+	}
+
+	T* callback;
+	int32 staticBit;
+
+	// Clipping of the ray, passed from the static tree to the dynamic structure.
+	float maxFraction;
+	bool terminated;
+};
+
+/// Passes the proxies found for a packet of a batch to the client with the index of the
+/// query or ray in the batch. The client does not interact with this directly.
+template <typename T>
+struct b2BroadPhaseBatchCallback
+{
+	bool QueryCallback(int32 index, int32 proxyId)
+	{
+		// Queries stopped in the static tree are dropped by the dynamic structure on their first proxy.
+		uint32 bit = 1u << index;
+		if (stopped & bit)
+		{
+			return false;
+		}
+
+		bool proceed = callback->QueryCallback(base + index, (proxyId << 1) | staticBit);
+		if (proceed == false)
+		{
+			stopped |= bit;
+		}
+		return proceed;
+	}
+
+	float RayCastCallback(int32 index, const b2RayCastInput& input, int32 proxyId)
+	{
+		float value = callback->RayCastCallback(base + index, input, (proxyId << 1) | staticBit);
+		if (value >= 0.0f)
+		{
+			// A terminated ray has no length left for the dynamic structure.
+			inputs[index].maxFraction = value;
+		}
+		return value;
+	}
+
+	// The uniform grid is queried one member of the packet at a time.
+	bool QueryCallback(int32 proxyId)
+	{
+		return QueryCallback(index, proxyId);
+	}
+
+	float RayCastCallback(const b2RayCastInput& input, int32 proxyId)
+	{
+		return RayCastCallback(index, input, proxyId);
+	}
+
+	T* callback;
+	int32 staticBit;
+
+	// Index of the first member of the packet in the batch.
+	int32 base;
+
+	// Member of the packet queried in the uniform grid.
+	int32 index;
+
+	// Rays of the packet, clipped by the static tree.
+	b2RayCastInput* inputs;
+
+	// Queries of the packet stopped by the client.
+	uint32 stopped;
+};
+
 /// The broad-phase is used for computing pairs and performing volume queries and ray casts.
 /// This broad-phase does not persist pairs. Instead, this reports potentially new pairs.
 /// It is up to the client to consume the new pairs and to track subsequent overlap.
+///
+/// Static proxies are kept in a separate tree. They do not form pairs with each other and
+/// the tree is rebuilt with RebuildTopDown after many static proxies were added,
+/// instead of being balanced for every moving proxy.
 class b2BroadPhase
 {
 public:
@@ -48,10 +154,26 @@ public:
 	b2BroadPhase();
 	~b2BroadPhase();
 
+	/// Select the structure storing the proxies. This asserts if there are any proxies.
+	void SetType(b2BroadPhaseType type);
+
+	/// Get the structure storing the proxies.
+	b2BroadPhaseType GetType() const;
+
+	/// Set the cell size of the uniform grid. Existing proxies of the grid are re-inserted.
+	void SetGridCellSize(float cellSize);
+
+	/// Get the cell size of the uniform grid.
+	float GetGridCellSize() const;
+
 	/// Create a proxy with an initial AABB. Pairs are not reported until
 	/// UpdatePairs is called.
 	int32 CreateProxy(const b2AABB& aabb, void* userData);
 
+	/// Create a proxy in the static tree. It is expected to move rarely and
+	/// it does not form pairs with other static proxies.
+	int32 CreateStaticProxy(const b2AABB& aabb, void* userData);
+
 	/// Destroy a proxy. It is up to the client to remove any pairs.
 	void DestroyProxy(int32 proxyId);
 
@@ -83,7 +205,7 @@ public:
 	template <typename T>
 	void Query(T* callback, const b2AABB& aabb) const;
 
-	/// Ray-cast against the proxies in the tree. This relies on the callback
+	/// Ray-cast against the proxies in the tree or grid. This relies on the callback
 	/// to perform a exact ray-cast in the case were the proxy contains a shape.
 	/// The callback also performs the any collision filtering. This has performance
 	/// roughly equal to k * log(n), where k is the number of collisions and n is the
@@ -93,15 +215,30 @@ public:
 	template <typename T>
 	void RayCast(T* callback, const b2RayCastInput& input) const;
 
-	/// Get the height of the embedded tree.
+	/// Query many AABBs at once. The trees are traversed by packets of b2_treePacketSize AABBs.
+	/// The callback class is called as QueryCallback(index, proxyId) with the index of the AABB
+	/// in the batch. Returning false stops only the query of that AABB.
+	template <typename T>
+	void QueryBatch(T* callback, const b2AABB* aabbs, int32 count) const;
+
+	/// Ray-cast many rays at once. The trees are traversed by packets of b2_treePacketSize rays.
+	/// The callback class is called as RayCastCallback(index, input, proxyId) with the index of
+	/// the ray in the batch. The return value clips or terminates only that ray, as in RayCast.
+	template <typename T>
+	void RayCastBatch(T* callback, const b2RayCastInput* inputs, int32 count) const;
+
+	/// Get the height of the embedded tree. Zero for the uniform grid.
 	int32 GetTreeHeight() const;
 
-	/// Get the balance of the embedded tree.
+	/// Get the balance of the embedded tree. Zero for the uniform grid.
 	int32 GetTreeBalance() const;
 
-	/// Get the quality metric of the embedded tree.
+	/// Get the quality metric of the embedded tree. Zero for the uniform grid.
 	float GetTreeQuality() const;
 
+	/// Get the height of the static tree.
+	int32 GetStaticTreeHeight() const;
+
 	/// Shift the world origin. Useful for large worlds.
 	/// The shift formula is: position -= newOrigin
 	/// @param newOrigin the new origin with respect to the old origin
@@ -110,13 +247,28 @@ public:
 private:
 
 	friend class b2DynamicTree;
+	friend class b2UniformGrid;
+	template <typename T> friend struct b2BroadPhaseCallback;
+	template <typename T> friend struct b2BroadPhaseBatchCallback;
 
 	void BufferMove(int32 proxyId);
 	void UnBufferMove(int32 proxyId);
 
 	bool QueryCallback(int32 proxyId);
 
+	// The lowest bit of a proxy id tells if the proxy is in the static tree.
+	static bool IsStaticProxy(int32 proxyId);
+	static int32 GetStructureProxy(int32 proxyId);
+
+	b2BroadPhaseType m_type;
 	b2DynamicTree m_tree;
+	b2UniformGrid m_grid;
+
+	b2DynamicTree m_staticTree;
+	int32 m_staticProxyCount;
+
+	// Static proxies created or moved since the static tree was built.
+	int32 m_staticChangeCount;
 
 	int32 m_proxyCount;
 
@@ -131,21 +283,61 @@ private:
 	int32 m_queryProxyId;
 };
 
+inline b2BroadPhaseType b2BroadPhase::GetType() const
+{
+	return m_type;
+}
+
+inline float b2BroadPhase::GetGridCellSize() const
+{
+	return m_grid.GetCellSize();
+}
+
+inline bool b2BroadPhase::IsStaticProxy(int32 proxyId)
+{
+	return (proxyId & 1) != 0;
+}
+
+inline int32 b2BroadPhase::GetStructureProxy(int32 proxyId)
+{
+	return proxyId >> 1;
+}
+
 inline void* b2BroadPhase::GetUserData(int32 proxyId) const
 {
-	return m_tree.GetUserData(proxyId);
+	if (IsStaticProxy(proxyId))
+	{
+		return m_staticTree.GetUserData(GetStructureProxy(proxyId));
+	}
+
+	if (m_type == b2_uniformGridBroadPhase)
+	{
+		return m_grid.GetUserData(GetStructureProxy(proxyId));
+	}
+
+	return m_tree.GetUserData(GetStructureProxy(proxyId));
 }
 
 inline bool b2BroadPhase::TestOverlap(int32 proxyIdA, int32 proxyIdB) const
 {
-	const b2AABB& aabbA = m_tree.GetFatAABB(proxyIdA);
-	const b2AABB& aabbB = m_tree.GetFatAABB(proxyIdB);
+	const b2AABB& aabbA = GetFatAABB(proxyIdA);
+	const b2AABB& aabbB = GetFatAABB(proxyIdB);
 	return b2TestOverlap(aabbA, aabbB);
 }
 
 inline const b2AABB& b2BroadPhase::GetFatAABB(int32 proxyId) const
 {
-	return m_tree.GetFatAABB(proxyId);
+	if (IsStaticProxy(proxyId))
+	{
+		return m_staticTree.GetFatAABB(GetStructureProxy(proxyId));
+	}
+
+	if (m_type == b2_uniformGridBroadPhase)
+	{
+		return m_grid.GetFatAABB(GetStructureProxy(proxyId));
+	}
+
+	return m_tree.GetFatAABB(GetStructureProxy(proxyId));
 }
 
 inline int32 b2BroadPhase::GetProxyCount() const
@@ -155,17 +347,22 @@ inline int32 b2BroadPhase::GetProxyCount() const
 
 inline int32 b2BroadPhase::GetTreeHeight() const
 {
-	return m_tree.GetHeight();
+	return m_type == b2_dynamicTreeBroadPhase ? m_tree.GetHeight() : 0;
 }
 
 inline int32 b2BroadPhase::GetTreeBalance() const
 {
-	return m_tree.GetMaxBalance();
+	return m_type == b2_dynamicTreeBroadPhase ? m_tree.GetMaxBalance() : 0;
 }
 
 inline float b2BroadPhase::GetTreeQuality() const
 {
-	return m_tree.GetAreaRatio();
+	return m_type == b2_dynamicTreeBroadPhase ? m_tree.GetAreaRatio() : 0.0f;
+}
+
+inline int32 b2BroadPhase::GetStaticTreeHeight() const
+{
+	return m_staticTree.GetHeight();
 }
 
 template <typename T>
@@ -174,6 +371,13 @@ void b2BroadPhase::UpdatePairs(T* callback)
 	// Reset pair buffer
 	m_pairCount = 0;
 
+	// Build a good static tree once many static proxies were added, e.g. when a level is loaded.
+	if (4 * m_staticChangeCount > m_staticProxyCount)
+	{
+		m_staticTree.RebuildTopDown();
+		m_staticChangeCount = 0;
+	}
+
 	// Perform tree queries for all moving proxies.
 	for (int32 i = 0; i < m_moveCount; ++i)
 	{
@@ -185,18 +389,34 @@ void b2BroadPhase::UpdatePairs(T* callback)
 
 		// We have to query the tree with the fat AABB so that
 		// we don't fail to create a pair that may touch later.
-		const b2AABB& fatAABB = m_tree.GetFatAABB(m_queryProxyId);
+		const b2AABB& fatAABB = GetFatAABB(m_queryProxyId);
 
 		// Query tree, create pairs and add them pair buffer.
-		m_tree.Query(this, fatAABB);
+		if (IsStaticProxy(m_queryProxyId))
+		{
+			// Static proxies do not form pairs with each other.
+			b2BroadPhaseCallback<b2BroadPhase> wrapper = {this, 0, 0.0f, false};
+			if (m_type == b2_uniformGridBroadPhase)
+			{
+				m_grid.Query(&wrapper, fatAABB);
+			}
+			else
+			{
+				m_tree.Query(&wrapper, fatAABB);
+			}
+		}
+		else
+		{
+			Query(this, fatAABB);
+		}
 	}
 
 	// Send pairs to caller
 	for (int32 i = 0; i < m_pairCount; ++i)
 	{
 		b2Pair* primaryPair = m_pairBuffer + i;
-		void* userDataA = m_tree.GetUserData(primaryPair->proxyIdA);
-		void* userDataB = m_tree.GetUserData(primaryPair->proxyIdB);
+		void* userDataA = GetUserData(primaryPair->proxyIdA);
+		void* userDataB = GetUserData(primaryPair->proxyIdB);
 
 		callback->AddPair(userDataA, userDataB);
 	}
@@ -210,7 +430,18 @@ void b2BroadPhase::UpdatePairs(T* callback)
 			continue;
 		}
 
-		m_tree.ClearMoved(proxyId);
+		if (IsStaticProxy(proxyId))
+		{
+			m_staticTree.ClearMoved(GetStructureProxy(proxyId));
+		}
+		else if (m_type == b2_uniformGridBroadPhase)
+		{
+			m_grid.ClearMoved(GetStructureProxy(proxyId));
+		}
+		else
+		{
+			m_tree.ClearMoved(GetStructureProxy(proxyId));
+		}
 	}
 
 	// Reset move buffer
@@ -220,18 +451,119 @@ void b2BroadPhase::UpdatePairs(T* callback)
 template <typename T>
 inline void b2BroadPhase::Query(T* callback, const b2AABB& aabb) const
 {
-	m_tree.Query(callback, aabb);
+	b2BroadPhaseCallback<T> wrapper = {callback, 1, 0.0f, false};
+	m_staticTree.Query(&wrapper, aabb);
+	if (wrapper.terminated)
+	{
+		return;
+	}
+
+	wrapper.staticBit = 0;
+	if (m_type == b2_uniformGridBroadPhase)
+	{
+		m_grid.Query(&wrapper, aabb);
+	}
+	else
+	{
+		m_tree.Query(&wrapper, aabb);
+	}
 }
 
 template <typename T>
 inline void b2BroadPhase::RayCast(T* callback, const b2RayCastInput& input) const
 {
-	m_tree.RayCast(callback, input);
+	b2BroadPhaseCallback<T> wrapper = {callback, 1, input.maxFraction, false};
+	m_staticTree.RayCast(&wrapper, input);
+	if (wrapper.terminated)
+	{
+		return;
+	}
+
+	// Keep the clipping of the static tree.
+	b2RayCastInput subInput = input;
+	subInput.maxFraction = wrapper.maxFraction;
+
+	wrapper.staticBit = 0;
+	if (m_type == b2_uniformGridBroadPhase)
+	{
+		m_grid.RayCast(&wrapper, subInput);
+	}
+	else
+	{
+		m_tree.RayCast(&wrapper, subInput);
+	}
+}
+
+template <typename T>
+inline void b2BroadPhase::QueryBatch(T* callback, const b2AABB* aabbs, int32 count) const
+{
+	for (int32 base = 0; base < count; base += b2_treePacketSize)
+	{
+		const b2AABB* packet = aabbs + base;
+		int32 packetCount = b2Min(count - base, b2_treePacketSize);
+
+		b2BroadPhaseBatchCallback<T> wrapper = {callback, 1, base, 0, nullptr, 0};
+		m_staticTree.QueryPacket(&wrapper, packet, packetCount);
+
+		wrapper.staticBit = 0;
+		if (m_type == b2_uniformGridBroadPhase)
+		{
+			for (int32 i = 0; i < packetCount; ++i)
+			{
+				if ((wrapper.stopped & (1u << i)) == 0)
+				{
+					wrapper.index = i;
+					m_grid.Query(&wrapper, packet[i]);
+				}
+			}
+		}
+		else
+		{
+			m_tree.QueryPacket(&wrapper, packet, packetCount);
+		}
+	}
+}
+
+template <typename T>
+inline void b2BroadPhase::RayCastBatch(T* callback, const b2RayCastInput* inputs, int32 count) const
+{
+	for (int32 base = 0; base < count; base += b2_treePacketSize)
+	{
+		// The copy keeps the clipping of the static tree.
+		b2RayCastInput packet[b2_treePacketSize];
+		int32 packetCount = b2Min(count - base, b2_treePacketSize);
+		for (int32 i = 0; i < packetCount; ++i)
+		{
+			packet[i] = inputs[base + i];
+		}
+
+		b2BroadPhaseBatchCallback<T> wrapper = {callback, 1, base, 0, packet, 0};
+		m_staticTree.RayCastPacket(&wrapper, packet, packetCount);
+
+		wrapper.staticBit = 0;
+		if (m_type == b2_uniformGridBroadPhase)
+		{
+			for (int32 i = 0; i < packetCount; ++i)
+			{
+				if (packet[i].maxFraction > 0.0f)
+				{
+					wrapper.index = i;
+					m_grid.RayCast(&wrapper, packet[i]);
+				}
+			}
+		}
+		else
+		{
+			m_tree.RayCastPacket(&wrapper, packet, packetCount);
+		}
+	}
 }
 
 inline void b2BroadPhase::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	m_tree.ShiftOrigin(newOrigin);
+	m_grid.ShiftOrigin(newOrigin);
+	m_staticTree.ShiftOrigin(newOrigin);
 }
 
 #endif
@@ -60,6 +60,16 @@
 /// This is a dimensionless multiplier.
 #define b2_aabbMultiplier		4.0f
 
+/// The default cell size of the uniform grid broad-phase. The grid works best when
+/// cells are about twice as large as a typical fat AABB, so most proxies are in one
+/// or two cells. The default fits objects of about 1 meter, their fat AABB is 1.2 m.
+/// This is in meters.
+#define b2_gridCellSize			(2.0f * b2_lengthUnitsPerMeter)
+
+/// Proxies of the uniform grid that span more cells than this are not stored in the
+/// cells. They are kept in a list that is tested by every query.
+#define b2_gridMaxProxyCells	64
+
 /// A small length used as a collision and constraint tolerance. Usually it is
 /// chosen to be numerically significant, but visually insignificant. In meters.
 #define b2_linearSlop			(0.005f * b2_lengthUnitsPerMeter)
@@ -35,6 +35,7 @@ class b2World;
 class b2BlockAllocator;
 class b2StackAllocator;
 class b2ContactListener;
+struct b2ContactEvents;
 
 /// Friction mixing law. The idea is to allow either fixture to drive the friction to zero.
 /// For example, anything slides on ice.
@@ -150,6 +151,8 @@ public:
 
 protected:
 	friend class b2ContactManager;
+	friend class b2UpdateManifoldsTask;
+	friend class b2TOITask;
 	friend class b2World;
 	friend class b2ContactSolver;
 	friend class b2Body;
@@ -191,7 +194,18 @@ protected:
 	b2Contact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
 	virtual ~b2Contact() {}
 
-	void Update(b2ContactListener* listener);
+	void Update(b2ContactListener* listener, b2ContactEvents* events);
+
+	// Update is split in two parts for the parallel narrow phase. UpdateManifold
+	// changes only this contact, it keeps the old manifold for the listener and returns
+	// whether the contact is touching. UpdateTouching wakes the bodies, calls the listener
+	// and records the events, events are nullptr when they are disabled.
+	bool UpdateManifold(b2Manifold* oldManifold);
+	void UpdateTouching(const b2Manifold& oldManifold, bool touching, b2ContactListener* listener, b2ContactEvents* events);
+
+	void AddBeginEvent(b2ContactEvents* events);
+	void AddEndEvent(b2ContactEvents* events);
+	void AddHitEvent(b2ContactEvents* events);
 
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 	static bool s_initialized;
@@ -28,7 +28,10 @@
 class b2Contact;
 class b2ContactFilter;
 class b2ContactListener;
+struct b2ContactEvents;
 class b2BlockAllocator;
+class b2StackAllocator;
+class b2TaskScheduler;
 
 // Delegate of b2World.
 class b2ContactManager
@@ -50,7 +53,13 @@ public:
 	int32 m_contactCount;
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
+	// Set by b2World only during the step when contact events are enabled.
+	b2ContactEvents* m_contactEvents;
 	b2BlockAllocator* m_allocator;
+
+	// Manifolds are evaluated in parallel when the world has a task scheduler.
+	b2StackAllocator* m_stackAllocator;
+	b2TaskScheduler* m_taskScheduler;
 };
 
 #endif
@@ -56,6 +56,34 @@ struct b2TreeNode
 	bool moved;
 };
 
+/// The number of queries or rays that traverse the tree together.
+#define b2_treePacketSize 32
+
+/// Queries or rays that traverse the tree together, in structure of arrays layout so that
+/// a node is tested against several of them at once. The client does not interact with this directly.
+struct b2TreePacket
+{
+	/// The query AABBs or the bounding boxes of the clipped segments.
+	float lowerX[b2_treePacketSize];
+	float lowerY[b2_treePacketSize];
+	float upperX[b2_treePacketSize];
+	float upperY[b2_treePacketSize];
+
+	/// Segment start and the unit normal of the segment, for the separating axis test.
+	float p1X[b2_treePacketSize];
+	float p1Y[b2_treePacketSize];
+	float normalX[b2_treePacketSize];
+	float normalY[b2_treePacketSize];
+};
+
+/// Test the AABB against the query AABBs of the packet selected by the mask.
+/// @return the mask of the overlapping queries
+uint32 b2TestOverlap(const b2AABB& a, const b2TreePacket& packet, uint32 mask);
+
+/// Test the AABB against the segments of the packet selected by the mask.
+/// @return the mask of the segments which may hit the AABB
+uint32 b2TestSegmentOverlap(const b2AABB& a, const b2TreePacket& packet, uint32 mask);
+
 /// A dynamic AABB tree broad-phase, inspired by Nathanael Presson's btDbvt.
 /// A dynamic tree arranges data in a binary tree to accelerate
 /// queries such as volume queries and ray casts. Leafs are proxies
@@ -110,6 +138,18 @@ public:
 	template <typename T>
 	void RayCast(T* callback, const b2RayCastInput& input) const;
 
+	/// Query up to b2_treePacketSize AABBs in one traversal. The callback class is called
+	/// with the index of the AABB for each proxy that overlaps it. Returning false from the
+	/// callback stops only the query of that AABB.
+	template <typename T>
+	void QueryPacket(T* callback, const b2AABB* aabbs, int32 count) const;
+
+	/// Ray-cast up to b2_treePacketSize rays in one traversal. The callback class is called
+	/// with the index of the ray for each proxy that may be hit by it. The return value
+	/// clips or terminates only that ray, as in RayCast.
+	template <typename T>
+	void RayCastPacket(T* callback, const b2RayCastInput* inputs, int32 count) const;
+
 	/// Validate this tree. For testing.
 	void Validate() const;
 
@@ -127,6 +167,10 @@ public:
 	/// Build an optimal tree. Very expensive. For testing.
 	void RebuildBottomUp();
 
+	/// Build the tree top-down with a binned surface area heuristic in O(n log n) time.
+	/// This gives better trees than incremental insertion, e.g. after bulk loading.
+	void RebuildTopDown();
+
 	/// Shift the world origin. Useful for large worlds.
 	/// The shift formula is: position -= newOrigin
 	/// @param newOrigin the new origin with respect to the old origin
@@ -142,9 +186,19 @@ private:
 
 	int32 Balance(int32 index);
 
+	int32 BuildTopDown(int32* leaves, int32 count);
+	int32 PartitionLeaves(int32* leaves, int32 count) const;
+
 	int32 ComputeHeight() const;
 	int32 ComputeHeight(int32 nodeId) const;
 
+	// A node to visit and the packet members which overlapped its parent.
+	struct PacketEntry
+	{
+		int32 nodeId;
+		uint32 mask;
+	};
+
 	void ValidateStructure(int32 index) const;
 	void ValidateMetrics(int32 index) const;
 
@@ -304,4 +358,185 @@ inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) con
 	}
 }
 
+inline void b2SetPacketSegment(b2TreePacket* packet, int32 index, const b2RayCastInput& input, float maxFraction)
+{
+	b2Vec2 t = input.p1 + maxFraction * (input.p2 - input.p1);
+	packet->lowerX[index] = b2Min(input.p1.x, t.x);
+	packet->lowerY[index] = b2Min(input.p1.y, t.y);
+	packet->upperX[index] = b2Max(input.p1.x, t.x);
+	packet->upperY[index] = b2Max(input.p1.y, t.y);
+}
+
+template <typename T>
+inline void b2DynamicTree::QueryPacket(T* callback, const b2AABB* aabbs, int32 count) const
+{
+	b2Assert(0 < count && count <= b2_treePacketSize);
+
+	b2TreePacket packet;
+	for (int32 i = 0; i < b2_treePacketSize; ++i)
+	{
+		// Unused lanes are never reported, they only have to hold valid numbers.
+		const b2AABB& aabb = aabbs[i < count ? i : 0];
+		packet.lowerX[i] = aabb.lowerBound.x;
+		packet.lowerY[i] = aabb.lowerBound.y;
+		packet.upperX[i] = aabb.upperBound.x;
+		packet.upperY[i] = aabb.upperBound.y;
+	}
+
+	uint32 active = count == b2_treePacketSize ? 0xFFFFFFFF : (1u << count) - 1;
+
+	b2GrowableStack<PacketEntry, 256> stack;
+	stack.Push({m_root, active});
+
+	while (stack.GetCount() > 0)
+	{
+		PacketEntry entry = stack.Pop();
+		if (entry.nodeId == b2_nullNode)
+		{
+			continue;
+		}
+
+		// Queries stopped by the callback since the entry was pushed are dropped here.
+		uint32 mask = entry.mask & active;
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		const b2TreeNode* node = m_nodes + entry.nodeId;
+
+		mask = b2TestOverlap(node->aabb, packet, mask);
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		if (node->IsLeaf())
+		{
+			for (int32 i = 0; mask != 0; ++i, mask >>= 1)
+			{
+				if ((mask & 1) == 0)
+				{
+					continue;
+				}
+
+				bool proceed = callback->QueryCallback(i, entry.nodeId);
+				if (proceed == false)
+				{
+					active &= ~(1u << i);
+				}
+			}
+
+			if (active == 0)
+			{
+				return;
+			}
+		}
+		else
+		{
+			stack.Push({node->child1, mask});
+			stack.Push({node->child2, mask});
+		}
+	}
+}
+
+template <typename T>
+inline void b2DynamicTree::RayCastPacket(T* callback, const b2RayCastInput* inputs, int32 count) const
+{
+	b2Assert(0 < count && count <= b2_treePacketSize);
+
+	b2TreePacket packet;
+	float maxFractions[b2_treePacketSize];
+	uint32 active = 0;
+	for (int32 i = 0; i < b2_treePacketSize; ++i)
+	{
+		const b2RayCastInput& input = inputs[i < count ? i : 0];
+		b2Vec2 r = input.p2 - input.p1;
+		b2Assert(r.LengthSquared() > 0.0f || input.maxFraction <= 0.0f);
+		r.Normalize();
+
+		// v is perpendicular to the segment.
+		b2Vec2 v = b2Cross(1.0f, r);
+		packet.p1X[i] = input.p1.x;
+		packet.p1Y[i] = input.p1.y;
+		packet.normalX[i] = v.x;
+		packet.normalY[i] = v.y;
+
+		maxFractions[i] = input.maxFraction;
+		b2SetPacketSegment(&packet, i, input, input.maxFraction);
+
+		if (i < count && input.maxFraction > 0.0f)
+		{
+			active |= 1u << i;
+		}
+	}
+
+	b2GrowableStack<PacketEntry, 256> stack;
+	stack.Push({m_root, active});
+
+	while (stack.GetCount() > 0)
+	{
+		PacketEntry entry = stack.Pop();
+		if (entry.nodeId == b2_nullNode)
+		{
+			continue;
+		}
+
+		uint32 mask = entry.mask & active;
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		const b2TreeNode* node = m_nodes + entry.nodeId;
+
+		// The segment bounds shrink as the rays are clipped.
+		mask = b2TestSegmentOverlap(node->aabb, packet, mask);
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		if (node->IsLeaf())
+		{
+			for (int32 i = 0; mask != 0; ++i, mask >>= 1)
+			{
+				if ((mask & 1) == 0)
+				{
+					continue;
+				}
+
+				b2RayCastInput subInput;
+				subInput.p1 = inputs[i].p1;
+				subInput.p2 = inputs[i].p2;
+				subInput.maxFraction = maxFractions[i];
+
+				float value = callback->RayCastCallback(i, subInput, entry.nodeId);
+
+				if (value == 0.0f)
+				{
+					// The client has terminated this ray.
+					active &= ~(1u << i);
+				}
+				else if (value > 0.0f)
+				{
+					// Update segment bounding box.
+					maxFractions[i] = value;
+					b2SetPacketSegment(&packet, i, subInput, value);
+				}
+			}
+
+			if (active == 0)
+			{
+				return;
+			}
+		}
+		else
+		{
+			stack.Push({node->child1, mask});
+			stack.Push({node->child2, mask});
+		}
+	}
+}
+
 #endif
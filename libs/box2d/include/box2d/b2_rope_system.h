@@ -0,0 +1,125 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2_ROPE_SYSTEM_H
+#define B2_ROPE_SYSTEM_H
+
+#include "b2_rope.h"
+
+class b2TaskScheduler;
+struct b2RopeRange;
+
+/// Many ropes stepped together, e.g. hundreds of cables of a scene. Same models as b2Rope,
+/// but particles and constraints of all ropes are kept in arrays of floats. Stretch constraints
+/// are solved in red/black order (first the even ones, then the odd ones), so four constraints
+/// of a rope share no particle and are solved at once. Ropes are independent and are distributed
+/// over the threads of the task scheduler.
+class b2RopeSystem
+{
+public:
+	b2RopeSystem();
+	~b2RopeSystem();
+
+	/// Add a rope, returns its index. The definition is copied.
+	int32 CreateRope(const b2RopeDef& def);
+
+	/// Remove all ropes, keeps the memory.
+	void Clear();
+
+	int32 GetRopeCount() const { return m_ropeCount; }
+
+	///
+	void SetTuning(int32 ropeIndex, const b2RopeTuning& tuning);
+
+	/// Particles without mass follow this position, see b2Rope::Step.
+	void SetPosition(int32 ropeIndex, const b2Vec2& position);
+
+	/// Same as b2Rope::Reset.
+	void Reset(int32 ropeIndex, const b2Vec2& position);
+
+	int32 GetVertexCount(int32 ropeIndex) const;
+	b2Vec2 GetVertex(int32 ropeIndex, int32 vertexIndex) const;
+
+	/// Ropes are stepped on the calling thread by default. The scheduler is owned by you and must remain
+	/// in scope. Results don't depend on the number of threads.
+	void SetTaskScheduler(b2TaskScheduler* scheduler) { m_taskScheduler = scheduler; }
+
+	/// Step all ropes.
+	void Step(float timeStep, int32 iterations);
+
+	///
+	void Draw(b2Draw* draw) const;
+
+private:
+
+	friend class b2RopeSystemTask;
+
+	void Grow(int32 particleCapacity);
+	void StepRope(b2RopeRange* rope, float dt, int32 iterations);
+
+	void SolveStretch_PBD(const b2RopeRange* rope);
+	void SolveStretch_XPBD(const b2RopeRange* rope, float dt);
+	void SolveBend_PBD_Angle(const b2RopeRange* rope);
+	void SolveBend_XPBD_Angle(const b2RopeRange* rope, float dt);
+	void SolveBend_PBD_Distance(const b2RopeRange* rope);
+	void SolveBend_PBD_Height(const b2RopeRange* rope);
+	void ApplyBendForces(const b2RopeRange* rope, float dt);
+
+	b2RopeRange* m_ropes;
+	int32 m_ropeCount;
+	int32 m_ropeCapacity;
+
+	// Particles of a rope are consecutive, the even ones first, then the odd ones. Stretch constraint
+	// i connects particles i and i + 1 and is stored in the slot of particle i, so constraints of one
+	// color and their particles are contiguous. Bend constraint i connects particles i, i + 1 and
+	// i + 2 and is stored in order.
+	int32 m_particleCount;
+	int32 m_particleCapacity;
+
+	float* m_pxs;
+	float* m_pys;
+	float* m_p0xs;
+	float* m_p0ys;
+	float* m_vxs;
+	float* m_vys;
+	float* m_bindXs;
+	float* m_bindYs;
+	float* m_invMasses;
+
+	float* m_stretchLs;
+	float* m_stretchLambdas;
+	float* m_stretchSprings;
+	float* m_stretchDampers;
+
+	float* m_bendL1s;
+	float* m_bendL2s;
+	float* m_bendAlpha1s;
+	float* m_bendAlpha2s;
+	float* m_bendInvEffectiveMasses;
+	float* m_bendLambdas;
+	float* m_bendSprings;
+	float* m_bendDampers;
+
+	b2TaskScheduler* m_taskScheduler;
+};
+
+#endif
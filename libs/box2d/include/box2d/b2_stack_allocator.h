@@ -25,8 +25,9 @@
 
 #include "b2_settings.h"
 
-const int32 b2_stackSize = 100 * 1024;	// 100k
+const int32 b2_stackSize = 100 * 1024;	// 100k, initial size
 const int32 b2_maxStackEntries = 32;
+const int32 b2_stackAlignment = 16;
 
 struct b2StackEntry
 {
@@ -38,6 +39,9 @@ struct b2StackEntry
 // This is a stack allocator used for fast per step allocations.
 // You must nest allocate/free pairs. The code will assert
 // if you try to interleave multiple allocate/free pairs.
+// The stack grows between steps: an allocation that does not fit falls
+// back to b2Alloc and Reset makes the stack big enough for the peak of
+// the step, so repeated steps of a world do not touch the heap.
 class b2StackAllocator
 {
 public:
@@ -47,18 +51,53 @@ public:
 	void* Allocate(int32 size);
 	void Free(void* p);
 
+	// Call when nothing is allocated, e.g. at the end of a step.
+	// Grows the stack to the peak allocation since the last reset.
+	void Reset();
+
 	int32 GetMaxAllocation() const;
 
+	// Peak allocation since the last reset.
+	int32 GetPeakAllocation() const;
+
+	// Allocations that did not fit into the stack since the last reset.
+	int32 GetMallocCount() const;
+
+	int32 GetCapacity() const;
+
 private:
 
-	char m_data[b2_stackSize];
+	char* m_data;
+	int32 m_capacity;
 	int32 m_index;
 
 	int32 m_allocation;
 	int32 m_maxAllocation;
+	int32 m_peakAllocation;
+	int32 m_mallocCount;
 
 	b2StackEntry m_entries[b2_maxStackEntries];
 	int32 m_entryCount;
 };
 
+inline int32 b2StackAllocator::GetMaxAllocation() const
+{
+	return m_maxAllocation;
+}
+
+inline int32 b2StackAllocator::GetPeakAllocation() const
+{
+	return m_peakAllocation;
+}
+
+inline int32 b2StackAllocator::GetMallocCount() const
+{
+	return m_mallocCount;
+}
+
+inline int32 b2StackAllocator::GetCapacity() const
+{
+	return m_capacity;
+}
+
 #endif
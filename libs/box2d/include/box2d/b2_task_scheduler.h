@@ -0,0 +1,80 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2_TASK_SCHEDULER_H
+#define B2_TASK_SCHEDULER_H
+
+#include "b2_settings.h"
+
+/// A parallel loop body. Implemented by Box2D for work that is split over threads.
+class b2Task
+{
+public:
+	virtual ~b2Task() {}
+
+	/// Process items [begin, end). threadIndex identifies the calling thread
+	/// in [0, b2TaskScheduler::GetThreadCount()), no two threads use the same index
+	/// at the same time. Use it to select per thread scratch data.
+	virtual void Execute(int32 begin, int32 end, int32 threadIndex) = 0;
+};
+
+/// Implement this interface to run the parallel parts of b2World::Step on your own
+/// job system. The scheduler is owned by you and must remain in scope.
+/// @see b2World::SetTaskScheduler
+class b2TaskScheduler
+{
+public:
+	virtual ~b2TaskScheduler() {}
+
+	/// Number of threads which may call b2Task::Execute, including the calling thread.
+	virtual int32 GetThreadCount() const = 0;
+
+	/// Call task->Execute for ranges which cover [0, count) exactly once and return
+	/// when all of them are done. Ranges should have at least minRange items.
+	/// The calling thread must participate with thread index 0.
+	virtual void ParallelFor(b2Task* task, int32 count, int32 minRange) = 0;
+};
+
+struct b2ThreadPool;
+
+/// Default scheduler. Work is split into ranges which are distributed evenly over the threads.
+/// A thread which runs out of work steals ranges from the end of the other threads' work.
+/// Worker threads sleep between calls of ParallelFor.
+class b2ThreadPoolScheduler : public b2TaskScheduler
+{
+public:
+	/// @param threadCount number of threads including the calling thread, 1 runs
+	/// everything on the calling thread.
+	b2ThreadPoolScheduler(int32 threadCount);
+	~b2ThreadPoolScheduler();
+
+	int32 GetThreadCount() const override;
+
+	void ParallelFor(b2Task* task, int32 count, int32 minRange) override;
+
+private:
+
+	b2ThreadPool* m_pool;
+	int32 m_threadCount;
+};
+
+#endif
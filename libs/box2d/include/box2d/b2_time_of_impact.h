@@ -50,6 +50,8 @@ struct b2TOIOutput
 
 	State state;
 	float t;
+	int32 iterations;		///< number of separating axis iterations
+	int32 rootIterations;	///< number of root finder iterations of all axes
 };
 
 /// Compute the upper bound on time before two shapes penetrate. Time is represented as
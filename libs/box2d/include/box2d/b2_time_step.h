@@ -35,6 +35,23 @@ struct b2Profile
 	float solvePosition;
 	float broadphase;
 	float solveTOI;
+
+	// Continuous collision, for budgeting bullets.
+	int32 toiRounds;		// rounds of independent TOI events
+	int32 toiEvents;		// TOI events solved
+	int32 toiCalls;			// b2TimeOfImpact calls
+	int32 toiIterations;	// separating axis iterations of the calls
+	int32 toiRootIterations;	// root finder iterations of the calls
+
+	// Per step temporaries of all threads, see b2StackAllocator.
+	int32 stackPeak;		// bytes at the peak of the step
+	int32 stackMallocCount;	// allocations that did not fit into the stacks
+
+	// Sleeping, counted at the end of each step.
+	int32 awakeBodies;		// dynamic and kinematic bodies
+	int32 sleepingBodies;
+	int32 awakeIslands;		// islands solved in the step, 0 if nothing was solved
+	int32 asleepIslands;	// islands that fell asleep in the step
 };
 
 /// This is an internal structure.
@@ -46,6 +63,8 @@ struct b2TimeStep
 	int32 velocityIterations;
 	int32 positionIterations;
 	bool warmStarting;
+	bool wideSolving;	// pack contacts into SIMD lanes, see b2World::SetWideSolving
+	float timeToSleep;	// see b2World::SetTimeToSleep
 };
 
 /// This is an internal structure.
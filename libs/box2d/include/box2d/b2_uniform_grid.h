@@ -0,0 +1,448 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2_UNIFORM_GRID_H
+#define B2_UNIFORM_GRID_H
+
+#include "b2_collision.h"
+
+#define b2_nullGridProxy (-1)
+
+/// A proxy in the uniform grid. The client does not interact with this directly.
+struct b2GridProxy
+{
+	/// Enlarged AABB
+	b2AABB aabb;
+
+	void* userData;
+
+	// Range of covered cells.
+	int32 lowerX, lowerY;
+	int32 upperX, upperY;
+
+	union
+	{
+		// Index in the oversized list or b2_nullGridProxy if the proxy is stored in the cells.
+		int32 oversized;
+		int32 next;
+	};
+
+	bool allocated;
+	bool moved;
+};
+
+/// Proxies stored in the cells that hash to one bucket.
+struct b2GridBucket
+{
+	int32* proxies;
+	int32 count;
+	int32 capacity;
+};
+
+/// A uniform grid broad-phase. Space is divided into square cells and each proxy is stored in
+/// all cells overlapped by its fat AABB. Cells are not allocated, they are hashed into a table
+/// of buckets, so the grid is unbounded. Insertion and removal do not restructure anything,
+/// which makes the grid a good fit for many similarly sized and densely packed objects.
+/// Proxies covering more than b2_gridMaxProxyCells cells are kept in a separate list.
+///
+/// Like b2DynamicTree, proxies are pooled and relocatable, so we use proxy indices rather than pointers.
+class b2UniformGrid
+{
+public:
+	/// Constructing the grid initializes the proxy pool and the buckets.
+	b2UniformGrid();
+
+	/// Destroy the grid, freeing the proxy pool and the buckets.
+	~b2UniformGrid();
+
+	/// Set the cell size. Existing proxies are re-inserted.
+	void SetCellSize(float cellSize);
+
+	/// Get the cell size.
+	float GetCellSize() const;
+
+	/// Create a proxy. Provide a tight fitting AABB and a userData pointer.
+	int32 CreateProxy(const b2AABB& aabb, void* userData);
+
+	/// Destroy a proxy. This asserts if the id is invalid.
+	void DestroyProxy(int32 proxyId);
+
+	/// Move a proxy with a swepted AABB. If the proxy has moved outside of its fattened AABB,
+	/// then the proxy is removed from its cells and re-inserted. Otherwise
+	/// the function returns immediately.
+	/// @return true if the proxy was re-inserted.
+	bool MoveProxy(int32 proxyId, const b2AABB& aabb1, const b2Vec2& displacement);
+
+	/// Get proxy user data.
+	void* GetUserData(int32 proxyId) const;
+
+	bool WasMoved(int32 proxyId) const;
+	void ClearMoved(int32 proxyId);
+
+	/// Get the fat AABB for a proxy.
+	const b2AABB& GetFatAABB(int32 proxyId) const;
+
+	/// Query an AABB for overlapping proxies. The callback class
+	/// is called once for each proxy that overlaps the supplied AABB.
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb) const;
+
+	/// Ray-cast against the proxies in the grid. This relies on the callback
+	/// to perform a exact ray-cast in the case were the proxy contains a shape.
+	/// The callback also performs the any collision filtering. Cells are visited
+	/// along the ray, so the ray cast stops early once the callback clips the ray.
+	/// @param input the ray-cast input data. The ray extends from p1 to p1 + maxFraction * (p2 - p1).
+	/// @param callback a callback class that is called for each proxy that is hit by the ray.
+	template <typename T>
+	void RayCast(T* callback, const b2RayCastInput& input) const;
+
+	/// Validate the grid. For testing.
+	void Validate() const;
+
+	/// Shift the world origin. Useful for large worlds.
+	/// The shift formula is: position -= newOrigin
+	/// @param newOrigin the new origin with respect to the old origin
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
+private:
+
+	int32 AllocateProxy();
+	void FreeProxy(int32 proxyId);
+
+	void InsertProxy(int32 proxyId);
+	void RemoveProxy(int32 proxyId);
+
+	void Rebuild(int32 bucketCount);
+
+	int32 GetCell(float x) const;
+	int32 GetBucket(int32 x, int32 y) const;
+
+	b2GridProxy* m_proxies;
+	int32 m_proxyCount;
+	int32 m_proxyCapacity;
+
+	int32 m_freeList;
+
+	// Power of two.
+	b2GridBucket* m_buckets;
+	int32 m_bucketCount;
+
+	int32* m_oversized;
+	int32 m_oversizedCount;
+	int32 m_oversizedCapacity;
+
+	float m_cellSize;
+	float m_inverseCellSize;
+};
+
+inline float b2UniformGrid::GetCellSize() const
+{
+	return m_cellSize;
+}
+
+inline void* b2UniformGrid::GetUserData(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].userData;
+}
+
+inline bool b2UniformGrid::WasMoved(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].moved;
+}
+
+inline void b2UniformGrid::ClearMoved(int32 proxyId)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	m_proxies[proxyId].moved = false;
+}
+
+inline const b2AABB& b2UniformGrid::GetFatAABB(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].aabb;
+}
+
+inline int32 b2UniformGrid::GetCell(float x) const
+{
+	// Clamped so that the number of cells of any range fits into int32.
+	float cell = b2Clamp(floorf(x * m_inverseCellSize), -536870912.0f, 536870912.0f);
+	return int32(cell);
+}
+
+inline int32 b2UniformGrid::GetBucket(int32 x, int32 y) const
+{
+	uint32 hash = (uint32(x) * 73856093u) ^ (uint32(y) * 19349663u);
+	return int32(hash & uint32(m_bucketCount - 1));
+}
+
+template <typename T>
+inline void b2UniformGrid::Query(T* callback, const b2AABB& aabb) const
+{
+	for (int32 i = 0; i < m_oversizedCount; ++i)
+	{
+		int32 proxyId = m_oversized[i];
+		if (b2TestOverlap(m_proxies[proxyId].aabb, aabb))
+		{
+			bool proceed = callback->QueryCallback(proxyId);
+			if (proceed == false)
+			{
+				return;
+			}
+		}
+	}
+
+	int32 lowerX = GetCell(aabb.lowerBound.x);
+	int32 lowerY = GetCell(aabb.lowerBound.y);
+	int32 upperX = GetCell(aabb.upperBound.x);
+	int32 upperY = GetCell(aabb.upperBound.y);
+
+	// Visiting the cells of a large query is more expensive than testing every proxy.
+	float cellCount = float(upperX - lowerX + 1) * float(upperY - lowerY + 1);
+	if (cellCount > float(m_proxyCount))
+	{
+		for (int32 proxyId = 0; proxyId < m_proxyCapacity; ++proxyId)
+		{
+			const b2GridProxy* proxy = m_proxies + proxyId;
+			if (proxy->allocated == false || proxy->oversized != b2_nullGridProxy)
+			{
+				continue;
+			}
+
+			if (b2TestOverlap(proxy->aabb, aabb))
+			{
+				bool proceed = callback->QueryCallback(proxyId);
+				if (proceed == false)
+				{
+					return;
+				}
+			}
+		}
+
+		return;
+	}
+
+	for (int32 y = lowerY; y <= upperY; ++y)
+	{
+		for (int32 x = lowerX; x <= upperX; ++x)
+		{
+			const b2GridBucket* bucket = m_buckets + GetBucket(x, y);
+			for (int32 i = 0; i < bucket->count; ++i)
+			{
+				int32 proxyId = bucket->proxies[i];
+				const b2GridProxy* proxy = m_proxies + proxyId;
+
+				// A proxy shares several cells with the query. Report it only in the first one.
+				// This also skips proxies of other cells hashed to the same bucket.
+				if (b2Max(proxy->lowerX, lowerX) != x || b2Max(proxy->lowerY, lowerY) != y)
+				{
+					continue;
+				}
+
+				if (b2TestOverlap(proxy->aabb, aabb))
+				{
+					bool proceed = callback->QueryCallback(proxyId);
+					if (proceed == false)
+					{
+						return;
+					}
+				}
+			}
+		}
+	}
+}
+
+template <typename T>
+inline void b2UniformGrid::RayCast(T* callback, const b2RayCastInput& input) const
+{
+	b2Vec2 p1 = input.p1;
+	b2Vec2 p2 = input.p2;
+	b2Vec2 d = p2 - p1;
+	b2Assert(d.LengthSquared() > 0.0f);
+	b2Vec2 r = d;
+	r.Normalize();
+
+	// v is perpendicular to the segment.
+	b2Vec2 v = b2Cross(1.0f, r);
+	b2Vec2 abs_v = b2Abs(v);
+
+	float maxFraction = input.maxFraction;
+
+	// Build a bounding box for the segment.
+	b2AABB segmentAABB;
+	{
+		b2Vec2 t = p1 + maxFraction * d;
+		segmentAABB.lowerBound = b2Min(p1, t);
+		segmentAABB.upperBound = b2Max(p1, t);
+	}
+
+	// Walk the cells along the ray (Amanatides, Woo). The oversized proxies are tested first.
+	int32 x = GetCell(p1.x);
+	int32 y = GetCell(p1.y);
+	int32 stepX = d.x > 0.0f ? 1 : -1;
+	int32 stepY = d.y > 0.0f ? 1 : -1;
+
+	// The fraction at which the ray crosses the next cell boundary and the fraction
+	// needed to cross a whole cell.
+	float nextX = FLT_MAX, deltaX = FLT_MAX;
+	if (d.x != 0.0f)
+	{
+		float boundary = float(d.x > 0.0f ? x + 1 : x) * m_cellSize;
+		nextX = (boundary - p1.x) / d.x;
+		deltaX = m_cellSize / b2Abs(d.x);
+	}
+
+	float nextY = FLT_MAX, deltaY = FLT_MAX;
+	if (d.y != 0.0f)
+	{
+		float boundary = float(d.y > 0.0f ? y + 1 : y) * m_cellSize;
+		nextY = (boundary - p1.y) / d.y;
+		deltaY = m_cellSize / b2Abs(d.y);
+	}
+
+	for (int32 i = 0; i < m_oversizedCount; ++i)
+	{
+		int32 proxyId = m_oversized[i];
+		const b2GridProxy* proxy = m_proxies + proxyId;
+		if (b2TestOverlap(proxy->aabb, segmentAABB) == false)
+		{
+			continue;
+		}
+
+		// Separating axis for segment (Gino, p80).
+		// |dot(v, p1 - c)| > dot(|v|, h)
+		b2Vec2 c = proxy->aabb.GetCenter();
+		b2Vec2 h = proxy->aabb.GetExtents();
+		float separation = b2Abs(b2Dot(v, p1 - c)) - b2Dot(abs_v, h);
+		if (separation > 0.0f)
+		{
+			continue;
+		}
+
+		b2RayCastInput subInput;
+		subInput.p1 = input.p1;
+		subInput.p2 = input.p2;
+		subInput.maxFraction = maxFraction;
+
+		float value = callback->RayCastCallback(subInput, proxyId);
+
+		if (value == 0.0f)
+		{
+			// The client has terminated the ray cast.
+			return;
+		}
+
+		if (value > 0.0f)
+		{
+			// Update segment bounding box.
+			maxFraction = value;
+			b2Vec2 t = p1 + maxFraction * d;
+			segmentAABB.lowerBound = b2Min(p1, t);
+			segmentAABB.upperBound = b2Max(p1, t);
+		}
+	}
+
+	int32 previousX = x, previousY = y;
+	bool firstCell = true;
+
+	for (;;)
+	{
+		const b2GridBucket* bucket = m_buckets + GetBucket(x, y);
+		for (int32 i = 0; i < bucket->count; ++i)
+		{
+			int32 proxyId = bucket->proxies[i];
+			const b2GridProxy* proxy = m_proxies + proxyId;
+
+			// Skip proxies of other cells hashed to the same bucket.
+			if (x < proxy->lowerX || proxy->upperX < x || y < proxy->lowerY || proxy->upperY < y)
+			{
+				continue;
+			}
+
+			// The cells along the ray form a monotone path, so the path enters the cells of a proxy
+			// only once. Report the proxy when the previous cell was not one of its cells.
+			if (firstCell == false &&
+				proxy->lowerX <= previousX && previousX <= proxy->upperX &&
+				proxy->lowerY <= previousY && previousY <= proxy->upperY)
+			{
+				continue;
+			}
+
+			if (b2TestOverlap(proxy->aabb, segmentAABB) == false)
+			{
+				continue;
+			}
+
+			b2Vec2 c = proxy->aabb.GetCenter();
+			b2Vec2 h = proxy->aabb.GetExtents();
+			float separation = b2Abs(b2Dot(v, p1 - c)) - b2Dot(abs_v, h);
+			if (separation > 0.0f)
+			{
+				continue;
+			}
+
+			b2RayCastInput subInput;
+			subInput.p1 = input.p1;
+			subInput.p2 = input.p2;
+			subInput.maxFraction = maxFraction;
+
+			float value = callback->RayCastCallback(subInput, proxyId);
+
+			if (value == 0.0f)
+			{
+				return;
+			}
+
+			if (value > 0.0f)
+			{
+				maxFraction = value;
+				b2Vec2 t = p1 + maxFraction * d;
+				segmentAABB.lowerBound = b2Min(p1, t);
+				segmentAABB.upperBound = b2Max(p1, t);
+			}
+		}
+
+		if (nextX > maxFraction && nextY > maxFraction)
+		{
+			// The rest of the ray was clipped.
+			break;
+		}
+
+		previousX = x;
+		previousY = y;
+		firstCell = false;
+
+		if (nextX < nextY)
+		{
+			x += stepX;
+			nextX += deltaX;
+		}
+		else
+		{
+			y += stepY;
+			nextY += deltaY;
+		}
+	}
+}
+
+#endif
@@ -37,7 +37,92 @@ struct b2JointDef;
 class b2Body;
 class b2Draw;
 class b2Fixture;
+class b2Island;
 class b2Joint;
+class b2TaskScheduler;
+
+/// A fixture found by a query of QueryAABBBatch.
+struct b2QueryHit
+{
+	/// Index of the AABB in the batch.
+	int32 index;
+	b2Fixture* fixture;
+	/// Child of the fixture shape, e.g. edge of a chain.
+	int32 childIndex;
+};
+
+/// The closest fixture hit by a ray of RayCastClosest.
+struct b2RayCastHit
+{
+	/// nullptr if the ray hit nothing.
+	b2Fixture* fixture;
+	b2Vec2 point;
+	b2Vec2 normal;
+	float fraction;
+};
+
+/// Two fixtures started or stopped touching, see b2ContactEvents.
+struct b2ContactTouchEvent
+{
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+};
+
+/// Two fixtures started touching with approach speed over the hit event threshold.
+struct b2ContactHitEvent
+{
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	/// World point of the fastest approaching manifold point.
+	b2Vec2 point;
+	/// World normal, from A to B.
+	b2Vec2 normal;
+	/// Relative velocity of the bodies along the normal at the point, positive.
+	float approachSpeed;
+};
+
+/// Contact events of the last time step in contiguous arrays, see b2World::SetContactEvents.
+/// They are recorded without callbacks, in the same order as the listener gets them, and
+/// they are read after the step. Sensor contacts have touch events, but no hit events.
+/// Contacts destroyed together with their fixture or body outside of the step have
+/// no end event.
+struct b2ContactEvents
+{
+	b2ContactTouchEvent* beginEvents;
+	int32 beginCount;
+	int32 beginCapacity;
+
+	b2ContactTouchEvent* endEvents;
+	int32 endCount;
+	int32 endCapacity;
+
+	b2ContactHitEvent* hitEvents;
+	int32 hitCount;
+	int32 hitCapacity;
+
+	/// See b2World::SetHitEventThreshold.
+	float hitThreshold;
+};
+
+/// A body moved by the last time step, see b2BodyMoveEvents.
+struct b2BodyMoveEvent
+{
+	b2Body* body;
+	/// The body fell asleep at the end of the step, it doesn't move until it's woken.
+	bool fellAsleep;
+};
+
+/// Bodies moved by the last time step in a contiguous array, see b2World::SetBodyMoveEvents.
+/// These are the awake dynamic and kinematic bodies in the order of their islands, so
+/// rendering and game logic can skip sleeping bodies. Bodies moved by continuous collision
+/// follow, a body may be reported more than once, the last event is current. Bodies moved
+/// by the user (e.g. SetTransform) are not reported.
+struct b2BodyMoveEvents
+{
+	b2BodyMoveEvent* events;
+	int32 count;
+	int32 capacity;
+};
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -70,6 +155,14 @@ public:
 	/// by you and must remain in scope.
 	void SetDebugDraw(b2Draw* debugDraw);
 
+	/// Register a task scheduler to evaluate contact manifolds and solve islands in parallel.
+	/// By default everything runs on the calling thread. The scheduler is owned by you and must remain in scope.
+	/// Results don't depend on the number of threads. Contact listener callbacks are still called
+	/// on the calling thread in the same order, but PostSolve is called after all islands are solved.
+	/// @warning This function is locked during callbacks.
+	void SetTaskScheduler(b2TaskScheduler* scheduler);
+	b2TaskScheduler* GetTaskScheduler() const { return m_taskScheduler; }
+
 	/// Create a rigid body given a definition. No reference to the definition
 	/// is retained.
 	/// @warning This function is locked during callbacks.
@@ -125,6 +218,24 @@ public:
 	/// @param point2 the ray ending point
 	void RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b2Vec2& point2) const;
 
+	/// Query the world for all fixtures that potentially overlap any of the provided AABBs.
+	/// The AABBs traverse the broad-phase together, there are no callbacks.
+	/// @param aabbs the query boxes.
+	/// @param count the number of query boxes.
+	/// @param hits receives the fixtures found with the index of the query box.
+	/// @param capacity the size of the hits array. Further hits are counted but not written.
+	/// @return the number of hits, may be greater than capacity.
+	int32 QueryAABBBatch(const b2AABB* aabbs, int32 count, b2QueryHit* hits, int32 capacity) const;
+
+	/// Ray-cast the world for the closest fixture hit by each of the rays. The rays traverse
+	/// the broad-phase together, there are no callbacks. Sensors are ignored, as are the shapes
+	/// containing the starting point of a ray.
+	/// @param inputs the rays. A ray extends from p1 to p1 + maxFraction * (p2 - p1).
+	/// @param count the number of rays.
+	/// @param hits receives the closest hit of each ray.
+	/// @param maskBits fixtures with no category bits in the mask are ignored.
+	void RayCastClosest(const b2RayCastInput* inputs, int32 count, b2RayCastHit* hits, uint16 maskBits = 0xFFFF) const;
+
 	/// Get the world body list. With the returned body, use b2Body::GetNext to get
 	/// the next body in the world list. A nullptr body indicates the end of the list.
 	/// @return the head of the world body list.
@@ -149,10 +260,52 @@ public:
 	void SetAllowSleeping(bool flag);
 	bool GetAllowSleeping() const { return m_allowSleep; }
 
+	/// Set how long all bodies of an island must stay below their sleep thresholds before
+	/// the island falls asleep, in seconds. The default is b2_timeToSleep.
+	void SetTimeToSleep(float time) { m_timeToSleep = time; }
+	float GetTimeToSleep() const { return m_timeToSleep; }
+
 	/// Enable/disable warm starting. For testing.
 	void SetWarmStarting(bool flag) { m_warmStarting = flag; }
 	bool GetWarmStarting() const { return m_warmStarting; }
 
+	/// Enable/disable the wide contact solver. It solves several contacts at once with SIMD
+	/// instructions. Contacts are solved in a different order, so results differ from the
+	/// default solver, but they are reproducible.
+	void SetWideSolving(bool flag) { m_wideSolving = flag; }
+	bool GetWideSolving() const { return m_wideSolving; }
+
+	/// Get transforms, sweeps and velocities of all bodies in contiguous arrays, see
+	/// b2BodyStateArrays.
+	const b2BodyStateArrays& GetBodyStateArrays() const;
+
+	/// Record begin, end and hit events of contacts into arrays during each step, see
+	/// b2ContactEvents. It's independent of the contact listener. Disabled by default.
+	void SetContactEvents(bool flag);
+
+	/// Set the minimum approach speed of hit events, in meters per second. The default is 1.
+	void SetHitEventThreshold(float speed);
+
+	/// Get the contact events of the last step, nullptr if they are disabled.
+	const b2ContactEvents* GetContactEvents() const;
+
+	/// Record the bodies moved by each step into an array, see b2BodyMoveEvents.
+	/// Disabled by default.
+	void SetBodyMoveEvents(bool flag);
+
+	/// Get the bodies moved by the last step, nullptr if the events are disabled.
+	const b2BodyMoveEvents* GetBodyMoveEvents() const;
+
+	/// Select the broad-phase structure, see b2BroadPhaseType. The default is the dynamic tree.
+	/// This must be called before any fixture is created.
+	void SetBroadPhaseType(b2BroadPhaseType type);
+	b2BroadPhaseType GetBroadPhaseType() const;
+
+	/// Set the cell size of the uniform grid broad-phase. It should be about the size
+	/// of a typical fixture. The default is b2_gridCellSize.
+	void SetGridCellSize(float cellSize);
+	float GetGridCellSize() const;
+
 	/// Enable/disable continuous physics. For testing.
 	void SetContinuousPhysics(bool flag) { m_continuousPhysics = flag; }
 	bool GetContinuousPhysics() const { return m_continuousPhysics; }
@@ -209,6 +362,14 @@ public:
 	/// Get the current profile.
 	const b2Profile& GetProfile() const;
 
+	/// Return the memory of destroyed bodies, fixtures, shapes, contacts and joints
+	/// to the system, e.g. after the world was cleared.
+	/// @warning this should be called outside of a time step.
+	void CompactMemory();
+
+	/// Get the memory use of bodies, fixtures, shapes, contacts and joints.
+	void GetMemoryStats(b2BlockAllocatorStats* stats) const;
+
 	/// Dump the world into the log file.
 	/// @warning this should be called outside of a time step.
 	void Dump();
@@ -222,22 +383,44 @@ private:
 
 	void Solve(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
+	bool SolveTOIEvent(b2Island* island, b2Contact* contact, float alpha, const b2TimeStep& step);
+	void ReserveBodyMoveEvents(int32 count);
 
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
 
+	int32 CreateBodyState(b2Body* body);
+	void DestroyBodyState(b2Body* body);
+
 	b2BlockAllocator m_blockAllocator;
 	b2StackAllocator m_stackAllocator;
 
+	// Thread 0 of the task scheduler uses m_stackAllocator, these are for the other threads.
+	b2TaskScheduler* m_taskScheduler;
+	b2StackAllocator* m_threadAllocators;
+	int32 m_threadAllocatorCount;
+
 	b2ContactManager m_contactManager;
 
 	b2Body* m_bodyList;
 	b2Joint* m_jointList;
 
+	// Body state arrays and their free slots, see b2BodyStateArrays.
+	b2BodyStateArrays m_states;
+	int32* m_freeStates;
+	int32 m_freeStateCount;
+
+	// Reused by every step, see SetContactEvents.
+	bool m_contactEventsEnabled;
+	b2ContactEvents m_contactEvents;
+	bool m_bodyMoveEventsEnabled;
+	b2BodyMoveEvents m_bodyMoveEvents;
+
 	int32 m_bodyCount;
 	int32 m_jointCount;
 
 	b2Vec2 m_gravity;
 	bool m_allowSleep;
+	float m_timeToSleep;
 
 	b2DestructionListener* m_destructionListener;
 	b2Draw* m_debugDraw;
@@ -252,6 +435,7 @@ private:
 
 	// These are for debugging the solver.
 	bool m_warmStarting;
+	bool m_wideSolving;
 	bool m_continuousPhysics;
 	bool m_subStepping;
 
@@ -336,6 +520,21 @@ inline const b2ContactManager& b2World::GetContactManager() const
 	return m_contactManager;
 }
 
+inline const b2BodyStateArrays& b2World::GetBodyStateArrays() const
+{
+	return m_states;
+}
+
+inline const b2ContactEvents* b2World::GetContactEvents() const
+{
+	return m_contactEventsEnabled ? &m_contactEvents : nullptr;
+}
+
+inline const b2BodyMoveEvents* b2World::GetBodyMoveEvents() const
+{
+	return m_bodyMoveEventsEnabled ? &m_bodyMoveEvents : nullptr;
+}
+
 inline const b2Profile& b2World::GetProfile() const
 {
 	return m_profile;
@@ -28,6 +28,7 @@
 #include "b2_settings.h"
 #include "b2_draw.h"
 #include "b2_timer.h"
+#include "b2_task_scheduler.h"
 
 #include "b2_chain_shape.h"
 #include "b2_circle_shape.h"
@@ -36,6 +37,7 @@
 
 #include "b2_broad_phase.h"
 #include "b2_dynamic_tree.h"
+#include "b2_uniform_grid.h"
 
 #include "b2_body.h"
 #include "b2_contact.h"
@@ -25,8 +25,12 @@
 
 b2BroadPhase::b2BroadPhase()
 {
+	m_type = b2_dynamicTreeBroadPhase;
 	m_proxyCount = 0;
 
+	m_staticProxyCount = 0;
+	m_staticChangeCount = 0;
+
 	m_pairCapacity = 16;
 	m_pairCount = 0;
 	m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
@@ -42,9 +46,40 @@ b2BroadPhase::~b2BroadPhase()
 	b2Free(m_pairBuffer);
 }
 
+void b2BroadPhase::SetType(b2BroadPhaseType type)
+{
+	// Proxy ids of the tree and the grid are not interchangeable.
+	b2Assert(m_proxyCount == m_staticProxyCount);
+	m_type = type;
+}
+
+void b2BroadPhase::SetGridCellSize(float cellSize)
+{
+	m_grid.SetCellSize(cellSize);
+}
+
 int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
 {
-	int32 proxyId = m_tree.CreateProxy(aabb, userData);
+	int32 proxyId;
+	if (m_type == b2_uniformGridBroadPhase)
+	{
+		proxyId = m_grid.CreateProxy(aabb, userData) << 1;
+	}
+	else
+	{
+		proxyId = m_tree.CreateProxy(aabb, userData) << 1;
+	}
+
+	++m_proxyCount;
+	BufferMove(proxyId);
+	return proxyId;
+}
+
+int32 b2BroadPhase::CreateStaticProxy(const b2AABB& aabb, void* userData)
+{
+	int32 proxyId = (m_staticTree.CreateProxy(aabb, userData) << 1) | 1;
+	++m_staticProxyCount;
+	++m_staticChangeCount;
 	++m_proxyCount;
 	BufferMove(proxyId);
 	return proxyId;
@@ -54,12 +89,42 @@ void b2BroadPhase::DestroyProxy(int32 proxyId)
 {
 	UnBufferMove(proxyId);
 	--m_proxyCount;
-	m_tree.DestroyProxy(proxyId);
+
+	if (IsStaticProxy(proxyId))
+	{
+		--m_staticProxyCount;
+		m_staticTree.DestroyProxy(GetStructureProxy(proxyId));
+	}
+	else if (m_type == b2_uniformGridBroadPhase)
+	{
+		m_grid.DestroyProxy(GetStructureProxy(proxyId));
+	}
+	else
+	{
+		m_tree.DestroyProxy(GetStructureProxy(proxyId));
+	}
 }
 
 void b2BroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
-	bool buffer = m_tree.MoveProxy(proxyId, aabb, displacement);
+	bool buffer;
+	if (IsStaticProxy(proxyId))
+	{
+		buffer = m_staticTree.MoveProxy(GetStructureProxy(proxyId), aabb, displacement);
+		if (buffer)
+		{
+			++m_staticChangeCount;
+		}
+	}
+	else if (m_type == b2_uniformGridBroadPhase)
+	{
+		buffer = m_grid.MoveProxy(GetStructureProxy(proxyId), aabb, displacement);
+	}
+	else
+	{
+		buffer = m_tree.MoveProxy(GetStructureProxy(proxyId), aabb, displacement);
+	}
+
 	if (buffer)
 	{
 		BufferMove(proxyId);
@@ -97,7 +162,7 @@ void b2BroadPhase::UnBufferMove(int32 proxyId)
 	}
 }
 
-// This is called from b2DynamicTree::Query when we are gathering pairs.
+// This is called from b2DynamicTree::Query or b2UniformGrid::Query when we are gathering pairs.
 bool b2BroadPhase::QueryCallback(int32 proxyId)
 {
 	// A proxy cannot form a pair with itself.
@@ -106,7 +171,20 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 		return true;
 	}
 
-	const bool moved = m_tree.WasMoved(proxyId);
+	bool moved;
+	if (IsStaticProxy(proxyId))
+	{
+		moved = m_staticTree.WasMoved(GetStructureProxy(proxyId));
+	}
+	else if (m_type == b2_uniformGridBroadPhase)
+	{
+		moved = m_grid.WasMoved(GetStructureProxy(proxyId));
+	}
+	else
+	{
+		moved = m_tree.WasMoved(GetStructureProxy(proxyId));
+	}
+
 	if (moved && proxyId > m_queryProxyId)
 	{
 		// Both proxies are moving. Avoid duplicate pairs.
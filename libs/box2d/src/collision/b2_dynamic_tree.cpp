@@ -20,6 +20,7 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 #include "box2d/b2_dynamic_tree.h"
+#include "common/b2_simd.h"
 #include <string.h>
 
 b2DynamicTree::b2DynamicTree()
@@ -790,6 +791,220 @@ void b2DynamicTree::RebuildBottomUp()
 	Validate();
 }
 
+void b2DynamicTree::RebuildTopDown()
+{
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	int32* leaves = (int32*)b2Alloc(m_nodeCount * sizeof(int32));
+	int32 count = 0;
+
+	// Build array of leaves. Free the rest.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height < 0)
+		{
+			// free node in pool
+			continue;
+		}
+
+		if (m_nodes[i].IsLeaf())
+		{
+			m_nodes[i].parent = b2_nullNode;
+			leaves[count] = i;
+			++count;
+		}
+		else
+		{
+			FreeNode(i);
+		}
+	}
+
+	m_root = BuildTopDown(leaves, count);
+	b2Free(leaves);
+
+	Validate();
+}
+
+struct b2TreeBuildRange
+{
+	int32 node;
+	int32 begin;
+	int32 end;
+};
+
+// Split the leaves recursively. The work is kept on an explicit stack because the splits
+// are not guaranteed to be balanced.
+int32 b2DynamicTree::BuildTopDown(int32* leaves, int32 count)
+{
+	if (count == 1)
+	{
+		return leaves[0];
+	}
+
+	// Internal nodes in the order of creation. Children are created after their parents.
+	int32* internalNodes = (int32*)b2Alloc((count - 1) * sizeof(int32));
+	int32 internalCount = 0;
+
+	int32 root = AllocateNode();
+
+	b2GrowableStack<b2TreeBuildRange, 64> stack;
+	stack.Push({root, 0, count});
+
+	while (stack.GetCount() > 0)
+	{
+		b2TreeBuildRange range = stack.Pop();
+		int32 split = range.begin + PartitionLeaves(leaves + range.begin, range.end - range.begin);
+
+		int32 children[2];
+		int32 begins[2] = {range.begin, split};
+		int32 ends[2] = {split, range.end};
+		for (int32 i = 0; i < 2; ++i)
+		{
+			if (ends[i] - begins[i] == 1)
+			{
+				children[i] = leaves[begins[i]];
+			}
+			else
+			{
+				children[i] = AllocateNode();
+				stack.Push({children[i], begins[i], ends[i]});
+			}
+
+			m_nodes[children[i]].parent = range.node;
+		}
+
+		m_nodes[range.node].child1 = children[0];
+		m_nodes[range.node].child2 = children[1];
+
+		internalNodes[internalCount] = range.node;
+		++internalCount;
+	}
+
+	b2Assert(internalCount == count - 1);
+
+	// Fit the internal nodes bottom up.
+	for (int32 i = internalCount - 1; i >= 0; --i)
+	{
+		b2TreeNode* node = m_nodes + internalNodes[i];
+		const b2TreeNode* child1 = m_nodes + node->child1;
+		const b2TreeNode* child2 = m_nodes + node->child2;
+
+		node->aabb.Combine(child1->aabb, child2->aabb);
+		node->height = 1 + b2Max(child1->height, child2->height);
+	}
+
+	b2Free(internalNodes);
+
+	return root;
+}
+
+// Partition the leaves along the longer axis of their centers. The split is chosen from
+// uniformly sized bins by the surface area heuristic, with the perimeter as the area in 2D.
+// Returns the number of leaves in the first part, at least one leaf is in each part.
+int32 b2DynamicTree::PartitionLeaves(int32* leaves, int32 count) const
+{
+	const int32 binCount = 16;
+
+	b2Vec2 lower = m_nodes[leaves[0]].aabb.GetCenter();
+	b2Vec2 upper = lower;
+	for (int32 i = 1; i < count; ++i)
+	{
+		b2Vec2 c = m_nodes[leaves[i]].aabb.GetCenter();
+		lower = b2Min(lower, c);
+		upper = b2Max(upper, c);
+	}
+
+	b2Vec2 extent = upper - lower;
+	int32 axis = extent.x > extent.y ? 0 : 1;
+	if (extent(axis) <= 0.0f)
+	{
+		// All centers coincide, any split is as good.
+		return count / 2;
+	}
+
+	float scale = binCount / extent(axis);
+
+	b2AABB binAABBs[binCount];
+	int32 binCounts[binCount] = {};
+	for (int32 i = 0; i < count; ++i)
+	{
+		const b2AABB& aabb = m_nodes[leaves[i]].aabb;
+		int32 bin = b2Min(int32((aabb.GetCenter()(axis) - lower(axis)) * scale), binCount - 1);
+		if (binCounts[bin] == 0)
+		{
+			binAABBs[bin] = aabb;
+		}
+		else
+		{
+			binAABBs[bin].Combine(aabb);
+		}
+		++binCounts[bin];
+	}
+
+	// The leaves with the lowest and the highest center are in the first and the last bin,
+	// so both are not empty and every split has leaves on both sides.
+	b2Assert(binCounts[0] > 0 && binCounts[binCount - 1] > 0);
+
+	// Costs of the bins right of each split.
+	float rightCosts[binCount];
+	int32 rightCount = binCounts[binCount - 1];
+	b2AABB rightAABB = binAABBs[binCount - 1];
+	rightCosts[binCount - 1] = rightCount * rightAABB.GetPerimeter();
+	for (int32 i = binCount - 2; i > 0; --i)
+	{
+		if (binCounts[i] > 0)
+		{
+			rightAABB.Combine(binAABBs[i]);
+			rightCount += binCounts[i];
+		}
+
+		rightCosts[i] = rightCount * rightAABB.GetPerimeter();
+	}
+
+	float bestCost = b2_maxFloat;
+	int32 bestBin = 0;
+	int32 leftCount = binCounts[0];
+	b2AABB leftAABB = binAABBs[0];
+	for (int32 i = 0; i < binCount - 1; ++i)
+	{
+		if (i > 0 && binCounts[i] > 0)
+		{
+			leftAABB.Combine(binAABBs[i]);
+			leftCount += binCounts[i];
+		}
+
+		float cost = leftCount * leftAABB.GetPerimeter() + rightCosts[i + 1];
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			bestBin = i;
+		}
+	}
+
+	// Move the leaves of the first part to the front.
+	int32 i = 0;
+	int32 j = count - 1;
+	while (i <= j)
+	{
+		int32 bin = b2Min(int32((m_nodes[leaves[i]].aabb.GetCenter()(axis) - lower(axis)) * scale), binCount - 1);
+		if (bin <= bestBin)
+		{
+			++i;
+		}
+		else
+		{
+			b2Swap(leaves[i], leaves[j]);
+			--j;
+		}
+	}
+
+	b2Assert(0 < i && i < count);
+	return i;
+}
+
 void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	// Build array of leaves. Free the rest.
@@ -799,3 +1014,71 @@ void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 		m_nodes[i].aabb.upperBound -= newOrigin;
 	}
 }
+
+uint32 b2TestOverlap(const b2AABB& a, const b2TreePacket& packet, uint32 mask)
+{
+	b2FloatW aLowerX = b2SplatW(a.lowerBound.x);
+	b2FloatW aLowerY = b2SplatW(a.lowerBound.y);
+	b2FloatW aUpperX = b2SplatW(a.upperBound.x);
+	b2FloatW aUpperY = b2SplatW(a.upperBound.y);
+
+	uint32 result = 0;
+	for (int32 i = 0; i < b2_treePacketSize; i += b2_simdWidth)
+	{
+		// Skip the lanes which are not tested anyway.
+		if (((mask >> i) & 0xF) == 0)
+		{
+			continue;
+		}
+
+		b2MaskW overlap = b2AndW(
+			b2AndW(b2GreaterEqualW(aUpperX, b2LoadW(packet.lowerX + i)), b2GreaterEqualW(aUpperY, b2LoadW(packet.lowerY + i))),
+			b2AndW(b2GreaterEqualW(b2LoadW(packet.upperX + i), aLowerX), b2GreaterEqualW(b2LoadW(packet.upperY + i), aLowerY)));
+
+		result |= uint32(b2MaskBitsW(overlap)) << i;
+	}
+
+	return result & mask;
+}
+
+uint32 b2TestSegmentOverlap(const b2AABB& a, const b2TreePacket& packet, uint32 mask)
+{
+	b2FloatW aLowerX = b2SplatW(a.lowerBound.x);
+	b2FloatW aLowerY = b2SplatW(a.lowerBound.y);
+	b2FloatW aUpperX = b2SplatW(a.upperBound.x);
+	b2FloatW aUpperY = b2SplatW(a.upperBound.y);
+
+	b2Vec2 center = a.GetCenter();
+	b2Vec2 extents = a.GetExtents();
+	b2FloatW cX = b2SplatW(center.x);
+	b2FloatW cY = b2SplatW(center.y);
+	b2FloatW hX = b2SplatW(extents.x);
+	b2FloatW hY = b2SplatW(extents.y);
+	b2FloatW zero = b2SplatW(0.0f);
+
+	uint32 result = 0;
+	for (int32 i = 0; i < b2_treePacketSize; i += b2_simdWidth)
+	{
+		if (((mask >> i) & 0xF) == 0)
+		{
+			continue;
+		}
+
+		b2MaskW overlap = b2AndW(
+			b2AndW(b2GreaterEqualW(aUpperX, b2LoadW(packet.lowerX + i)), b2GreaterEqualW(aUpperY, b2LoadW(packet.lowerY + i))),
+			b2AndW(b2GreaterEqualW(b2LoadW(packet.upperX + i), aLowerX), b2GreaterEqualW(b2LoadW(packet.upperY + i), aLowerY)));
+
+		// Separating axis for segment (Gino, p80).
+		// |dot(v, p1 - c)| > dot(|v|, h)
+		b2FloatW vX = b2LoadW(packet.normalX + i);
+		b2FloatW vY = b2LoadW(packet.normalY + i);
+		b2FloatW d = vX * (b2LoadW(packet.p1X + i) - cX) + vY * (b2LoadW(packet.p1Y + i) - cY);
+		b2FloatW separation = b2MaxW(d, -d) - (b2MaxW(vX, -vX) * hX + b2MaxW(vY, -vY) * hY);
+
+		overlap = b2AndW(overlap, b2GreaterEqualW(zero, separation));
+
+		result |= uint32(b2MaskBitsW(overlap)) << i;
+	}
+
+	return result & mask;
+}
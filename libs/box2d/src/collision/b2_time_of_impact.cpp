@@ -25,14 +25,9 @@
 #include "box2d/b2_circle_shape.h"
 #include "box2d/b2_polygon_shape.h"
 #include "box2d/b2_time_of_impact.h"
-#include "box2d/b2_timer.h"
 
 #include <stdio.h>
 
-float b2_toiTime, b2_toiMaxTime;
-int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
-int32 b2_toiRootIters, b2_toiMaxRootIters;
-
 //
 struct b2SeparationFunction
 {
@@ -257,12 +252,10 @@ struct b2SeparationFunction
 // by computing the largest time at which separation is maintained.
 void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 {
-	b2Timer timer;
-
-	++b2_toiCalls;
-
 	output->state = b2TOIOutput::e_unknown;
 	output->t = input->tMax;
+	output->iterations = 0;
+	output->rootIterations = 0;
 
 	const b2DistanceProxy* proxyA = &input->proxyA;
 	const b2DistanceProxy* proxyB = &input->proxyB;
@@ -426,7 +419,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 
 				++rootIterCount;
-				++b2_toiRootIters;
+				++output->rootIterations;
 
 				float s = fcn.Evaluate(indexA, indexB, t);
 
@@ -455,8 +448,6 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 			}
 
-			b2_toiMaxRootIters = b2Max(b2_toiMaxRootIters, rootIterCount);
-
 			++pushBackIter;
 
 			if (pushBackIter == b2_maxPolygonVertices)
@@ -466,7 +457,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 
 		++iter;
-		++b2_toiIters;
+		++output->iterations;
 
 		if (done)
 		{
@@ -481,10 +472,4 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 			break;
 		}
 	}
-
-	b2_toiMaxIters = b2Max(b2_toiMaxIters, iter);
-
-	float time = timer.GetMilliseconds();
-	b2_toiMaxTime = b2Max(b2_toiMaxTime, time);
-	b2_toiTime += time;
 }
@@ -0,0 +1,445 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "box2d/b2_uniform_grid.h"
+#include <string.h>
+
+b2UniformGrid::b2UniformGrid()
+{
+	m_proxyCapacity = 16;
+	m_proxyCount = 0;
+	m_proxies = (b2GridProxy*)b2Alloc(m_proxyCapacity * sizeof(b2GridProxy));
+
+	// Build a linked list for the free list.
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		m_proxies[i] = b2GridProxy();
+		m_proxies[i].next = i + 1;
+	}
+	m_proxies[m_proxyCapacity-1].next = b2_nullGridProxy;
+	m_freeList = 0;
+
+	m_bucketCount = 256;
+	m_buckets = (b2GridBucket*)b2Alloc(m_bucketCount * sizeof(b2GridBucket));
+	memset(m_buckets, 0, m_bucketCount * sizeof(b2GridBucket));
+
+	m_oversizedCapacity = 16;
+	m_oversizedCount = 0;
+	m_oversized = (int32*)b2Alloc(m_oversizedCapacity * sizeof(int32));
+
+	m_cellSize = b2_gridCellSize;
+	m_inverseCellSize = 1.0f / m_cellSize;
+}
+
+b2UniformGrid::~b2UniformGrid()
+{
+	for (int32 i = 0; i < m_bucketCount; ++i)
+	{
+		b2Free(m_buckets[i].proxies);
+	}
+
+	b2Free(m_buckets);
+	b2Free(m_oversized);
+	b2Free(m_proxies);
+}
+
+void b2UniformGrid::SetCellSize(float cellSize)
+{
+	b2Assert(cellSize > 0.0f);
+	m_cellSize = cellSize;
+	m_inverseCellSize = 1.0f / cellSize;
+
+	Rebuild(m_bucketCount);
+}
+
+// Allocate a proxy from the pool. Grow the pool if necessary.
+int32 b2UniformGrid::AllocateProxy()
+{
+	// Expand the proxy pool as needed.
+	if (m_freeList == b2_nullGridProxy)
+	{
+		b2Assert(m_proxyCount == m_proxyCapacity);
+
+		// The free list is empty. Rebuild a bigger pool.
+		b2GridProxy* oldProxies = m_proxies;
+		m_proxyCapacity *= 2;
+		m_proxies = (b2GridProxy*)b2Alloc(m_proxyCapacity * sizeof(b2GridProxy));
+		memcpy(m_proxies, oldProxies, m_proxyCount * sizeof(b2GridProxy));
+		b2Free(oldProxies);
+
+		for (int32 i = m_proxyCount; i < m_proxyCapacity; ++i)
+		{
+			m_proxies[i] = b2GridProxy();
+			m_proxies[i].next = i + 1;
+		}
+		m_proxies[m_proxyCapacity-1].next = b2_nullGridProxy;
+		m_freeList = m_proxyCount;
+	}
+
+	// Peel a proxy off the free list.
+	int32 proxyId = m_freeList;
+	m_freeList = m_proxies[proxyId].next;
+	m_proxies[proxyId].oversized = b2_nullGridProxy;
+	m_proxies[proxyId].userData = nullptr;
+	m_proxies[proxyId].allocated = true;
+	m_proxies[proxyId].moved = false;
+	++m_proxyCount;
+	return proxyId;
+}
+
+// Return a proxy to the pool.
+void b2UniformGrid::FreeProxy(int32 proxyId)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert(0 < m_proxyCount);
+	m_proxies[proxyId].next = m_freeList;
+	m_proxies[proxyId].allocated = false;
+	m_freeList = proxyId;
+	--m_proxyCount;
+}
+
+int32 b2UniformGrid::CreateProxy(const b2AABB& aabb, void* userData)
+{
+	// Keep the buckets short. Rebuild before the new proxy is allocated, it's inserted below.
+	if (m_proxyCount >= m_bucketCount)
+	{
+		Rebuild(2 * m_bucketCount);
+	}
+
+	int32 proxyId = AllocateProxy();
+
+	// Fatten the aabb.
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	m_proxies[proxyId].aabb.lowerBound = aabb.lowerBound - r;
+	m_proxies[proxyId].aabb.upperBound = aabb.upperBound + r;
+	m_proxies[proxyId].userData = userData;
+	m_proxies[proxyId].moved = true;
+
+	InsertProxy(proxyId);
+
+	return proxyId;
+}
+
+void b2UniformGrid::DestroyProxy(int32 proxyId)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert(m_proxies[proxyId].allocated);
+
+	RemoveProxy(proxyId);
+	FreeProxy(proxyId);
+}
+
+bool b2UniformGrid::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert(m_proxies[proxyId].allocated);
+
+	// Extend AABB
+	b2AABB fatAABB;
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	fatAABB.lowerBound = aabb.lowerBound - r;
+	fatAABB.upperBound = aabb.upperBound + r;
+
+	// Predict AABB movement
+	b2Vec2 d = b2_aabbMultiplier * displacement;
+
+	if (d.x < 0.0f)
+	{
+		fatAABB.lowerBound.x += d.x;
+	}
+	else
+	{
+		fatAABB.upperBound.x += d.x;
+	}
+
+	if (d.y < 0.0f)
+	{
+		fatAABB.lowerBound.y += d.y;
+	}
+	else
+	{
+		fatAABB.upperBound.y += d.y;
+	}
+
+	b2GridProxy* proxy = m_proxies + proxyId;
+	const b2AABB& gridAABB = proxy->aabb;
+	if (gridAABB.Contains(aabb))
+	{
+		// The grid AABB still contains the object, but it might be too large.
+		// Perhaps the object was moving fast but has since gone to sleep.
+		// The huge AABB is larger than the new fat AABB.
+		b2AABB hugeAABB;
+		hugeAABB.lowerBound = fatAABB.lowerBound - 4.0f * r;
+		hugeAABB.upperBound = fatAABB.upperBound + 4.0f * r;
+
+		if (hugeAABB.Contains(gridAABB))
+		{
+			// The grid AABB contains the object AABB and the grid AABB is
+			// not too large. No grid update needed.
+			return false;
+		}
+
+		// Otherwise the grid AABB is huge and needs to be shrunk
+	}
+
+	// The cells only need to be updated when the proxy covers different cells.
+	if (proxy->oversized == b2_nullGridProxy &&
+		GetCell(fatAABB.lowerBound.x) == proxy->lowerX && GetCell(fatAABB.lowerBound.y) == proxy->lowerY &&
+		GetCell(fatAABB.upperBound.x) == proxy->upperX && GetCell(fatAABB.upperBound.y) == proxy->upperY)
+	{
+		proxy->aabb = fatAABB;
+	}
+	else
+	{
+		RemoveProxy(proxyId);
+		proxy->aabb = fatAABB;
+		InsertProxy(proxyId);
+	}
+
+	proxy->moved = true;
+
+	return true;
+}
+
+// Add the proxy to the buckets of its cells or to the oversized list.
+void b2UniformGrid::InsertProxy(int32 proxyId)
+{
+	b2GridProxy* proxy = m_proxies + proxyId;
+	proxy->lowerX = GetCell(proxy->aabb.lowerBound.x);
+	proxy->lowerY = GetCell(proxy->aabb.lowerBound.y);
+	proxy->upperX = GetCell(proxy->aabb.upperBound.x);
+	proxy->upperY = GetCell(proxy->aabb.upperBound.y);
+
+	float cellCount = float(proxy->upperX - proxy->lowerX + 1) * float(proxy->upperY - proxy->lowerY + 1);
+	if (cellCount > float(b2_gridMaxProxyCells))
+	{
+		if (m_oversizedCount == m_oversizedCapacity)
+		{
+			int32* oldOversized = m_oversized;
+			m_oversizedCapacity *= 2;
+			m_oversized = (int32*)b2Alloc(m_oversizedCapacity * sizeof(int32));
+			memcpy(m_oversized, oldOversized, m_oversizedCount * sizeof(int32));
+			b2Free(oldOversized);
+		}
+
+		proxy->oversized = m_oversizedCount;
+		m_oversized[m_oversizedCount] = proxyId;
+		++m_oversizedCount;
+		return;
+	}
+
+	proxy->oversized = b2_nullGridProxy;
+
+	for (int32 y = proxy->lowerY; y <= proxy->upperY; ++y)
+	{
+		for (int32 x = proxy->lowerX; x <= proxy->upperX; ++x)
+		{
+			b2GridBucket* bucket = m_buckets + GetBucket(x, y);
+
+			// Two cells of the proxy may hash to the same bucket. Keep the proxy there only once.
+			bool found = false;
+			for (int32 i = bucket->count - 1; i >= 0; --i)
+			{
+				if (bucket->proxies[i] == proxyId)
+				{
+					found = true;
+					break;
+				}
+			}
+
+			if (found)
+			{
+				continue;
+			}
+
+			if (bucket->count == bucket->capacity)
+			{
+				int32* oldProxies = bucket->proxies;
+				bucket->capacity = bucket->capacity > 0 ? 2 * bucket->capacity : 4;
+				bucket->proxies = (int32*)b2Alloc(bucket->capacity * sizeof(int32));
+				if (oldProxies != nullptr)
+				{
+					memcpy(bucket->proxies, oldProxies, bucket->count * sizeof(int32));
+					b2Free(oldProxies);
+				}
+			}
+
+			bucket->proxies[bucket->count] = proxyId;
+			++bucket->count;
+		}
+	}
+}
+
+// Remove the proxy from the buckets of its cells or from the oversized list.
+void b2UniformGrid::RemoveProxy(int32 proxyId)
+{
+	b2GridProxy* proxy = m_proxies + proxyId;
+
+	if (proxy->oversized != b2_nullGridProxy)
+	{
+		int32 index = proxy->oversized;
+		b2Assert(m_oversized[index] == proxyId);
+
+		--m_oversizedCount;
+		m_oversized[index] = m_oversized[m_oversizedCount];
+		m_proxies[m_oversized[index]].oversized = index;
+		proxy->oversized = b2_nullGridProxy;
+		return;
+	}
+
+	for (int32 y = proxy->lowerY; y <= proxy->upperY; ++y)
+	{
+		for (int32 x = proxy->lowerX; x <= proxy->upperX; ++x)
+		{
+			b2GridBucket* bucket = m_buckets + GetBucket(x, y);
+
+			// The proxy is missing if it was already removed through another cell of the bucket.
+			for (int32 i = 0; i < bucket->count; ++i)
+			{
+				if (bucket->proxies[i] == proxyId)
+				{
+					--bucket->count;
+					bucket->proxies[i] = bucket->proxies[bucket->count];
+					break;
+				}
+			}
+		}
+	}
+}
+
+// Insert all proxies again, e.g. after the cell size or the proxy AABBs changed.
+void b2UniformGrid::Rebuild(int32 bucketCount)
+{
+	b2Assert(bucketCount > 0 && (bucketCount & (bucketCount - 1)) == 0);
+
+	if (bucketCount != m_bucketCount)
+	{
+		for (int32 i = 0; i < m_bucketCount; ++i)
+		{
+			b2Free(m_buckets[i].proxies);
+		}
+		b2Free(m_buckets);
+
+		m_bucketCount = bucketCount;
+		m_buckets = (b2GridBucket*)b2Alloc(m_bucketCount * sizeof(b2GridBucket));
+		memset(m_buckets, 0, m_bucketCount * sizeof(b2GridBucket));
+	}
+	else
+	{
+		for (int32 i = 0; i < m_bucketCount; ++i)
+		{
+			m_buckets[i].count = 0;
+		}
+	}
+
+	m_oversizedCount = 0;
+
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		if (m_proxies[i].allocated)
+		{
+			InsertProxy(i);
+		}
+	}
+}
+
+void b2UniformGrid::Validate() const
+{
+#if defined(b2DEBUG)
+	int32 proxyCount = 0;
+	for (int32 proxyId = 0; proxyId < m_proxyCapacity; ++proxyId)
+	{
+		const b2GridProxy* proxy = m_proxies + proxyId;
+		if (proxy->allocated == false)
+		{
+			continue;
+		}
+
+		++proxyCount;
+
+		if (proxy->oversized != b2_nullGridProxy)
+		{
+			b2Assert(m_oversized[proxy->oversized] == proxyId);
+			continue;
+		}
+
+		b2Assert(proxy->lowerX == GetCell(proxy->aabb.lowerBound.x));
+		b2Assert(proxy->lowerY == GetCell(proxy->aabb.lowerBound.y));
+		b2Assert(proxy->upperX == GetCell(proxy->aabb.upperBound.x));
+		b2Assert(proxy->upperY == GetCell(proxy->aabb.upperBound.y));
+
+		for (int32 y = proxy->lowerY; y <= proxy->upperY; ++y)
+		{
+			for (int32 x = proxy->lowerX; x <= proxy->upperX; ++x)
+			{
+				const b2GridBucket* bucket = m_buckets + GetBucket(x, y);
+
+				int32 count = 0;
+				for (int32 i = 0; i < bucket->count; ++i)
+				{
+					if (bucket->proxies[i] == proxyId)
+					{
+						++count;
+					}
+				}
+
+				b2Assert(count == 1);
+			}
+		}
+	}
+
+	b2Assert(proxyCount == m_proxyCount);
+
+	// Every oversized proxy is listed once, at its own index.
+	for (int32 i = 0; i < m_oversizedCount; ++i)
+	{
+		int32 proxyId = m_oversized[i];
+		b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+		b2Assert(m_proxies[proxyId].allocated);
+		b2Assert(m_proxies[proxyId].oversized == i);
+	}
+
+	int32 freeCount = 0;
+	int32 freeIndex = m_freeList;
+	while (freeIndex != b2_nullGridProxy)
+	{
+		b2Assert(0 <= freeIndex && freeIndex < m_proxyCapacity);
+		b2Assert(m_proxies[freeIndex].allocated == false);
+		freeIndex = m_proxies[freeIndex].next;
+		++freeCount;
+	}
+
+	b2Assert(m_proxyCount + freeCount == m_proxyCapacity);
+#endif
+}
+
+void b2UniformGrid::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		m_proxies[i].aabb.lowerBound -= newOrigin;
+		m_proxies[i].aabb.upperBound -= newOrigin;
+	}
+
+	// The proxies cover different cells now.
+	Rebuild(m_bucketCount);
+}
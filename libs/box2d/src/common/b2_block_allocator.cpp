@@ -25,6 +25,10 @@
 #include <string.h>
 #include <stddef.h>
 
+#include <algorithm>
+#include <mutex>
+#include <new>
+
 static const int32 b2_chunkSize = 16 * 1024;
 static const int32 b2_maxBlockSize = 640;
 static const int32 b2_chunkArrayIncrement = 128;
@@ -86,16 +90,53 @@ struct b2Block
 	b2Block* next;
 };
 
+struct b2BlockLock
+{
+	std::mutex mutex;
+};
+
+// Locks the allocator only if it's thread-safe.
+class b2BlockLockGuard
+{
+public:
+	b2BlockLockGuard(b2BlockLock* lock, bool threadSafe)
+	{
+		m_mutex = threadSafe ? &lock->mutex : nullptr;
+		if (m_mutex)
+		{
+			m_mutex->lock();
+		}
+	}
+
+	~b2BlockLockGuard()
+	{
+		if (m_mutex)
+		{
+			m_mutex->unlock();
+		}
+	}
+
+private:
+	std::mutex* m_mutex;
+};
+
 b2BlockAllocator::b2BlockAllocator()
 {
 	b2Assert(b2_blockSizeCount < UCHAR_MAX);
 
+	m_lock = new (b2Alloc(sizeof(b2BlockLock))) b2BlockLock;
+	m_threadSafe = false;
+
 	m_chunkSpace = b2_chunkArrayIncrement;
 	m_chunkCount = 0;
 	m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
 	
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 	memset(m_freeLists, 0, sizeof(m_freeLists));
+
+	memset(m_blockCounts, 0, sizeof(m_blockCounts));
+	m_largeCount = 0;
+	m_largeBytes = 0;
 }
 
 b2BlockAllocator::~b2BlockAllocator()
@@ -106,24 +147,14 @@ b2BlockAllocator::~b2BlockAllocator()
 	}
 
 	b2Free(m_chunks);
+
+	m_lock->~b2BlockLock();
+	b2Free(m_lock);
 }
 
-void* b2BlockAllocator::Allocate(int32 size)
+b2Block* b2BlockAllocator::AllocateBlock(int32 index)
 {
-	if (size == 0)
-	{
-		return nullptr;
-	}
-
-	b2Assert(0 < size);
-
-	if (size > b2_maxBlockSize)
-	{
-		return b2Alloc(size);
-	}
-
-	int32 index = b2_sizeMap.values[size];
-	b2Assert(0 <= index && index < b2_blockSizeCount);
+	++m_blockCounts[index];
 
 	if (m_freeLists[index])
 	{
@@ -168,6 +199,65 @@ void* b2BlockAllocator::Allocate(int32 size)
 	}
 }
 
+void b2BlockAllocator::FreeBlock(b2Block* block, int32 index)
+{
+#if defined(_DEBUG)
+	// Verify the memory address and size is valid.
+	int32 blockSize = b2_blockSizes[index];
+	bool found = false;
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		b2Chunk* chunk = m_chunks + i;
+		if (chunk->blockSize != blockSize)
+		{
+			b2Assert(	(int8*)block + blockSize <= (int8*)chunk->blocks ||
+						(int8*)chunk->blocks + b2_chunkSize <= (int8*)block);
+		}
+		else
+		{
+			if ((int8*)chunk->blocks <= (int8*)block && (int8*)block + blockSize <= (int8*)chunk->blocks + b2_chunkSize)
+			{
+				found = true;
+			}
+		}
+	}
+
+	b2Assert(found);
+
+	memset(block, 0xfd, blockSize);
+#endif
+
+	b2Assert(m_blockCounts[index] > 0);
+	--m_blockCounts[index];
+
+	block->next = m_freeLists[index];
+	m_freeLists[index] = block;
+}
+
+void* b2BlockAllocator::Allocate(int32 size)
+{
+	if (size == 0)
+	{
+		return nullptr;
+	}
+
+	b2Assert(0 < size);
+
+	b2BlockLockGuard lock(m_lock, m_threadSafe);
+
+	if (size > b2_maxBlockSize)
+	{
+		++m_largeCount;
+		m_largeBytes += size;
+		return b2Alloc(size);
+	}
+
+	int32 index = b2_sizeMap.values[size];
+	b2Assert(0 <= index && index < b2_blockSizeCount);
+
+	return AllocateBlock(index);
+}
+
 void b2BlockAllocator::Free(void* p, int32 size)
 {
 	if (size == 0)
@@ -177,8 +267,12 @@ void b2BlockAllocator::Free(void* p, int32 size)
 
 	b2Assert(0 < size);
 
+	b2BlockLockGuard lock(m_lock, m_threadSafe);
+
 	if (size > b2_maxBlockSize)
 	{
+		--m_largeCount;
+		m_largeBytes -= size;
 		b2Free(p);
 		return;
 	}
@@ -186,45 +280,252 @@ void b2BlockAllocator::Free(void* p, int32 size)
 	int32 index = b2_sizeMap.values[size];
 	b2Assert(0 <= index && index < b2_blockSizeCount);
 
-#if defined(_DEBUG)
-	// Verify the memory address and size is valid.
-	int32 blockSize = b2_blockSizes[index];
-	bool found = false;
+	FreeBlock((b2Block*)p, index);
+}
+
+b2Block* b2BlockAllocator::AllocateBatch(int32 index, int32 count)
+{
+	b2BlockLockGuard lock(m_lock, m_threadSafe);
+
+	b2Block* blocks = nullptr;
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Block* block = AllocateBlock(index);
+		block->next = blocks;
+		blocks = block;
+	}
+
+	return blocks;
+}
+
+void b2BlockAllocator::FreeBatch(b2Block* blocks, int32 index, int32 count)
+{
+	b2BlockLockGuard lock(m_lock, m_threadSafe);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Assert(blocks != nullptr);
+		b2Block* next = blocks->next;
+		FreeBlock(blocks, index);
+		blocks = next;
+	}
+}
+
+void b2BlockAllocator::Clear()
+{
+	b2BlockLockGuard lock(m_lock, m_threadSafe);
+
 	for (int32 i = 0; i < m_chunkCount; ++i)
 	{
-		b2Chunk* chunk = m_chunks + i;
-		if (chunk->blockSize != blockSize)
+		b2Free(m_chunks[i].blocks);
+	}
+
+	m_chunkCount = 0;
+	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
+	memset(m_freeLists, 0, sizeof(m_freeLists));
+	memset(m_blockCounts, 0, sizeof(m_blockCounts));
+}
+
+// Find the chunk containing the block in chunks sorted by address.
+static int32 b2FindChunk(const b2Chunk* chunks, int32 count, const b2Block* block)
+{
+	int32 low = 0;
+	int32 high = count - 1;
+	while (low < high)
+	{
+		int32 mid = (low + high + 1) / 2;
+		if (chunks[mid].blocks <= block)
 		{
-			b2Assert(	(int8*)p + blockSize <= (int8*)chunk->blocks ||
-						(int8*)chunk->blocks + b2_chunkSize <= (int8*)p);
+			low = mid;
 		}
 		else
 		{
-			if ((int8*)chunk->blocks <= (int8*)p && (int8*)p + blockSize <= (int8*)chunk->blocks + b2_chunkSize)
+			high = mid - 1;
+		}
+	}
+
+	b2Assert((int8*)chunks[low].blocks <= (int8*)block && (int8*)block < (int8*)chunks[low].blocks + b2_chunkSize);
+	return low;
+}
+
+void b2BlockAllocator::Compact()
+{
+	b2BlockLockGuard lock(m_lock, m_threadSafe);
+
+	if (m_chunkCount == 0)
+	{
+		return;
+	}
+
+	std::sort(m_chunks, m_chunks + m_chunkCount, [](const b2Chunk& a, const b2Chunk& b) { return a.blocks < b.blocks; });
+
+	// Count the free blocks of each chunk.
+	int32* freeCounts = (int32*)b2Alloc(m_chunkCount * sizeof(int32));
+	memset(freeCounts, 0, m_chunkCount * sizeof(int32));
+	for (int32 index = 0; index < b2_blockSizeCount; ++index)
+	{
+		for (b2Block* block = m_freeLists[index]; block != nullptr; block = block->next)
+		{
+			++freeCounts[b2FindChunk(m_chunks, m_chunkCount, block)];
+		}
+	}
+
+	// Chunks with all blocks free are released, their blocks are dropped from the free lists.
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		bool unused = freeCounts[i] == b2_chunkSize / m_chunks[i].blockSize;
+		freeCounts[i] = unused ? -1 : 0;
+	}
+
+	for (int32 index = 0; index < b2_blockSizeCount; ++index)
+	{
+		b2Block** link = m_freeLists + index;
+		while (*link != nullptr)
+		{
+			b2Block* block = *link;
+			if (freeCounts[b2FindChunk(m_chunks, m_chunkCount, block)] < 0)
 			{
-				found = true;
+				*link = block->next;
+			}
+			else
+			{
+				link = &block->next;
 			}
 		}
 	}
 
-	b2Assert(found);
+	int32 chunkCount = 0;
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		if (freeCounts[i] < 0)
+		{
+			b2Free(m_chunks[i].blocks);
+		}
+		else
+		{
+			m_chunks[chunkCount++] = m_chunks[i];
+		}
+	}
 
-	memset(p, 0xfd, blockSize);
-#endif
+	memset(m_chunks + chunkCount, 0, (m_chunkCount - chunkCount) * sizeof(b2Chunk));
+	m_chunkCount = chunkCount;
+
+	b2Free(freeCounts);
+}
+
+void b2BlockAllocator::GetStats(b2BlockAllocatorStats* stats) const
+{
+	b2BlockLockGuard lock(m_lock, m_threadSafe);
+
+	for (int32 i = 0; i < b2_blockSizeCount; ++i)
+	{
+		stats->blockCounts[i] = m_blockCounts[i];
+		stats->blockBytes[i] = m_blockCounts[i] * b2_blockSizes[i];
+	}
+
+	stats->largeCount = m_largeCount;
+	stats->largeBytes = m_largeBytes;
+	stats->chunkCount = m_chunkCount;
+	stats->chunkBytes = m_chunkCount * b2_chunkSize;
+}
+
+int32 b2BlockAllocator::GetBlockSize(int32 sizeClass)
+{
+	b2Assert(0 <= sizeClass && sizeClass < b2_blockSizeCount);
+	return b2_blockSizes[sizeClass];
+}
+
+b2BlockCache::b2BlockCache(b2BlockAllocator* allocator)
+{
+	m_allocator = allocator;
+	memset(m_freeLists, 0, sizeof(m_freeLists));
+	memset(m_counts, 0, sizeof(m_counts));
+}
+
+b2BlockCache::~b2BlockCache()
+{
+	Flush();
+}
+
+void* b2BlockCache::Allocate(int32 size)
+{
+	if (size == 0)
+	{
+		return nullptr;
+	}
+
+	b2Assert(0 < size);
+
+	if (size > b2_maxBlockSize)
+	{
+		return m_allocator->Allocate(size);
+	}
+
+	int32 index = b2_sizeMap.values[size];
+	b2Assert(0 <= index && index < b2_blockSizeCount);
+
+	if (m_freeLists[index] == nullptr)
+	{
+		m_freeLists[index] = m_allocator->AllocateBatch(index, b2_blockCacheBatch);
+		m_counts[index] = b2_blockCacheBatch;
+	}
+
+	b2Block* block = m_freeLists[index];
+	m_freeLists[index] = block->next;
+	--m_counts[index];
+	return block;
+}
+
+void b2BlockCache::Free(void* p, int32 size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+
+	b2Assert(0 < size);
+
+	if (size > b2_maxBlockSize)
+	{
+		m_allocator->Free(p, size);
+		return;
+	}
+
+	int32 index = b2_sizeMap.values[size];
+	b2Assert(0 <= index && index < b2_blockSizeCount);
 
 	b2Block* block = (b2Block*)p;
 	block->next = m_freeLists[index];
 	m_freeLists[index] = block;
+	++m_counts[index];
+
+	// Keep one batch, so alternating allocations and frees do not go to the allocator.
+	if (m_counts[index] == 2 * b2_blockCacheBatch)
+	{
+		b2Block* batch = m_freeLists[index];
+		b2Block* last = batch;
+		for (int32 i = 1; i < b2_blockCacheBatch; ++i)
+		{
+			last = last->next;
+		}
+
+		m_freeLists[index] = last->next;
+		m_counts[index] -= b2_blockCacheBatch;
+		m_allocator->FreeBatch(batch, index, b2_blockCacheBatch);
+	}
 }
 
-void b2BlockAllocator::Clear()
+void b2BlockCache::Flush()
 {
-	for (int32 i = 0; i < m_chunkCount; ++i)
+	for (int32 index = 0; index < b2_blockSizeCount; ++index)
 	{
-		b2Free(m_chunks[i].blocks);
-	}
+		if (m_counts[index] == 0)
+		{
+			continue;
+		}
 
-	m_chunkCount = 0;
-	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
-	memset(m_freeLists, 0, sizeof(m_freeLists));
+		m_allocator->FreeBatch(m_freeLists[index], index, m_counts[index]);
+		m_freeLists[index] = nullptr;
+		m_counts[index] = 0;
+	}
 }
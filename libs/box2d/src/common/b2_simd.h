@@ -0,0 +1,134 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2_SIMD_H
+#define B2_SIMD_H
+
+#include "box2d/b2_math.h"
+
+// Minimal SIMD layer of the wide contact solver. SSE2 is part of every x64 target,
+// other targets use the scalar fallback with the same results per lane.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define B2_SIMD_SSE2 1
+#include <emmintrin.h>
+#else
+#define B2_SIMD_SSE2 0
+#endif
+
+/// Number of lanes of b2FloatW.
+const int32 b2_simdWidth = 4;
+
+#if B2_SIMD_SSE2
+
+/// Four floats processed at once.
+struct b2FloatW
+{
+	__m128 v;
+};
+
+/// Result of a comparison, all bits of a lane are set where it holds.
+struct b2MaskW
+{
+	__m128 v;
+};
+
+inline b2FloatW b2LoadW(const float* p) { return { _mm_loadu_ps(p) }; }
+inline void b2StoreW(float* p, b2FloatW a) { _mm_storeu_ps(p, a.v); }
+inline b2FloatW b2SplatW(float s) { return { _mm_set1_ps(s) }; }
+inline b2FloatW b2SetW(float a, float b, float c, float d) { return { _mm_setr_ps(a, b, c, d) }; }
+
+inline b2FloatW operator+(b2FloatW a, b2FloatW b) { return { _mm_add_ps(a.v, b.v) }; }
+inline b2FloatW operator-(b2FloatW a, b2FloatW b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline b2FloatW operator*(b2FloatW a, b2FloatW b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline b2FloatW operator/(b2FloatW a, b2FloatW b) { return { _mm_div_ps(a.v, b.v) }; }
+inline b2FloatW operator-(b2FloatW a) { return { _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)) }; }
+
+// Same as b2Min and b2Max, including the result for NaN.
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return { _mm_min_ps(a.v, b.v) }; }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return { _mm_max_ps(a.v, b.v) }; }
+inline b2FloatW b2SqrtW(b2FloatW a) { return { _mm_sqrt_ps(a.v) }; }
+
+inline b2MaskW b2GreaterW(b2FloatW a, b2FloatW b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline b2MaskW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+inline b2MaskW b2LessW(b2FloatW a, b2FloatW b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline b2MaskW b2AndW(b2MaskW a, b2MaskW b) { return { _mm_and_ps(a.v, b.v) }; }
+
+/// Bit i is set where lane i of the mask is set.
+inline int32 b2MaskBitsW(b2MaskW mask) { return _mm_movemask_ps(mask.v); }
+
+/// mask ? a : b per lane
+inline b2FloatW b2SelectW(b2MaskW mask, b2FloatW a, b2FloatW b)
+{
+	return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) };
+}
+
+#else
+
+struct b2FloatW
+{
+	float v[b2_simdWidth];
+};
+
+struct b2MaskW
+{
+	bool v[b2_simdWidth];
+};
+
+#define B2_SIMD_LANES(result, expression) for (int32 i = 0; i < b2_simdWidth; ++i) { result.v[i] = expression; }
+
+inline b2FloatW b2LoadW(const float* p) { b2FloatW r; B2_SIMD_LANES(r, p[i]); return r; }
+inline void b2StoreW(float* p, b2FloatW a) { for (int32 i = 0; i < b2_simdWidth; ++i) { p[i] = a.v[i]; } }
+inline b2FloatW b2SplatW(float s) { b2FloatW r; B2_SIMD_LANES(r, s); return r; }
+inline b2FloatW b2SetW(float a, float b, float c, float d) { return { { a, b, c, d } }; }
+
+inline b2FloatW operator+(b2FloatW a, b2FloatW b) { b2FloatW r; B2_SIMD_LANES(r, a.v[i] + b.v[i]); return r; }
+inline b2FloatW operator-(b2FloatW a, b2FloatW b) { b2FloatW r; B2_SIMD_LANES(r, a.v[i] - b.v[i]); return r; }
+inline b2FloatW operator*(b2FloatW a, b2FloatW b) { b2FloatW r; B2_SIMD_LANES(r, a.v[i] * b.v[i]); return r; }
+inline b2FloatW operator/(b2FloatW a, b2FloatW b) { b2FloatW r; B2_SIMD_LANES(r, a.v[i] / b.v[i]); return r; }
+inline b2FloatW operator-(b2FloatW a) { b2FloatW r; B2_SIMD_LANES(r, -a.v[i]); return r; }
+
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { b2FloatW r; B2_SIMD_LANES(r, a.v[i] < b.v[i] ? a.v[i] : b.v[i]); return r; }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { b2FloatW r; B2_SIMD_LANES(r, a.v[i] > b.v[i] ? a.v[i] : b.v[i]); return r; }
+inline b2FloatW b2SqrtW(b2FloatW a) { b2FloatW r; B2_SIMD_LANES(r, sqrtf(a.v[i])); return r; }
+
+inline b2MaskW b2GreaterW(b2FloatW a, b2FloatW b) { b2MaskW r; B2_SIMD_LANES(r, a.v[i] > b.v[i]); return r; }
+inline b2MaskW b2GreaterEqualW(b2FloatW a, b2FloatW b) { b2MaskW r; B2_SIMD_LANES(r, a.v[i] >= b.v[i]); return r; }
+inline b2MaskW b2LessW(b2FloatW a, b2FloatW b) { b2MaskW r; B2_SIMD_LANES(r, a.v[i] < b.v[i]); return r; }
+inline b2MaskW b2AndW(b2MaskW a, b2MaskW b) { b2MaskW r; B2_SIMD_LANES(r, a.v[i] && b.v[i]); return r; }
+
+inline int32 b2MaskBitsW(b2MaskW mask)
+{
+	int32 bits = 0;
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		bits |= mask.v[i] ? 1 << i : 0;
+	}
+	return bits;
+}
+
+inline b2FloatW b2SelectW(b2MaskW mask, b2FloatW a, b2FloatW b) { b2FloatW r; B2_SIMD_LANES(r, mask.v[i] ? a.v[i] : b.v[i]); return r; }
+
+#undef B2_SIMD_LANES
+
+#endif
+
+#endif
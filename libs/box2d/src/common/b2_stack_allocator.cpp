@@ -25,9 +25,13 @@
 
 b2StackAllocator::b2StackAllocator()
 {
+	m_capacity = b2_stackSize;
+	m_data = (char*)b2Alloc(m_capacity);
 	m_index = 0;
 	m_allocation = 0;
 	m_maxAllocation = 0;
+	m_peakAllocation = 0;
+	m_mallocCount = 0;
 	m_entryCount = 0;
 }
 
@@ -35,18 +39,23 @@ b2StackAllocator::~b2StackAllocator()
 {
 	b2Assert(m_index == 0);
 	b2Assert(m_entryCount == 0);
+	b2Free(m_data);
 }
 
 void* b2StackAllocator::Allocate(int32 size)
 {
 	b2Assert(m_entryCount < b2_maxStackEntries);
 
+	// Keep the blocks aligned for SIMD and 64-bit data, b2Alloc is aligned at least as much.
+	size = (size + b2_stackAlignment - 1) & ~(b2_stackAlignment - 1);
+
 	b2StackEntry* entry = m_entries + m_entryCount;
 	entry->size = size;
-	if (m_index + size > b2_stackSize)
+	if (m_index + size > m_capacity)
 	{
 		entry->data = (char*)b2Alloc(size);
 		entry->usedMalloc = true;
+		++m_mallocCount;
 	}
 	else
 	{
@@ -57,6 +66,7 @@ void* b2StackAllocator::Allocate(int32 size)
 
 	m_allocation += size;
 	m_maxAllocation = b2Max(m_maxAllocation, m_allocation);
+	m_peakAllocation = b2Max(m_peakAllocation, m_allocation);
 	++m_entryCount;
 
 	return entry->data;
@@ -81,7 +91,18 @@ void b2StackAllocator::Free(void* p)
 	p = nullptr;
 }
 
-int32 b2StackAllocator::GetMaxAllocation() const
+void b2StackAllocator::Reset()
 {
-	return m_maxAllocation;
+	b2Assert(m_entryCount == 0);
+
+	if (m_peakAllocation > m_capacity)
+	{
+		// Some headroom so that a slowly growing world does not grow the stack every step.
+		b2Free(m_data);
+		m_capacity = m_peakAllocation + m_peakAllocation / 4;
+		m_data = (char*)b2Alloc(m_capacity);
+	}
+
+	m_peakAllocation = 0;
+	m_mallocCount = 0;
 }
@@ -0,0 +1,248 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "box2d/b2_task_scheduler.h"
+#include "box2d/b2_math.h"
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+// The chunks of a thread are the range [begin, end) packed into one value. The owner takes
+// chunks from the front and thieves take them from the back, both with a single compare and swap.
+struct alignas(64) b2WorkRange
+{
+	std::atomic<uint64_t> chunks;
+};
+
+struct b2ThreadPool
+{
+	b2ThreadPool(int32 threadCount) : ranges(new b2WorkRange[threadCount]), threadCount(threadCount) {}
+	~b2ThreadPool() { delete[] ranges; }
+
+	std::vector<std::thread> threads;
+	b2WorkRange* ranges;
+	int32 threadCount;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable idle;
+	uint32 generation = 0;
+	int32 activeWorkers = 0;
+	bool exit = false;
+
+	// Current loop, written under the mutex while no worker is active.
+	b2Task* task = nullptr;
+	int32 count = 0;
+	int32 chunkSize = 1;
+	std::atomic<int32> remainingChunks{ 0 };
+};
+
+static inline uint64_t b2PackRange(uint32 begin, uint32 end)
+{
+	return (uint64_t(begin) << 32) | end;
+}
+
+static bool b2PopFront(std::atomic<uint64_t>& range, int32* chunk)
+{
+	uint64_t value = range.load(std::memory_order_acquire);
+	for (;;)
+	{
+		uint32 begin = uint32(value >> 32);
+		uint32 end = uint32(value);
+		if (begin >= end)
+		{
+			return false;
+		}
+
+		if (range.compare_exchange_weak(value, b2PackRange(begin + 1, end), std::memory_order_acq_rel, std::memory_order_acquire))
+		{
+			*chunk = int32(begin);
+			return true;
+		}
+	}
+}
+
+static bool b2PopBack(std::atomic<uint64_t>& range, int32* chunk)
+{
+	uint64_t value = range.load(std::memory_order_acquire);
+	for (;;)
+	{
+		uint32 begin = uint32(value >> 32);
+		uint32 end = uint32(value);
+		if (begin >= end)
+		{
+			return false;
+		}
+
+		if (range.compare_exchange_weak(value, b2PackRange(begin, end - 1), std::memory_order_acq_rel, std::memory_order_acquire))
+		{
+			*chunk = int32(end - 1);
+			return true;
+		}
+	}
+}
+
+static void b2RunChunks(b2ThreadPool* pool, int32 threadIndex)
+{
+	int32 threadCount = pool->threadCount;
+
+	// Own chunks first, then steal. Chunks are never added during a loop,
+	// so one pass over the other threads is enough.
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		int32 owner = (threadIndex + i) % threadCount;
+		std::atomic<uint64_t>& range = pool->ranges[owner].chunks;
+
+		int32 chunk;
+		while (i == 0 ? b2PopFront(range, &chunk) : b2PopBack(range, &chunk))
+		{
+			int32 begin = chunk * pool->chunkSize;
+			int32 end = b2Min(begin + pool->chunkSize, pool->count);
+			pool->task->Execute(begin, end, threadIndex);
+
+			// Release the results of the chunk to the thread waiting in ParallelFor.
+			pool->remainingChunks.fetch_sub(1, std::memory_order_acq_rel);
+		}
+	}
+}
+
+static void b2WorkerMain(b2ThreadPool* pool, int32 threadIndex)
+{
+	uint32 generation = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(pool->mutex);
+			pool->wake.wait(lock, [pool, generation] { return pool->exit || pool->generation != generation; });
+
+			if (pool->exit)
+			{
+				return;
+			}
+
+			generation = pool->generation;
+			++pool->activeWorkers;
+		}
+
+		b2RunChunks(pool, threadIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(pool->mutex);
+			--pool->activeWorkers;
+		}
+		pool->idle.notify_one();
+	}
+}
+
+b2ThreadPoolScheduler::b2ThreadPoolScheduler(int32 threadCount)
+{
+	m_threadCount = b2Max(threadCount, 1);
+	m_pool = nullptr;
+
+	if (m_threadCount > 1)
+	{
+		m_pool = new (b2Alloc(sizeof(b2ThreadPool))) b2ThreadPool(m_threadCount);
+		for (int32 i = 1; i < m_threadCount; ++i)
+		{
+			m_pool->threads.emplace_back(b2WorkerMain, m_pool, i);
+		}
+	}
+}
+
+b2ThreadPoolScheduler::~b2ThreadPoolScheduler()
+{
+	if (m_pool == nullptr)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_pool->mutex);
+		m_pool->exit = true;
+	}
+	m_pool->wake.notify_all();
+
+	for (std::thread& thread : m_pool->threads)
+	{
+		thread.join();
+	}
+
+	m_pool->~b2ThreadPool();
+	b2Free(m_pool);
+}
+
+int32 b2ThreadPoolScheduler::GetThreadCount() const
+{
+	return m_threadCount;
+}
+
+void b2ThreadPoolScheduler::ParallelFor(b2Task* task, int32 count, int32 minRange)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	minRange = b2Max(minRange, 1);
+	if (m_pool == nullptr || count <= minRange)
+	{
+		task->Execute(0, count, 0);
+		return;
+	}
+
+	int32 chunkCount = (count + minRange - 1) / minRange;
+
+	{
+		std::unique_lock<std::mutex> lock(m_pool->mutex);
+
+		// A worker may still be looking for work of the previous loop.
+		m_pool->idle.wait(lock, [this] { return m_pool->activeWorkers == 0; });
+
+		m_pool->task = task;
+		m_pool->count = count;
+		m_pool->chunkSize = minRange;
+		m_pool->remainingChunks.store(chunkCount, std::memory_order_relaxed);
+
+		for (int32 i = 0; i < m_threadCount; ++i)
+		{
+			uint32 begin = uint32(int64_t(chunkCount) * i / m_threadCount);
+			uint32 end = uint32(int64_t(chunkCount) * (i + 1) / m_threadCount);
+			m_pool->ranges[i].chunks.store(b2PackRange(begin, end), std::memory_order_relaxed);
+		}
+
+		++m_pool->generation;
+	}
+	m_pool->wake.notify_all();
+
+	b2RunChunks(m_pool, 0);
+
+	// Wait for the chunks which are still executed by workers.
+	while (m_pool->remainingChunks.load(std::memory_order_acquire) > 0)
+	{
+		std::this_thread::yield();
+	}
+}
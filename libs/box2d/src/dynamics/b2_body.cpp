@@ -61,24 +61,28 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	}
 
 	m_world = world;
+	m_states = &world->m_states;
+	m_stateIndex = world->CreateBodyState(this);
 
-	m_xf.p = bd->position;
-	m_xf.q.Set(bd->angle);
+	b2Transform& xf = Transform();
+	xf.p = bd->position;
+	xf.q.Set(bd->angle);
 
-	m_sweep.localCenter.SetZero();
-	m_sweep.c0 = m_xf.p;
-	m_sweep.c = m_xf.p;
-	m_sweep.a0 = bd->angle;
-	m_sweep.a = bd->angle;
-	m_sweep.alpha0 = 0.0f;
+	b2Sweep& sweep = Sweep();
+	sweep.localCenter.SetZero();
+	sweep.c0 = xf.p;
+	sweep.c = xf.p;
+	sweep.a0 = bd->angle;
+	sweep.a = bd->angle;
+	sweep.alpha0 = 0.0f;
 
 	m_jointList = nullptr;
 	m_contactList = nullptr;
 	m_prev = nullptr;
 	m_next = nullptr;
 
-	m_linearVelocity = bd->linearVelocity;
-	m_angularVelocity = bd->angularVelocity;
+	LinearVelocity() = bd->linearVelocity;
+	AngularVelocity() = bd->angularVelocity;
 
 	m_linearDamping = bd->linearDamping;
 	m_angularDamping = bd->angularDamping;
@@ -88,6 +92,8 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	m_torque = 0.0f;
 
 	m_sleepTime = 0.0f;
+	b2Assert(bd->sleepThreshold >= 0.0f);
+	m_sleepThreshold = bd->sleepThreshold;
 
 	m_type = bd->type;
 
@@ -121,16 +127,20 @@ void b2Body::SetType(b2BodyType type)
 		return;
 	}
 
+	// Proxies of static bodies are in the static tree of the broad-phase.
+	bool staticChanged = (m_type == b2_staticBody) != (type == b2_staticBody);
+
 	m_type = type;
 
 	ResetMassData();
 
 	if (m_type == b2_staticBody)
 	{
-		m_linearVelocity.SetZero();
-		m_angularVelocity = 0.0f;
-		m_sweep.a0 = m_sweep.a;
-		m_sweep.c0 = m_sweep.c;
+		b2Sweep& sweep = Sweep();
+		LinearVelocity().SetZero();
+		AngularVelocity() = 0.0f;
+		sweep.a0 = sweep.a;
+		sweep.c0 = sweep.c;
 		m_flags &= ~e_awakeFlag;
 		SynchronizeFixtures();
 	}
@@ -154,6 +164,14 @@ void b2Body::SetType(b2BodyType type)
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
+		if (staticChanged && (m_flags & e_enabledFlag))
+		{
+			// Re-create the proxies in the other tree, new proxies form new pairs like touched ones.
+			f->DestroyProxies(broadPhase);
+			f->CreateProxies(broadPhase, Transform());
+			continue;
+		}
+
 		int32 proxyCount = f->m_proxyCount;
 		for (int32 i = 0; i < proxyCount; ++i)
 		{
@@ -179,7 +197,7 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 	if (m_flags & e_enabledFlag)
 	{
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
-		fixture->CreateProxies(broadPhase, m_xf);
+		fixture->CreateProxies(broadPhase, Transform());
 	}
 
 	fixture->m_next = m_fixtureList;
@@ -289,14 +307,16 @@ void b2Body::ResetMassData()
 	m_invMass = 0.0f;
 	m_I = 0.0f;
 	m_invI = 0.0f;
-	m_sweep.localCenter.SetZero();
+
+	b2Sweep& sweep = Sweep();
+	sweep.localCenter.SetZero();
 
 	// Static and kinematic bodies have zero mass.
 	if (m_type == b2_staticBody || m_type == b2_kinematicBody)
 	{
-		m_sweep.c0 = m_xf.p;
-		m_sweep.c = m_xf.p;
-		m_sweep.a0 = m_sweep.a;
+		sweep.c0 = Transform().p;
+		sweep.c = Transform().p;
+		sweep.a0 = sweep.a;
 		return;
 	}
 
@@ -340,12 +360,12 @@ void b2Body::ResetMassData()
 	}
 
 	// Move center of mass.
-	b2Vec2 oldCenter = m_sweep.c;
-	m_sweep.localCenter = localCenter;
-	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+	b2Vec2 oldCenter = sweep.c;
+	sweep.localCenter = localCenter;
+	sweep.c0 = sweep.c = b2Mul(Transform(), sweep.localCenter);
 
 	// Update center of mass velocity.
-	m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+	LinearVelocity() += b2Cross(AngularVelocity(), sweep.c - oldCenter);
 }
 
 void b2Body::SetMassData(const b2MassData* massData)
@@ -381,12 +401,13 @@ void b2Body::SetMassData(const b2MassData* massData)
 	}
 
 	// Move center of mass.
-	b2Vec2 oldCenter = m_sweep.c;
-	m_sweep.localCenter =  massData->center;
-	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+	b2Sweep& sweep = Sweep();
+	b2Vec2 oldCenter = sweep.c;
+	sweep.localCenter =  massData->center;
+	sweep.c0 = sweep.c = b2Mul(Transform(), sweep.localCenter);
 
 	// Update center of mass velocity.
-	m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+	LinearVelocity() += b2Cross(AngularVelocity(), sweep.c - oldCenter);
 }
 
 bool b2Body::ShouldCollide(const b2Body* other) const
@@ -420,19 +441,21 @@ void b2Body::SetTransform(const b2Vec2& position, float angle)
 		return;
 	}
 
-	m_xf.q.Set(angle);
-	m_xf.p = position;
+	b2Transform& xf = Transform();
+	xf.q.Set(angle);
+	xf.p = position;
 
-	m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
-	m_sweep.a = angle;
+	b2Sweep& sweep = Sweep();
+	sweep.c = b2Mul(xf, sweep.localCenter);
+	sweep.a = angle;
 
-	m_sweep.c0 = m_sweep.c;
-	m_sweep.a0 = angle;
+	sweep.c0 = sweep.c;
+	sweep.a0 = angle;
 
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
-		f->Synchronize(broadPhase, m_xf, m_xf);
+		f->Synchronize(broadPhase, xf, xf);
 	}
 
 	// Check for new contacts the next step
@@ -442,23 +465,25 @@ void b2Body::SetTransform(const b2Vec2& position, float angle)
 void b2Body::SynchronizeFixtures()
 {
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+	const b2Transform& xf = Transform();
 
 	if (m_flags & b2Body::e_awakeFlag)
 	{
+		const b2Sweep& sweep = Sweep();
 		b2Transform xf1;
-		xf1.q.Set(m_sweep.a0);
-		xf1.p = m_sweep.c0 - b2Mul(xf1.q, m_sweep.localCenter);
+		xf1.q.Set(sweep.a0);
+		xf1.p = sweep.c0 - b2Mul(xf1.q, sweep.localCenter);
 
 		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 		{
-			f->Synchronize(broadPhase, xf1, m_xf);
+			f->Synchronize(broadPhase, xf1, xf);
 		}
 	}
 	else
 	{
 		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 		{
-			f->Synchronize(broadPhase, m_xf, m_xf);
+			f->Synchronize(broadPhase, xf, xf);
 		}
 	}
 }
@@ -480,7 +505,7 @@ void b2Body::SetEnabled(bool flag)
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 		{
-			f->CreateProxies(broadPhase, m_xf);
+			f->CreateProxies(broadPhase, Transform());
 		}
 
 		// Contacts are created at the beginning of the next
@@ -526,7 +551,7 @@ void b2Body::SetFixedRotation(bool flag)
 		m_flags &= ~e_fixedRotationFlag;
 	}
 
-	m_angularVelocity = 0.0f;
+	AngularVelocity() = 0.0f;
 
 	ResetMassData();
 }
@@ -541,13 +566,14 @@ void b2Body::Dump()
 	b2Dump("{\n");
 	b2Dump("  b2BodyDef bd;\n");
 	b2Dump("  bd.type = b2BodyType(%d);\n", m_type);
-	b2Dump("  bd.position.Set(%.9g, %.9g);\n", m_xf.p.x, m_xf.p.y);
-	b2Dump("  bd.angle = %.9g;\n", m_sweep.a);
-	b2Dump("  bd.linearVelocity.Set(%.9g, %.9g);\n", m_linearVelocity.x, m_linearVelocity.y);
-	b2Dump("  bd.angularVelocity = %.9g;\n", m_angularVelocity);
+	b2Dump("  bd.position.Set(%.9g, %.9g);\n", Transform().p.x, Transform().p.y);
+	b2Dump("  bd.angle = %.9g;\n", Sweep().a);
+	b2Dump("  bd.linearVelocity.Set(%.9g, %.9g);\n", LinearVelocity().x, LinearVelocity().y);
+	b2Dump("  bd.angularVelocity = %.9g;\n", AngularVelocity());
 	b2Dump("  bd.linearDamping = %.9g;\n", m_linearDamping);
 	b2Dump("  bd.angularDamping = %.9g;\n", m_angularDamping);
 	b2Dump("  bd.allowSleep = bool(%d);\n", m_flags & e_autoSleepFlag);
+	b2Dump("  bd.sleepThreshold = %.9g;\n", m_sleepThreshold);
 	b2Dump("  bd.awake = bool(%d);\n", m_flags & e_awakeFlag);
 	b2Dump("  bd.fixedRotation = bool(%d);\n", m_flags & e_fixedRotationFlag);
 	b2Dump("  bd.bullet = bool(%d);\n", m_flags & e_bulletFlag);
@@ -38,6 +38,8 @@
 #include "box2d/b2_time_of_impact.h"
 #include "box2d/b2_world.h"
 
+#include <string.h>
+
 b2ContactRegister b2Contact::s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 bool b2Contact::s_initialized = false;
 
@@ -162,15 +164,21 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 
 // Update the contact manifold and touching status.
 // Note: do not assume the fixture AABBs are overlapping or are valid.
-void b2Contact::Update(b2ContactListener* listener)
+void b2Contact::Update(b2ContactListener* listener, b2ContactEvents* events)
+{
+	b2Manifold oldManifold;
+	bool touching = UpdateManifold(&oldManifold);
+	UpdateTouching(oldManifold, touching, listener, events);
+}
+
+bool b2Contact::UpdateManifold(b2Manifold* oldManifold)
 {
-	b2Manifold oldManifold = m_manifold;
+	*oldManifold = m_manifold;
 
 	// Re-enable this contact.
 	m_flags |= e_enabledFlag;
 
 	bool touching = false;
-	bool wasTouching = (m_flags & e_touchingFlag) == e_touchingFlag;
 
 	bool sensorA = m_fixtureA->IsSensor();
 	bool sensorB = m_fixtureB->IsSensor();
@@ -205,9 +213,9 @@ void b2Contact::Update(b2ContactListener* listener)
 			mp2->tangentImpulse = 0.0f;
 			b2ContactID id2 = mp2->id;
 
-			for (int32 j = 0; j < oldManifold.pointCount; ++j)
+			for (int32 j = 0; j < oldManifold->pointCount; ++j)
 			{
-				b2ManifoldPoint* mp1 = oldManifold.points + j;
+				b2ManifoldPoint* mp1 = oldManifold->points + j;
 
 				if (mp1->id.key == id2.key)
 				{
@@ -217,12 +225,21 @@ void b2Contact::Update(b2ContactListener* listener)
 				}
 			}
 		}
+	}
 
-		if (touching != wasTouching)
-		{
-			bodyA->SetAwake(true);
-			bodyB->SetAwake(true);
-		}
+	return touching;
+}
+
+void b2Contact::UpdateTouching(const b2Manifold& oldManifold, bool touching, b2ContactListener* listener, b2ContactEvents* events)
+{
+	bool wasTouching = (m_flags & e_touchingFlag) == e_touchingFlag;
+
+	bool sensor = m_fixtureA->IsSensor() || m_fixtureB->IsSensor();
+
+	if (sensor == false && touching != wasTouching)
+	{
+		m_fixtureA->GetBody()->SetAwake(true);
+		m_fixtureB->GetBody()->SetAwake(true);
 	}
 
 	if (touching)
@@ -244,8 +261,94 @@ void b2Contact::Update(b2ContactListener* listener)
 		listener->EndContact(this);
 	}
 
+	if (wasTouching != touching && events)
+	{
+		if (touching)
+		{
+			AddBeginEvent(events);
+
+			if (sensor == false)
+			{
+				AddHitEvent(events);
+			}
+		}
+		else
+		{
+			AddEndEvent(events);
+		}
+	}
+
 	if (sensor == false && touching && listener)
 	{
 		listener->PreSolve(this, &oldManifold);
 	}
 }
+
+// Event arrays keep their capacity from step to step.
+template <typename T>
+static T* b2AddEvent(T*& events, int32& count, int32& capacity)
+{
+	if (count == capacity)
+	{
+		T* old = events;
+		capacity = b2Max(16, 2 * capacity);
+		events = (T*)b2Alloc(capacity * sizeof(T));
+		if (old != nullptr)
+		{
+			memcpy(events, old, count * sizeof(T));
+			b2Free(old);
+		}
+	}
+
+	return events + count++;
+}
+
+void b2Contact::AddBeginEvent(b2ContactEvents* events)
+{
+	b2ContactTouchEvent* event = b2AddEvent(events->beginEvents, events->beginCount, events->beginCapacity);
+	event->fixtureA = m_fixtureA;
+	event->fixtureB = m_fixtureB;
+}
+
+void b2Contact::AddEndEvent(b2ContactEvents* events)
+{
+	b2ContactTouchEvent* event = b2AddEvent(events->endEvents, events->endCount, events->endCapacity);
+	event->fixtureA = m_fixtureA;
+	event->fixtureB = m_fixtureB;
+}
+
+void b2Contact::AddHitEvent(b2ContactEvents* events)
+{
+	b2Body* bodyA = m_fixtureA->GetBody();
+	b2Body* bodyB = m_fixtureB->GetBody();
+
+	b2WorldManifold worldManifold;
+	GetWorldManifold(&worldManifold);
+
+	// The velocities are not solved yet, they are the velocities the bodies came with.
+	int32 pointIndex = -1;
+	float approachSpeed = events->hitThreshold;
+	for (int32 i = 0; i < m_manifold.pointCount; ++i)
+	{
+		b2Vec2 vA = bodyA->GetLinearVelocityFromWorldPoint(worldManifold.points[i]);
+		b2Vec2 vB = bodyB->GetLinearVelocityFromWorldPoint(worldManifold.points[i]);
+		float speed = b2Dot(vA - vB, worldManifold.normal);
+		if (speed > approachSpeed)
+		{
+			pointIndex = i;
+			approachSpeed = speed;
+		}
+	}
+
+	if (pointIndex == -1)
+	{
+		return;
+	}
+
+	b2ContactHitEvent* event = b2AddEvent(events->hitEvents, events->hitCount, events->hitCapacity);
+	event->fixtureA = m_fixtureA;
+	event->fixtureB = m_fixtureB;
+	event->point = worldManifold.points[pointIndex];
+	event->normal = worldManifold.normal;
+	event->approachSpeed = approachSpeed;
+}
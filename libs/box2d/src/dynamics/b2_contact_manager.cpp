@@ -24,6 +24,8 @@
 #include "box2d/b2_contact.h"
 #include "box2d/b2_contact_manager.h"
 #include "box2d/b2_fixture.h"
+#include "box2d/b2_stack_allocator.h"
+#include "box2d/b2_task_scheduler.h"
 #include "box2d/b2_world_callbacks.h"
 
 b2ContactFilter b2_defaultFilter;
@@ -35,7 +37,10 @@ b2ContactManager::b2ContactManager()
 	m_contactCount = 0;
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
+	m_contactEvents = nullptr;
 	m_allocator = nullptr;
+	m_stackAllocator = nullptr;
+	m_taskScheduler = nullptr;
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -50,6 +55,11 @@ void b2ContactManager::Destroy(b2Contact* c)
 		m_contactListener->EndContact(c);
 	}
 
+	if (m_contactEvents && c->IsTouching())
+	{
+		c->AddEndEvent(m_contactEvents);
+	}
+
 	// Remove from the world.
 	if (c->m_prev)
 	{
@@ -103,15 +113,96 @@ void b2ContactManager::Destroy(b2Contact* c)
 	--m_contactCount;
 }
 
+// Contact with manifold evaluated by b2UpdateManifoldsTask.
+struct b2ContactUpdate
+{
+	b2Contact* contact;
+	b2Manifold oldManifold;
+	bool touching;
+};
+
+// Manifolds of contacts are independent, only the contact itself is changed.
+class b2UpdateManifoldsTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
+	{
+		B2_NOT_USED(threadIndex);
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			b2ContactUpdate* update = updates + i;
+			update->touching = update->contact->UpdateManifold(&update->oldManifold);
+		}
+	}
+
+	b2ContactUpdate* updates;
+};
+
+// Number of contacts in one task of the narrow phase.
+const int32 b2_contactUpdateRange = 32;
+
 // This is the top level collision call for the time step. Here
 // all the narrow phase collision is processed for the world
 // contact list.
 void b2ContactManager::Collide()
 {
+	// With a task scheduler, manifolds of contacts which are sure to persist are evaluated
+	// in parallel first. The loop below still visits contacts in the list order, so bodies
+	// are woken and the listener is called exactly as without the scheduler.
+	b2ContactUpdate* updates = nullptr;
+	int32 updateCount = 0;
+	if (m_taskScheduler != nullptr && m_contactCount > 0)
+	{
+		updates = (b2ContactUpdate*)m_stackAllocator->Allocate(m_contactCount * sizeof(b2ContactUpdate));
+
+		for (b2Contact* c = m_contactList; c; c = c->GetNext())
+		{
+			// Filtering calls the user filter, keep it in order.
+			if (c->m_flags & b2Contact::e_filterFlag)
+			{
+				continue;
+			}
+
+			b2Fixture* fixtureA = c->GetFixtureA();
+			b2Fixture* fixtureB = c->GetFixtureB();
+			b2Body* bodyA = fixtureA->GetBody();
+			b2Body* bodyB = fixtureB->GetBody();
+
+			// Bodies may only be woken during the loop below, so an active contact stays active.
+			bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+			bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+			if (activeA == false && activeB == false)
+			{
+				continue;
+			}
+
+			int32 proxyIdA = fixtureA->m_proxies[c->GetChildIndexA()].proxyId;
+			int32 proxyIdB = fixtureB->m_proxies[c->GetChildIndexB()].proxyId;
+			if (m_broadPhase.TestOverlap(proxyIdA, proxyIdB) == false)
+			{
+				continue;
+			}
+
+			updates[updateCount++].contact = c;
+		}
+
+		b2UpdateManifoldsTask task;
+		task.updates = updates;
+		m_taskScheduler->ParallelFor(&task, updateCount, b2_contactUpdateRange);
+	}
+
 	// Update awake contacts.
+	int32 updateIndex = 0;
 	b2Contact* c = m_contactList;
 	while (c)
 	{
+		b2ContactUpdate* update = nullptr;
+		if (updateIndex < updateCount && updates[updateIndex].contact == c)
+		{
+			update = updates + updateIndex++;
+		}
+
 		b2Fixture* fixtureA = c->GetFixtureA();
 		b2Fixture* fixtureB = c->GetFixtureB();
 		int32 indexA = c->GetChildIndexA();
@@ -144,6 +235,14 @@ void b2ContactManager::Collide()
 			c->m_flags &= ~b2Contact::e_filterFlag;
 		}
 
+		// The manifold is already evaluated.
+		if (update != nullptr)
+		{
+			c->UpdateTouching(update->oldManifold, update->touching, m_contactListener, m_contactEvents);
+			c = c->GetNext();
+			continue;
+		}
+
 		bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
 		bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
 
@@ -168,9 +267,14 @@ void b2ContactManager::Collide()
 		}
 
 		// The contact persists.
-		c->Update(m_contactListener);
+		c->Update(m_contactListener, m_contactEvents);
 		c = c->GetNext();
 	}
+
+	if (updates != nullptr)
+	{
+		m_stackAllocator->Free(updates);
+	}
 }
 
 void b2ContactManager::FindNewContacts()
@@ -21,6 +21,7 @@
 // SOFTWARE.
 
 #include "b2_contact_solver.h"
+#include "common/b2_simd.h"
 
 #include "box2d/b2_body.h"
 #include "box2d/b2_contact.h"
@@ -28,6 +29,8 @@
 #include "box2d/b2_stack_allocator.h"
 #include "box2d/b2_world.h"
 
+#include <string.h>
+
 // Solver debugging is normally disabled because the block solver sometimes has to deal with a poorly conditioned effective mass matrix.
 #define B2_DEBUG_SOLVER 0
 
@@ -48,6 +51,62 @@ struct b2ContactPositionConstraint
 	int32 pointCount;
 };
 
+// Velocity constraints of up to b2_simdWidth contacts, one contact per lane. Contacts of one
+// bundle don't share a dynamic body, so the lanes are solved at once. All lanes have the same
+// point count. Unused lanes point to the bodies of lane 0 and have zero mass.
+struct b2WideVelocityConstraint
+{
+	int32 indexA[b2_simdWidth];
+	int32 indexB[b2_simdWidth];
+	int32 constraintIndex[b2_simdWidth];
+	float invMassA[b2_simdWidth], invMassB[b2_simdWidth];
+	float invIA[b2_simdWidth], invIB[b2_simdWidth];
+	float normalX[b2_simdWidth], normalY[b2_simdWidth];
+	float friction[b2_simdWidth];
+	float tangentSpeed[b2_simdWidth];
+
+	float rAX[b2_maxManifoldPoints][b2_simdWidth], rAY[b2_maxManifoldPoints][b2_simdWidth];
+	float rBX[b2_maxManifoldPoints][b2_simdWidth], rBY[b2_maxManifoldPoints][b2_simdWidth];
+	float normalImpulse[b2_maxManifoldPoints][b2_simdWidth];
+	float tangentImpulse[b2_maxManifoldPoints][b2_simdWidth];
+	float normalMass[b2_maxManifoldPoints][b2_simdWidth];
+	float tangentMass[b2_maxManifoldPoints][b2_simdWidth];
+	float velocityBias[b2_maxManifoldPoints][b2_simdWidth];
+
+	// Block solver, see b2ContactVelocityConstraint::K and normalMass.
+	float k11[b2_simdWidth], k12[b2_simdWidth], k22[b2_simdWidth];
+	float blockMass11[b2_simdWidth], blockMass12[b2_simdWidth];
+	float blockMass21[b2_simdWidth], blockMass22[b2_simdWidth];
+
+	int32 count;
+	int32 pointCount;
+};
+
+// Position constraints of up to b2_simdWidth contacts, all lanes are either circles or faces.
+// Unused lanes have zero point count.
+struct b2WidePositionConstraint
+{
+	int32 indexA[b2_simdWidth];
+	int32 indexB[b2_simdWidth];
+	float invMassA[b2_simdWidth], invMassB[b2_simdWidth];
+	float invIA[b2_simdWidth], invIB[b2_simdWidth];
+	float localCenterAX[b2_simdWidth], localCenterAY[b2_simdWidth];
+	float localCenterBX[b2_simdWidth], localCenterBY[b2_simdWidth];
+	float localPointsX[b2_maxManifoldPoints][b2_simdWidth], localPointsY[b2_maxManifoldPoints][b2_simdWidth];
+	float localNormalX[b2_simdWidth], localNormalY[b2_simdWidth];
+	float localPointX[b2_simdWidth], localPointY[b2_simdWidth];
+	float radiusA[b2_simdWidth], radiusB[b2_simdWidth];
+	float faceB[b2_simdWidth];		// 1 for b2Manifold::e_faceB, 0 otherwise
+	float pointCount[b2_simdWidth];
+
+	int32 count;
+	bool circles;
+};
+
+// Contacts are packed into bundles by greedy graph coloring, contacts which don't fit into
+// any color are solved by the scalar solver.
+const int32 b2_wideColorCount = 12;
+
 b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 {
 	m_step = def->step;
@@ -58,6 +117,12 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 	m_positions = def->positions;
 	m_velocities = def->velocities;
 	m_contacts = def->contacts;
+	m_wideVelocityConstraints = nullptr;
+	m_widePositionConstraints = nullptr;
+	m_overflowConstraints = nullptr;
+	m_wideVelocityCount = 0;
+	m_widePositionCount = 0;
+	m_overflowCount = 0;
 
 	// Initialize position independent portions of the constraints.
 	for (int32 i = 0; i < m_count; ++i)
@@ -97,8 +162,8 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 		pc->indexB = bodyB->m_islandIndex;
 		pc->invMassA = bodyA->m_invMass;
 		pc->invMassB = bodyB->m_invMass;
-		pc->localCenterA = bodyA->m_sweep.localCenter;
-		pc->localCenterB = bodyB->m_sweep.localCenter;
+		pc->localCenterA = bodyA->Sweep().localCenter;
+		pc->localCenterB = bodyB->Sweep().localCenter;
 		pc->invIA = bodyA->m_invI;
 		pc->invIB = bodyB->m_invI;
 		pc->localNormal = manifold->localNormal;
@@ -137,6 +202,13 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 
 b2ContactSolver::~b2ContactSolver()
 {
+	if (m_wideVelocityConstraints != nullptr)
+	{
+		m_allocator->Free(m_widePositionConstraints);
+		m_allocator->Free(m_wideVelocityConstraints);
+		m_allocator->Free(m_overflowConstraints);
+	}
+
 	m_allocator->Free(m_velocityConstraints);
 	m_allocator->Free(m_positionConstraints);
 }
@@ -251,6 +323,254 @@ void b2ContactSolver::InitializeVelocityConstraints()
 			}
 		}
 	}
+
+	if (m_step.wideSolving)
+	{
+		InitializeWideConstraints();
+	}
+}
+
+// Only bodies moved by the solver conflict, static and kinematic bodies may be shared by the lanes.
+static bool b2IsSolverBody(float invMass, float invI)
+{
+	return invMass > 0.0f || invI > 0.0f;
+}
+
+static bool b2IsColorFree(const uint32* colorBodies, int32 index)
+{
+	return (colorBodies[index / 32] & (1u << (index % 32))) == 0;
+}
+
+static void b2AddToColor(uint32* colorBodies, int32 index)
+{
+	colorBodies[index / 32] |= 1u << (index % 32);
+}
+
+static void b2AddWideLane(b2WideVelocityConstraint* wc, const b2ContactVelocityConstraint* vc, int32 constraintIndex)
+{
+	int32 lane = wc->count++;
+	if (lane == 0)
+	{
+		// Unused lanes read the bodies of the first lane, they are not written back.
+		for (int32 i = 0; i < b2_simdWidth; ++i)
+		{
+			wc->indexA[i] = vc->indexA;
+			wc->indexB[i] = vc->indexB;
+		}
+	}
+
+	wc->indexA[lane] = vc->indexA;
+	wc->indexB[lane] = vc->indexB;
+	wc->constraintIndex[lane] = constraintIndex;
+	wc->invMassA[lane] = vc->invMassA;
+	wc->invMassB[lane] = vc->invMassB;
+	wc->invIA[lane] = vc->invIA;
+	wc->invIB[lane] = vc->invIB;
+	wc->normalX[lane] = vc->normal.x;
+	wc->normalY[lane] = vc->normal.y;
+	wc->friction[lane] = vc->friction;
+	wc->tangentSpeed[lane] = vc->tangentSpeed;
+
+	for (int32 j = 0; j < vc->pointCount; ++j)
+	{
+		const b2VelocityConstraintPoint* vcp = vc->points + j;
+		wc->rAX[j][lane] = vcp->rA.x;
+		wc->rAY[j][lane] = vcp->rA.y;
+		wc->rBX[j][lane] = vcp->rB.x;
+		wc->rBY[j][lane] = vcp->rB.y;
+		wc->normalImpulse[j][lane] = vcp->normalImpulse;
+		wc->tangentImpulse[j][lane] = vcp->tangentImpulse;
+		wc->normalMass[j][lane] = vcp->normalMass;
+		wc->tangentMass[j][lane] = vcp->tangentMass;
+		wc->velocityBias[j][lane] = vcp->velocityBias;
+	}
+
+	wc->k11[lane] = vc->K.ex.x;
+	wc->k12[lane] = vc->K.ex.y;
+	wc->k22[lane] = vc->K.ey.y;
+	wc->blockMass11[lane] = vc->normalMass.ex.x;
+	wc->blockMass21[lane] = vc->normalMass.ex.y;
+	wc->blockMass12[lane] = vc->normalMass.ey.x;
+	wc->blockMass22[lane] = vc->normalMass.ey.y;
+}
+
+static void b2AddWideLane(b2WidePositionConstraint* wc, const b2ContactPositionConstraint* pc)
+{
+	int32 lane = wc->count++;
+	if (lane == 0)
+	{
+		for (int32 i = 0; i < b2_simdWidth; ++i)
+		{
+			wc->indexA[i] = pc->indexA;
+			wc->indexB[i] = pc->indexB;
+		}
+	}
+
+	wc->indexA[lane] = pc->indexA;
+	wc->indexB[lane] = pc->indexB;
+	wc->invMassA[lane] = pc->invMassA;
+	wc->invMassB[lane] = pc->invMassB;
+	wc->invIA[lane] = pc->invIA;
+	wc->invIB[lane] = pc->invIB;
+	wc->localCenterAX[lane] = pc->localCenterA.x;
+	wc->localCenterAY[lane] = pc->localCenterA.y;
+	wc->localCenterBX[lane] = pc->localCenterB.x;
+	wc->localCenterBY[lane] = pc->localCenterB.y;
+
+	for (int32 j = 0; j < pc->pointCount; ++j)
+	{
+		wc->localPointsX[j][lane] = pc->localPoints[j].x;
+		wc->localPointsY[j][lane] = pc->localPoints[j].y;
+	}
+
+	wc->localNormalX[lane] = pc->localNormal.x;
+	wc->localNormalY[lane] = pc->localNormal.y;
+	wc->localPointX[lane] = pc->localPoint.x;
+	wc->localPointY[lane] = pc->localPoint.y;
+	wc->radiusA[lane] = pc->radiusA;
+	wc->radiusB[lane] = pc->radiusB;
+	wc->faceB[lane] = pc->type == b2Manifold::e_faceB ? 1.0f : 0.0f;
+	wc->pointCount[lane] = float(pc->pointCount);
+}
+
+// Pack the constraints into bundles. This is done once per step, after the velocity
+// constraints are initialized.
+void b2ContactSolver::InitializeWideConstraints()
+{
+	if (m_count < b2_simdWidth)
+	{
+		return;
+	}
+
+	int32 bodyCount = 0;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		bodyCount = b2Max(bodyCount, b2Max(vc->indexA, vc->indexB) + 1);
+	}
+
+	// Greedy coloring, the color array is reused for the overflow list.
+	int32* colors = (int32*)m_allocator->Allocate(m_count * sizeof(int32));
+
+	int32 wordCount = (bodyCount + 31) / 32;
+	int32 bodiesSize = b2_wideColorCount * wordCount * sizeof(uint32);
+	uint32* bodies = (uint32*)m_allocator->Allocate(bodiesSize);
+	memset(bodies, 0, bodiesSize);
+
+	int32 velocityCounts[b2_wideColorCount][b2_maxManifoldPoints] = {};
+	int32 positionCounts[b2_wideColorCount][2] = {};
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		const b2ContactPositionConstraint* pc = m_positionConstraints + i;
+		bool solverA = b2IsSolverBody(vc->invMassA, vc->invIA);
+		bool solverB = b2IsSolverBody(vc->invMassB, vc->invIB);
+
+		colors[i] = -1;
+		for (int32 color = 0; color < b2_wideColorCount; ++color)
+		{
+			uint32* colorBodies = bodies + color * wordCount;
+			if ((solverA && b2IsColorFree(colorBodies, vc->indexA) == false) ||
+				(solverB && b2IsColorFree(colorBodies, vc->indexB) == false))
+			{
+				continue;
+			}
+
+			if (solverA)
+			{
+				b2AddToColor(colorBodies, vc->indexA);
+			}
+
+			if (solverB)
+			{
+				b2AddToColor(colorBodies, vc->indexB);
+			}
+
+			colors[i] = color;
+			velocityCounts[color][vc->pointCount - 1] += 1;
+			positionCounts[color][pc->type == b2Manifold::e_circles ? 0 : 1] += 1;
+			break;
+		}
+	}
+
+	m_allocator->Free(bodies);
+
+	int32 velocityCapacity = 0;
+	int32 positionCapacity = 0;
+	for (int32 color = 0; color < b2_wideColorCount; ++color)
+	{
+		for (int32 group = 0; group < 2; ++group)
+		{
+			velocityCapacity += (velocityCounts[color][group] + b2_simdWidth - 1) / b2_simdWidth;
+			positionCapacity += (positionCounts[color][group] + b2_simdWidth - 1) / b2_simdWidth;
+		}
+	}
+
+	m_wideVelocityConstraints = (b2WideVelocityConstraint*)m_allocator->Allocate(velocityCapacity * sizeof(b2WideVelocityConstraint));
+	m_widePositionConstraints = (b2WidePositionConstraint*)m_allocator->Allocate(positionCapacity * sizeof(b2WidePositionConstraint));
+	memset(m_wideVelocityConstraints, 0, velocityCapacity * sizeof(b2WideVelocityConstraint));
+	memset(m_widePositionConstraints, 0, positionCapacity * sizeof(b2WidePositionConstraint));
+
+	// Bundles of one color are independent, bundles are solved in color order.
+	for (int32 color = 0; color < b2_wideColorCount; ++color)
+	{
+		for (int32 pointCount = 1; pointCount <= b2_maxManifoldPoints; ++pointCount)
+		{
+			b2WideVelocityConstraint* wc = nullptr;
+			for (int32 i = 0; i < m_count; ++i)
+			{
+				const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+				if (colors[i] != color || vc->pointCount != pointCount)
+				{
+					continue;
+				}
+
+				if (wc == nullptr || wc->count == b2_simdWidth)
+				{
+					wc = m_wideVelocityConstraints + m_wideVelocityCount++;
+					wc->pointCount = pointCount;
+				}
+
+				b2AddWideLane(wc, vc, i);
+			}
+		}
+
+		for (int32 group = 0; group < 2; ++group)
+		{
+			bool circles = group == 0;
+
+			b2WidePositionConstraint* wc = nullptr;
+			for (int32 i = 0; i < m_count; ++i)
+			{
+				const b2ContactPositionConstraint* pc = m_positionConstraints + i;
+				if (colors[i] != color || (pc->type == b2Manifold::e_circles) != circles)
+				{
+					continue;
+				}
+
+				if (wc == nullptr || wc->count == b2_simdWidth)
+				{
+					wc = m_widePositionConstraints + m_widePositionCount++;
+					wc->circles = circles;
+				}
+
+				b2AddWideLane(wc, pc);
+			}
+		}
+	}
+
+	b2Assert(m_wideVelocityCount == velocityCapacity);
+	b2Assert(m_widePositionCount == positionCapacity);
+
+	m_overflowConstraints = colors;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		if (colors[i] == -1)
+		{
+			m_overflowConstraints[m_overflowCount++] = i;
+		}
+	}
 }
 
 void b2ContactSolver::WarmStart()
@@ -295,31 +615,80 @@ void b2ContactSolver::WarmStart()
 
 void b2ContactSolver::SolveVelocityConstraints()
 {
+	if (m_wideVelocityConstraints != nullptr)
+	{
+		for (int32 i = 0; i < m_wideVelocityCount; ++i)
+		{
+			SolveWideVelocityConstraint(m_wideVelocityConstraints + i);
+		}
+
+		for (int32 i = 0; i < m_overflowCount; ++i)
+		{
+			SolveVelocityConstraint(m_velocityConstraints + m_overflowConstraints[i]);
+		}
+
+		return;
+	}
+
 	for (int32 i = 0; i < m_count; ++i)
 	{
-		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		SolveVelocityConstraint(m_velocityConstraints + i);
+	}
+}
 
-		int32 indexA = vc->indexA;
-		int32 indexB = vc->indexB;
-		float mA = vc->invMassA;
-		float iA = vc->invIA;
-		float mB = vc->invMassB;
-		float iB = vc->invIB;
-		int32 pointCount = vc->pointCount;
+void b2ContactSolver::SolveVelocityConstraint(b2ContactVelocityConstraint* vc)
+{
+	int32 indexA = vc->indexA;
+	int32 indexB = vc->indexB;
+	float mA = vc->invMassA;
+	float iA = vc->invIA;
+	float mB = vc->invMassB;
+	float iB = vc->invIB;
+	int32 pointCount = vc->pointCount;
+
+	b2Vec2 vA = m_velocities[indexA].v;
+	float wA = m_velocities[indexA].w;
+	b2Vec2 vB = m_velocities[indexB].v;
+	float wB = m_velocities[indexB].w;
+
+	b2Vec2 normal = vc->normal;
+	b2Vec2 tangent = b2Cross(normal, 1.0f);
+	float friction = vc->friction;
+
+	b2Assert(pointCount == 1 || pointCount == 2);
+
+	// Solve tangent constraints first because non-penetration is more important
+	// than friction.
+	for (int32 j = 0; j < pointCount; ++j)
+	{
+		b2VelocityConstraintPoint* vcp = vc->points + j;
 
-		b2Vec2 vA = m_velocities[indexA].v;
-		float wA = m_velocities[indexA].w;
-		b2Vec2 vB = m_velocities[indexB].v;
-		float wB = m_velocities[indexB].w;
+		// Relative velocity at contact
+		b2Vec2 dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
 
-		b2Vec2 normal = vc->normal;
-		b2Vec2 tangent = b2Cross(normal, 1.0f);
-		float friction = vc->friction;
+		// Compute tangent force
+		float vt = b2Dot(dv, tangent) - vc->tangentSpeed;
+		float lambda = vcp->tangentMass * (-vt);
+
+		// b2Clamp the accumulated force
+		float maxFriction = friction * vcp->normalImpulse;
+		float newImpulse = b2Clamp(vcp->tangentImpulse + lambda, -maxFriction, maxFriction);
+		lambda = newImpulse - vcp->tangentImpulse;
+		vcp->tangentImpulse = newImpulse;
+
+		// Apply contact impulse
+		b2Vec2 P = lambda * tangent;
+
+		vA -= mA * P;
+		wA -= iA * b2Cross(vcp->rA, P);
 
-		b2Assert(pointCount == 1 || pointCount == 2);
+		vB += mB * P;
+		wB += iB * b2Cross(vcp->rB, P);
+	}
 
-		// Solve tangent constraints first because non-penetration is more important
-		// than friction.
+	// Solve normal constraints
+	if (pointCount == 1 || g_blockSolve == false)
+	{
 		for (int32 j = 0; j < pointCount; ++j)
 		{
 			b2VelocityConstraintPoint* vcp = vc->points + j;
@@ -327,286 +696,484 @@ void b2ContactSolver::SolveVelocityConstraints()
 			// Relative velocity at contact
 			b2Vec2 dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
 
-			// Compute tangent force
-			float vt = b2Dot(dv, tangent) - vc->tangentSpeed;
-			float lambda = vcp->tangentMass * (-vt);
+			// Compute normal impulse
+			float vn = b2Dot(dv, normal);
+			float lambda = -vcp->normalMass * (vn - vcp->velocityBias);
 
-			// b2Clamp the accumulated force
-			float maxFriction = friction * vcp->normalImpulse;
-			float newImpulse = b2Clamp(vcp->tangentImpulse + lambda, -maxFriction, maxFriction);
-			lambda = newImpulse - vcp->tangentImpulse;
-			vcp->tangentImpulse = newImpulse;
+			// b2Clamp the accumulated impulse
+			float newImpulse = b2Max(vcp->normalImpulse + lambda, 0.0f);
+			lambda = newImpulse - vcp->normalImpulse;
+			vcp->normalImpulse = newImpulse;
 
 			// Apply contact impulse
-			b2Vec2 P = lambda * tangent;
-
+			b2Vec2 P = lambda * normal;
 			vA -= mA * P;
 			wA -= iA * b2Cross(vcp->rA, P);
 
 			vB += mB * P;
 			wB += iB * b2Cross(vcp->rB, P);
 		}
-
-		// Solve normal constraints
-		if (pointCount == 1 || g_blockSolve == false)
-		{
-			for (int32 j = 0; j < pointCount; ++j)
-			{
-				b2VelocityConstraintPoint* vcp = vc->points + j;
-
-				// Relative velocity at contact
-				b2Vec2 dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
-
-				// Compute normal impulse
-				float vn = b2Dot(dv, normal);
-				float lambda = -vcp->normalMass * (vn - vcp->velocityBias);
-
-				// b2Clamp the accumulated impulse
-				float newImpulse = b2Max(vcp->normalImpulse + lambda, 0.0f);
-				lambda = newImpulse - vcp->normalImpulse;
-				vcp->normalImpulse = newImpulse;
-
-				// Apply contact impulse
-				b2Vec2 P = lambda * normal;
-				vA -= mA * P;
-				wA -= iA * b2Cross(vcp->rA, P);
-
-				vB += mB * P;
-				wB += iB * b2Cross(vcp->rB, P);
-			}
-		}
-		else
+	}
+	else
+	{
+		// Block solver developed in collaboration with Dirk Gregorius (back in 01/07 on Box2D_Lite).
+		// Build the mini LCP for this contact patch
+		//
+		// vn = A * x + b, vn >= 0, x >= 0 and vn_i * x_i = 0 with i = 1..2
+		//
+		// A = J * W * JT and J = ( -n, -r1 x n, n, r2 x n )
+		// b = vn0 - velocityBias
+		//
+		// The system is solved using the "Total enumeration method" (s. Murty). The complementary constraint vn_i * x_i
+		// implies that we must have in any solution either vn_i = 0 or x_i = 0. So for the 2D contact problem the cases
+		// vn1 = 0 and vn2 = 0, x1 = 0 and x2 = 0, x1 = 0 and vn2 = 0, x2 = 0 and vn1 = 0 need to be tested. The first valid
+		// solution that satisfies the problem is chosen.
+		// 
+		// In order to account of the accumulated impulse 'a' (because of the iterative nature of the solver which only requires
+		// that the accumulated impulse is clamped and not the incremental impulse) we change the impulse variable (x_i).
+		//
+		// Substitute:
+		// 
+		// x = a + d
+		// 
+		// a := old total impulse
+		// x := new total impulse
+		// d := incremental impulse 
+		//
+		// For the current iteration we extend the formula for the incremental impulse
+		// to compute the new total impulse:
+		//
+		// vn = A * d + b
+		//    = A * (x - a) + b
+		//    = A * x + b - A * a
+		//    = A * x + b'
+		// b' = b - A * a;
+
+		b2VelocityConstraintPoint* cp1 = vc->points + 0;
+		b2VelocityConstraintPoint* cp2 = vc->points + 1;
+
+		b2Vec2 a(cp1->normalImpulse, cp2->normalImpulse);
+		b2Assert(a.x >= 0.0f && a.y >= 0.0f);
+
+		// Relative velocity at contact
+		b2Vec2 dv1 = vB + b2Cross(wB, cp1->rB) - vA - b2Cross(wA, cp1->rA);
+		b2Vec2 dv2 = vB + b2Cross(wB, cp2->rB) - vA - b2Cross(wA, cp2->rA);
+
+		// Compute normal velocity
+		float vn1 = b2Dot(dv1, normal);
+		float vn2 = b2Dot(dv2, normal);
+
+		b2Vec2 b;
+		b.x = vn1 - cp1->velocityBias;
+		b.y = vn2 - cp2->velocityBias;
+
+		// Compute b'
+		b -= b2Mul(vc->K, a);
+
+		const float k_errorTol = 1e-3f;
+		B2_NOT_USED(k_errorTol);
+
+		for (;;)
 		{
-			// Block solver developed in collaboration with Dirk Gregorius (back in 01/07 on Box2D_Lite).
-			// Build the mini LCP for this contact patch
 			//
-			// vn = A * x + b, vn >= 0, x >= 0 and vn_i * x_i = 0 with i = 1..2
+			// Case 1: vn = 0
 			//
-			// A = J * W * JT and J = ( -n, -r1 x n, n, r2 x n )
-			// b = vn0 - velocityBias
+			// 0 = A * x + b'
 			//
-			// The system is solved using the "Total enumeration method" (s. Murty). The complementary constraint vn_i * x_i
-			// implies that we must have in any solution either vn_i = 0 or x_i = 0. So for the 2D contact problem the cases
-			// vn1 = 0 and vn2 = 0, x1 = 0 and x2 = 0, x1 = 0 and vn2 = 0, x2 = 0 and vn1 = 0 need to be tested. The first valid
-			// solution that satisfies the problem is chosen.
-			// 
-			// In order to account of the accumulated impulse 'a' (because of the iterative nature of the solver which only requires
-			// that the accumulated impulse is clamped and not the incremental impulse) we change the impulse variable (x_i).
-			//
-			// Substitute:
-			// 
-			// x = a + d
-			// 
-			// a := old total impulse
-			// x := new total impulse
-			// d := incremental impulse 
+			// Solve for x:
 			//
-			// For the current iteration we extend the formula for the incremental impulse
-			// to compute the new total impulse:
+			// x = - inv(A) * b'
 			//
-			// vn = A * d + b
-			//    = A * (x - a) + b
-			//    = A * x + b - A * a
-			//    = A * x + b'
-			// b' = b - A * a;
+			b2Vec2 x = - b2Mul(vc->normalMass, b);
 
-			b2VelocityConstraintPoint* cp1 = vc->points + 0;
-			b2VelocityConstraintPoint* cp2 = vc->points + 1;
+			if (x.x >= 0.0f && x.y >= 0.0f)
+			{
+				// Get the incremental impulse
+				b2Vec2 d = x - a;
 
-			b2Vec2 a(cp1->normalImpulse, cp2->normalImpulse);
-			b2Assert(a.x >= 0.0f && a.y >= 0.0f);
+				// Apply incremental impulse
+				b2Vec2 P1 = d.x * normal;
+				b2Vec2 P2 = d.y * normal;
+				vA -= mA * (P1 + P2);
+				wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
 
-			// Relative velocity at contact
-			b2Vec2 dv1 = vB + b2Cross(wB, cp1->rB) - vA - b2Cross(wA, cp1->rA);
-			b2Vec2 dv2 = vB + b2Cross(wB, cp2->rB) - vA - b2Cross(wA, cp2->rA);
+				vB += mB * (P1 + P2);
+				wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
 
-			// Compute normal velocity
-			float vn1 = b2Dot(dv1, normal);
-			float vn2 = b2Dot(dv2, normal);
+				// Accumulate
+				cp1->normalImpulse = x.x;
+				cp2->normalImpulse = x.y;
 
-			b2Vec2 b;
-			b.x = vn1 - cp1->velocityBias;
-			b.y = vn2 - cp2->velocityBias;
+#if B2_DEBUG_SOLVER == 1
+				// Postconditions
+				dv1 = vB + b2Cross(wB, cp1->rB) - vA - b2Cross(wA, cp1->rA);
+				dv2 = vB + b2Cross(wB, cp2->rB) - vA - b2Cross(wA, cp2->rA);
 
-			// Compute b'
-			b -= b2Mul(vc->K, a);
+				// Compute normal velocity
+				vn1 = b2Dot(dv1, normal);
+				vn2 = b2Dot(dv2, normal);
 
-			const float k_errorTol = 1e-3f;
-			B2_NOT_USED(k_errorTol);
+				b2Assert(b2Abs(vn1 - cp1->velocityBias) < k_errorTol);
+				b2Assert(b2Abs(vn2 - cp2->velocityBias) < k_errorTol);
+#endif
+				break;
+			}
 
-			for (;;)
+			//
+			// Case 2: vn1 = 0 and x2 = 0
+			//
+			//   0 = a11 * x1 + a12 * 0 + b1' 
+			// vn2 = a21 * x1 + a22 * 0 + b2'
+			//
+			x.x = - cp1->normalMass * b.x;
+			x.y = 0.0f;
+			vn1 = 0.0f;
+			vn2 = vc->K.ex.y * x.x + b.y;
+			if (x.x >= 0.0f && vn2 >= 0.0f)
 			{
-				//
-				// Case 1: vn = 0
-				//
-				// 0 = A * x + b'
-				//
-				// Solve for x:
-				//
-				// x = - inv(A) * b'
-				//
-				b2Vec2 x = - b2Mul(vc->normalMass, b);
-
-				if (x.x >= 0.0f && x.y >= 0.0f)
-				{
-					// Get the incremental impulse
-					b2Vec2 d = x - a;
+				// Get the incremental impulse
+				b2Vec2 d = x - a;
 
-					// Apply incremental impulse
-					b2Vec2 P1 = d.x * normal;
-					b2Vec2 P2 = d.y * normal;
-					vA -= mA * (P1 + P2);
-					wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
+				// Apply incremental impulse
+				b2Vec2 P1 = d.x * normal;
+				b2Vec2 P2 = d.y * normal;
+				vA -= mA * (P1 + P2);
+				wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
 
-					vB += mB * (P1 + P2);
-					wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
+				vB += mB * (P1 + P2);
+				wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
 
-					// Accumulate
-					cp1->normalImpulse = x.x;
-					cp2->normalImpulse = x.y;
+				// Accumulate
+				cp1->normalImpulse = x.x;
+				cp2->normalImpulse = x.y;
 
 #if B2_DEBUG_SOLVER == 1
-					// Postconditions
-					dv1 = vB + b2Cross(wB, cp1->rB) - vA - b2Cross(wA, cp1->rA);
-					dv2 = vB + b2Cross(wB, cp2->rB) - vA - b2Cross(wA, cp2->rA);
+				// Postconditions
+				dv1 = vB + b2Cross(wB, cp1->rB) - vA - b2Cross(wA, cp1->rA);
 
-					// Compute normal velocity
-					vn1 = b2Dot(dv1, normal);
-					vn2 = b2Dot(dv2, normal);
+				// Compute normal velocity
+				vn1 = b2Dot(dv1, normal);
 
-					b2Assert(b2Abs(vn1 - cp1->velocityBias) < k_errorTol);
-					b2Assert(b2Abs(vn2 - cp2->velocityBias) < k_errorTol);
+				b2Assert(b2Abs(vn1 - cp1->velocityBias) < k_errorTol);
 #endif
-					break;
-				}
+				break;
+			}
 
-				//
-				// Case 2: vn1 = 0 and x2 = 0
-				//
-				//   0 = a11 * x1 + a12 * 0 + b1' 
-				// vn2 = a21 * x1 + a22 * 0 + b2'
-				//
-				x.x = - cp1->normalMass * b.x;
-				x.y = 0.0f;
-				vn1 = 0.0f;
-				vn2 = vc->K.ex.y * x.x + b.y;
-				if (x.x >= 0.0f && vn2 >= 0.0f)
-				{
-					// Get the incremental impulse
-					b2Vec2 d = x - a;
 
-					// Apply incremental impulse
-					b2Vec2 P1 = d.x * normal;
-					b2Vec2 P2 = d.y * normal;
-					vA -= mA * (P1 + P2);
-					wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
+			//
+			// Case 3: vn2 = 0 and x1 = 0
+			//
+			// vn1 = a11 * 0 + a12 * x2 + b1' 
+			//   0 = a21 * 0 + a22 * x2 + b2'
+			//
+			x.x = 0.0f;
+			x.y = - cp2->normalMass * b.y;
+			vn1 = vc->K.ey.x * x.y + b.x;
+			vn2 = 0.0f;
+
+			if (x.y >= 0.0f && vn1 >= 0.0f)
+			{
+				// Resubstitute for the incremental impulse
+				b2Vec2 d = x - a;
+
+				// Apply incremental impulse
+				b2Vec2 P1 = d.x * normal;
+				b2Vec2 P2 = d.y * normal;
+				vA -= mA * (P1 + P2);
+				wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
 
-					vB += mB * (P1 + P2);
-					wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
+				vB += mB * (P1 + P2);
+				wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
 
-					// Accumulate
-					cp1->normalImpulse = x.x;
-					cp2->normalImpulse = x.y;
+				// Accumulate
+				cp1->normalImpulse = x.x;
+				cp2->normalImpulse = x.y;
 
 #if B2_DEBUG_SOLVER == 1
-					// Postconditions
-					dv1 = vB + b2Cross(wB, cp1->rB) - vA - b2Cross(wA, cp1->rA);
+				// Postconditions
+				dv2 = vB + b2Cross(wB, cp2->rB) - vA - b2Cross(wA, cp2->rA);
 
-					// Compute normal velocity
-					vn1 = b2Dot(dv1, normal);
+				// Compute normal velocity
+				vn2 = b2Dot(dv2, normal);
 
-					b2Assert(b2Abs(vn1 - cp1->velocityBias) < k_errorTol);
+				b2Assert(b2Abs(vn2 - cp2->velocityBias) < k_errorTol);
 #endif
-					break;
-				}
-
+				break;
+			}
 
-				//
-				// Case 3: vn2 = 0 and x1 = 0
-				//
-				// vn1 = a11 * 0 + a12 * x2 + b1' 
-				//   0 = a21 * 0 + a22 * x2 + b2'
-				//
-				x.x = 0.0f;
-				x.y = - cp2->normalMass * b.y;
-				vn1 = vc->K.ey.x * x.y + b.x;
-				vn2 = 0.0f;
+			//
+			// Case 4: x1 = 0 and x2 = 0
+			// 
+			// vn1 = b1
+			// vn2 = b2;
+			x.x = 0.0f;
+			x.y = 0.0f;
+			vn1 = b.x;
+			vn2 = b.y;
+
+			if (vn1 >= 0.0f && vn2 >= 0.0f )
+			{
+				// Resubstitute for the incremental impulse
+				b2Vec2 d = x - a;
 
-				if (x.y >= 0.0f && vn1 >= 0.0f)
-				{
-					// Resubstitute for the incremental impulse
-					b2Vec2 d = x - a;
+				// Apply incremental impulse
+				b2Vec2 P1 = d.x * normal;
+				b2Vec2 P2 = d.y * normal;
+				vA -= mA * (P1 + P2);
+				wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
 
-					// Apply incremental impulse
-					b2Vec2 P1 = d.x * normal;
-					b2Vec2 P2 = d.y * normal;
-					vA -= mA * (P1 + P2);
-					wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
+				vB += mB * (P1 + P2);
+				wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
 
-					vB += mB * (P1 + P2);
-					wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
+				// Accumulate
+				cp1->normalImpulse = x.x;
+				cp2->normalImpulse = x.y;
 
-					// Accumulate
-					cp1->normalImpulse = x.x;
-					cp2->normalImpulse = x.y;
+				break;
+			}
 
-#if B2_DEBUG_SOLVER == 1
-					// Postconditions
-					dv2 = vB + b2Cross(wB, cp2->rB) - vA - b2Cross(wA, cp2->rA);
+			// No solution, give up. This is hit sometimes, but it doesn't seem to matter.
+			break;
+		}
+	}
 
-					// Compute normal velocity
-					vn2 = b2Dot(dv2, normal);
+	m_velocities[indexA].v = vA;
+	m_velocities[indexA].w = wA;
+	m_velocities[indexB].v = vB;
+	m_velocities[indexB].w = wB;
+}
 
-					b2Assert(b2Abs(vn2 - cp2->velocityBias) < k_errorTol);
-#endif
-					break;
-				}
+// Wide version of SolveVelocityConstraint, same operations in the same order on all lanes.
+void b2ContactSolver::SolveWideVelocityConstraint(b2WideVelocityConstraint* wc)
+{
+	float velocities[6][b2_simdWidth];
+	for (int32 lane = 0; lane < b2_simdWidth; ++lane)
+	{
+		const b2Velocity& velocityA = m_velocities[wc->indexA[lane]];
+		const b2Velocity& velocityB = m_velocities[wc->indexB[lane]];
+		velocities[0][lane] = velocityA.v.x;
+		velocities[1][lane] = velocityA.v.y;
+		velocities[2][lane] = velocityA.w;
+		velocities[3][lane] = velocityB.v.x;
+		velocities[4][lane] = velocityB.v.y;
+		velocities[5][lane] = velocityB.w;
+	}
 
-				//
-				// Case 4: x1 = 0 and x2 = 0
-				// 
-				// vn1 = b1
-				// vn2 = b2;
-				x.x = 0.0f;
-				x.y = 0.0f;
-				vn1 = b.x;
-				vn2 = b.y;
-
-				if (vn1 >= 0.0f && vn2 >= 0.0f )
-				{
-					// Resubstitute for the incremental impulse
-					b2Vec2 d = x - a;
+	b2FloatW vAX = b2LoadW(velocities[0]);
+	b2FloatW vAY = b2LoadW(velocities[1]);
+	b2FloatW wA = b2LoadW(velocities[2]);
+	b2FloatW vBX = b2LoadW(velocities[3]);
+	b2FloatW vBY = b2LoadW(velocities[4]);
+	b2FloatW wB = b2LoadW(velocities[5]);
+
+	b2FloatW mA = b2LoadW(wc->invMassA);
+	b2FloatW iA = b2LoadW(wc->invIA);
+	b2FloatW mB = b2LoadW(wc->invMassB);
+	b2FloatW iB = b2LoadW(wc->invIB);
+	int32 pointCount = wc->pointCount;
+
+	b2FloatW normalX = b2LoadW(wc->normalX);
+	b2FloatW normalY = b2LoadW(wc->normalY);
+	b2FloatW tangentX = normalY;
+	b2FloatW tangentY = -normalX;
+	b2FloatW friction = b2LoadW(wc->friction);
+	b2FloatW tangentSpeed = b2LoadW(wc->tangentSpeed);
+	b2FloatW zero = b2SplatW(0.0f);
+
+	// Solve tangent constraints first because non-penetration is more important
+	// than friction.
+	for (int32 j = 0; j < pointCount; ++j)
+	{
+		b2FloatW rAX = b2LoadW(wc->rAX[j]);
+		b2FloatW rAY = b2LoadW(wc->rAY[j]);
+		b2FloatW rBX = b2LoadW(wc->rBX[j]);
+		b2FloatW rBY = b2LoadW(wc->rBY[j]);
+
+		// Relative velocity at contact
+		b2FloatW dvX = vBX - wB * rBY - vAX + wA * rAY;
+		b2FloatW dvY = vBY + wB * rBX - vAY - wA * rAX;
+
+		// Compute tangent force
+		b2FloatW vt = dvX * tangentX + dvY * tangentY - tangentSpeed;
+		b2FloatW lambda = b2LoadW(wc->tangentMass[j]) * (-vt);
+
+		// b2Clamp the accumulated force
+		b2FloatW tangentImpulse = b2LoadW(wc->tangentImpulse[j]);
+		b2FloatW maxFriction = friction * b2LoadW(wc->normalImpulse[j]);
+		b2FloatW newImpulse = b2MaxW(-maxFriction, b2MinW(tangentImpulse + lambda, maxFriction));
+		lambda = newImpulse - tangentImpulse;
+		b2StoreW(wc->tangentImpulse[j], newImpulse);
+
+		// Apply contact impulse
+		b2FloatW PX = lambda * tangentX;
+		b2FloatW PY = lambda * tangentY;
+
+		vAX = vAX - mA * PX;
+		vAY = vAY - mA * PY;
+		wA = wA - iA * (rAX * PY - rAY * PX);
+
+		vBX = vBX + mB * PX;
+		vBY = vBY + mB * PY;
+		wB = wB + iB * (rBX * PY - rBY * PX);
+	}
 
-					// Apply incremental impulse
-					b2Vec2 P1 = d.x * normal;
-					b2Vec2 P2 = d.y * normal;
-					vA -= mA * (P1 + P2);
-					wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
+	// Solve normal constraints
+	if (pointCount == 1 || g_blockSolve == false)
+	{
+		for (int32 j = 0; j < pointCount; ++j)
+		{
+			b2FloatW rAX = b2LoadW(wc->rAX[j]);
+			b2FloatW rAY = b2LoadW(wc->rAY[j]);
+			b2FloatW rBX = b2LoadW(wc->rBX[j]);
+			b2FloatW rBY = b2LoadW(wc->rBY[j]);
 
-					vB += mB * (P1 + P2);
-					wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
+			// Relative velocity at contact
+			b2FloatW dvX = vBX - wB * rBY - vAX + wA * rAY;
+			b2FloatW dvY = vBY + wB * rBX - vAY - wA * rAX;
 
-					// Accumulate
-					cp1->normalImpulse = x.x;
-					cp2->normalImpulse = x.y;
+			// Compute normal impulse
+			b2FloatW vn = dvX * normalX + dvY * normalY;
+			b2FloatW lambda = -b2LoadW(wc->normalMass[j]) * (vn - b2LoadW(wc->velocityBias[j]));
 
-					break;
-				}
+			// b2Clamp the accumulated impulse
+			b2FloatW normalImpulse = b2LoadW(wc->normalImpulse[j]);
+			b2FloatW newImpulse = b2MaxW(normalImpulse + lambda, zero);
+			lambda = newImpulse - normalImpulse;
+			b2StoreW(wc->normalImpulse[j], newImpulse);
 
-				// No solution, give up. This is hit sometimes, but it doesn't seem to matter.
-				break;
-			}
+			// Apply contact impulse
+			b2FloatW PX = lambda * normalX;
+			b2FloatW PY = lambda * normalY;
+			vAX = vAX - mA * PX;
+			vAY = vAY - mA * PY;
+			wA = wA - iA * (rAX * PY - rAY * PX);
+
+			vBX = vBX + mB * PX;
+			vBY = vBY + mB * PY;
+			wB = wB + iB * (rBX * PY - rBY * PX);
 		}
+	}
+	else
+	{
+		// Block solver, see SolveVelocityConstraint. All four cases are evaluated and
+		// each lane takes the first valid solution.
+		b2FloatW r1AX = b2LoadW(wc->rAX[0]);
+		b2FloatW r1AY = b2LoadW(wc->rAY[0]);
+		b2FloatW r1BX = b2LoadW(wc->rBX[0]);
+		b2FloatW r1BY = b2LoadW(wc->rBY[0]);
+		b2FloatW r2AX = b2LoadW(wc->rAX[1]);
+		b2FloatW r2AY = b2LoadW(wc->rAY[1]);
+		b2FloatW r2BX = b2LoadW(wc->rBX[1]);
+		b2FloatW r2BY = b2LoadW(wc->rBY[1]);
+
+		b2FloatW aX = b2LoadW(wc->normalImpulse[0]);
+		b2FloatW aY = b2LoadW(wc->normalImpulse[1]);
+
+		// Relative velocity at contact
+		b2FloatW dv1X = vBX - wB * r1BY - vAX + wA * r1AY;
+		b2FloatW dv1Y = vBY + wB * r1BX - vAY - wA * r1AX;
+		b2FloatW dv2X = vBX - wB * r2BY - vAX + wA * r2AY;
+		b2FloatW dv2Y = vBY + wB * r2BX - vAY - wA * r2AX;
+
+		// Compute normal velocity
+		b2FloatW vn1 = dv1X * normalX + dv1Y * normalY;
+		b2FloatW vn2 = dv2X * normalX + dv2Y * normalY;
+
+		b2FloatW k11 = b2LoadW(wc->k11);
+		b2FloatW k12 = b2LoadW(wc->k12);
+		b2FloatW k22 = b2LoadW(wc->k22);
+
+		// Compute b'
+		b2FloatW bX = vn1 - b2LoadW(wc->velocityBias[0]);
+		b2FloatW bY = vn2 - b2LoadW(wc->velocityBias[1]);
+		bX = bX - (k11 * aX + k12 * aY);
+		bY = bY - (k12 * aX + k22 * aY);
+
+		// Case 1: vn = 0
+		b2FloatW x1X = -(b2LoadW(wc->blockMass11) * bX + b2LoadW(wc->blockMass12) * bY);
+		b2FloatW x1Y = -(b2LoadW(wc->blockMass21) * bX + b2LoadW(wc->blockMass22) * bY);
+		b2MaskW case1 = b2AndW(b2GreaterEqualW(x1X, zero), b2GreaterEqualW(x1Y, zero));
+
+		// Case 2: vn1 = 0 and x2 = 0
+		b2FloatW x2X = -b2LoadW(wc->normalMass[0]) * bX;
+		b2FloatW case2Vn2 = k12 * x2X + bY;
+		b2MaskW case2 = b2AndW(b2GreaterEqualW(x2X, zero), b2GreaterEqualW(case2Vn2, zero));
+
+		// Case 3: vn2 = 0 and x1 = 0
+		b2FloatW x3Y = -b2LoadW(wc->normalMass[1]) * bY;
+		b2FloatW case3Vn1 = k12 * x3Y + bX;
+		b2MaskW case3 = b2AndW(b2GreaterEqualW(x3Y, zero), b2GreaterEqualW(case3Vn1, zero));
+
+		// Case 4: x1 = 0 and x2 = 0
+		b2MaskW case4 = b2AndW(b2GreaterEqualW(bX, zero), b2GreaterEqualW(bY, zero));
+
+		// No solution keeps the accumulated impulse.
+		b2FloatW xX = b2SelectW(case4, zero, aX);
+		b2FloatW xY = b2SelectW(case4, zero, aY);
+		xX = b2SelectW(case3, zero, xX);
+		xY = b2SelectW(case3, x3Y, xY);
+		xX = b2SelectW(case2, x2X, xX);
+		xY = b2SelectW(case2, zero, xY);
+		xX = b2SelectW(case1, x1X, xX);
+		xY = b2SelectW(case1, x1Y, xY);
+
+		// Get the incremental impulse
+		b2FloatW dX = xX - aX;
+		b2FloatW dY = xY - aY;
+
+		// Apply incremental impulse
+		b2FloatW P1X = dX * normalX;
+		b2FloatW P1Y = dX * normalY;
+		b2FloatW P2X = dY * normalX;
+		b2FloatW P2Y = dY * normalY;
+		vAX = vAX - mA * (P1X + P2X);
+		vAY = vAY - mA * (P1Y + P2Y);
+		wA = wA - iA * ((r1AX * P1Y - r1AY * P1X) + (r2AX * P2Y - r2AY * P2X));
+
+		vBX = vBX + mB * (P1X + P2X);
+		vBY = vBY + mB * (P1Y + P2Y);
+		wB = wB + iB * ((r1BX * P1Y - r1BY * P1X) + (r2BX * P2Y - r2BY * P2X));
+
+		// Accumulate
+		b2StoreW(wc->normalImpulse[0], xX);
+		b2StoreW(wc->normalImpulse[1], xY);
+	}
 
-		m_velocities[indexA].v = vA;
-		m_velocities[indexA].w = wA;
-		m_velocities[indexB].v = vB;
-		m_velocities[indexB].w = wB;
+	b2StoreW(velocities[0], vAX);
+	b2StoreW(velocities[1], vAY);
+	b2StoreW(velocities[2], wA);
+	b2StoreW(velocities[3], vBX);
+	b2StoreW(velocities[4], vBY);
+	b2StoreW(velocities[5], wB);
+
+	for (int32 lane = 0; lane < wc->count; ++lane)
+	{
+		b2Velocity& velocityA = m_velocities[wc->indexA[lane]];
+		b2Velocity& velocityB = m_velocities[wc->indexB[lane]];
+		velocityA.v.Set(velocities[0][lane], velocities[1][lane]);
+		velocityA.w = velocities[2][lane];
+		velocityB.v.Set(velocities[3][lane], velocities[4][lane]);
+		velocityB.w = velocities[5][lane];
 	}
 }
 
 void b2ContactSolver::StoreImpulses()
 {
+	// b2Island::Report reads the impulses from the velocity constraints.
+	for (int32 i = 0; i < m_wideVelocityCount; ++i)
+	{
+		const b2WideVelocityConstraint* wc = m_wideVelocityConstraints + i;
+		for (int32 lane = 0; lane < wc->count; ++lane)
+		{
+			b2ContactVelocityConstraint* vc = m_velocityConstraints + wc->constraintIndex[lane];
+			for (int32 j = 0; j < wc->pointCount; ++j)
+			{
+				vc->points[j].normalImpulse = wc->normalImpulse[j][lane];
+				vc->points[j].tangentImpulse = wc->tangentImpulse[j][lane];
+			}
+		}
+	}
+
 	for (int32 i = 0; i < m_count; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
@@ -622,7 +1189,7 @@ void b2ContactSolver::StoreImpulses()
 
 struct b2PositionSolverManifold
 {
-	void Initialize(b2ContactPositionConstraint* pc, const b2Transform& xfA, const b2Transform& xfB, int32 index)
+	void Initialize(const b2ContactPositionConstraint* pc, const b2Transform& xfA, const b2Transform& xfB, int32 index)
 	{
 		b2Assert(pc->pointCount > 0);
 
@@ -676,78 +1243,294 @@ bool b2ContactSolver::SolvePositionConstraints()
 {
 	float minSeparation = 0.0f;
 
-	for (int32 i = 0; i < m_count; ++i)
+	if (m_widePositionConstraints != nullptr)
 	{
-		b2ContactPositionConstraint* pc = m_positionConstraints + i;
+		for (int32 i = 0; i < m_widePositionCount; ++i)
+		{
+			minSeparation = b2Min(minSeparation, SolveWidePositionConstraint(m_widePositionConstraints + i));
+		}
 
-		int32 indexA = pc->indexA;
-		int32 indexB = pc->indexB;
-		b2Vec2 localCenterA = pc->localCenterA;
-		float mA = pc->invMassA;
-		float iA = pc->invIA;
-		b2Vec2 localCenterB = pc->localCenterB;
-		float mB = pc->invMassB;
-		float iB = pc->invIB;
-		int32 pointCount = pc->pointCount;
+		for (int32 i = 0; i < m_overflowCount; ++i)
+		{
+			minSeparation = b2Min(minSeparation, SolvePositionConstraint(m_positionConstraints + m_overflowConstraints[i]));
+		}
+	}
+	else
+	{
+		for (int32 i = 0; i < m_count; ++i)
+		{
+			minSeparation = b2Min(minSeparation, SolvePositionConstraint(m_positionConstraints + i));
+		}
+	}
 
-		b2Vec2 cA = m_positions[indexA].c;
-		float aA = m_positions[indexA].a;
+	// We can't expect minSpeparation >= -b2_linearSlop because we don't
+	// push the separation above -b2_linearSlop.
+	return minSeparation >= -3.0f * b2_linearSlop;
+}
 
-		b2Vec2 cB = m_positions[indexB].c;
-		float aB = m_positions[indexB].a;
+// Returns the minimum separation of the constraint, at most zero.
+float b2ContactSolver::SolvePositionConstraint(const b2ContactPositionConstraint* pc)
+{
+	float minSeparation = 0.0f;
 
-		// Solve normal constraints
-		for (int32 j = 0; j < pointCount; ++j)
-		{
-			b2Transform xfA, xfB;
-			xfA.q.Set(aA);
-			xfB.q.Set(aB);
-			xfA.p = cA - b2Mul(xfA.q, localCenterA);
-			xfB.p = cB - b2Mul(xfB.q, localCenterB);
+	int32 indexA = pc->indexA;
+	int32 indexB = pc->indexB;
+	b2Vec2 localCenterA = pc->localCenterA;
+	float mA = pc->invMassA;
+	float iA = pc->invIA;
+	b2Vec2 localCenterB = pc->localCenterB;
+	float mB = pc->invMassB;
+	float iB = pc->invIB;
+	int32 pointCount = pc->pointCount;
 
-			b2PositionSolverManifold psm;
-			psm.Initialize(pc, xfA, xfB, j);
-			b2Vec2 normal = psm.normal;
+	b2Vec2 cA = m_positions[indexA].c;
+	float aA = m_positions[indexA].a;
 
-			b2Vec2 point = psm.point;
-			float separation = psm.separation;
+	b2Vec2 cB = m_positions[indexB].c;
+	float aB = m_positions[indexB].a;
 
-			b2Vec2 rA = point - cA;
-			b2Vec2 rB = point - cB;
+	// Solve normal constraints
+	for (int32 j = 0; j < pointCount; ++j)
+	{
+		b2Transform xfA, xfB;
+		xfA.q.Set(aA);
+		xfB.q.Set(aB);
+		xfA.p = cA - b2Mul(xfA.q, localCenterA);
+		xfB.p = cB - b2Mul(xfB.q, localCenterB);
 
-			// Track max constraint error.
-			minSeparation = b2Min(minSeparation, separation);
+		b2PositionSolverManifold psm;
+		psm.Initialize(pc, xfA, xfB, j);
+		b2Vec2 normal = psm.normal;
 
-			// Prevent large corrections and allow slop.
-			float C = b2Clamp(b2_baumgarte * (separation + b2_linearSlop), -b2_maxLinearCorrection, 0.0f);
+		b2Vec2 point = psm.point;
+		float separation = psm.separation;
 
-			// Compute the effective mass.
-			float rnA = b2Cross(rA, normal);
-			float rnB = b2Cross(rB, normal);
-			float K = mA + mB + iA * rnA * rnA + iB * rnB * rnB;
+		b2Vec2 rA = point - cA;
+		b2Vec2 rB = point - cB;
 
-			// Compute normal impulse
-			float impulse = K > 0.0f ? - C / K : 0.0f;
+		// Track max constraint error.
+		minSeparation = b2Min(minSeparation, separation);
 
-			b2Vec2 P = impulse * normal;
+		// Prevent large corrections and allow slop.
+		float C = b2Clamp(b2_baumgarte * (separation + b2_linearSlop), -b2_maxLinearCorrection, 0.0f);
 
-			cA -= mA * P;
-			aA -= iA * b2Cross(rA, P);
+		// Compute the effective mass.
+		float rnA = b2Cross(rA, normal);
+		float rnB = b2Cross(rB, normal);
+		float K = mA + mB + iA * rnA * rnA + iB * rnB * rnB;
 
-			cB += mB * P;
-			aB += iB * b2Cross(rB, P);
+		// Compute normal impulse
+		float impulse = K > 0.0f ? - C / K : 0.0f;
+
+		b2Vec2 P = impulse * normal;
+
+		cA -= mA * P;
+		aA -= iA * b2Cross(rA, P);
+
+		cB += mB * P;
+		aB += iB * b2Cross(rB, P);
+	}
+
+	m_positions[indexA].c = cA;
+	m_positions[indexA].a = aA;
+
+	m_positions[indexB].c = cB;
+	m_positions[indexB].a = aB;
+
+	return minSeparation;
+}
+
+// Wide version of SolvePositionConstraint. Lanes of face bundles take the reference face from
+// body A or B, lanes with a single point skip the second point.
+float b2ContactSolver::SolveWidePositionConstraint(const b2WidePositionConstraint* wc)
+{
+	float positions[6][b2_simdWidth];
+	for (int32 lane = 0; lane < b2_simdWidth; ++lane)
+	{
+		const b2Position& positionA = m_positions[wc->indexA[lane]];
+		const b2Position& positionB = m_positions[wc->indexB[lane]];
+		positions[0][lane] = positionA.c.x;
+		positions[1][lane] = positionA.c.y;
+		positions[2][lane] = positionA.a;
+		positions[3][lane] = positionB.c.x;
+		positions[4][lane] = positionB.c.y;
+		positions[5][lane] = positionB.a;
+	}
+
+	b2FloatW cAX = b2LoadW(positions[0]);
+	b2FloatW cAY = b2LoadW(positions[1]);
+	b2FloatW aA = b2LoadW(positions[2]);
+	b2FloatW cBX = b2LoadW(positions[3]);
+	b2FloatW cBY = b2LoadW(positions[4]);
+	b2FloatW aB = b2LoadW(positions[5]);
+
+	b2FloatW localCenterAX = b2LoadW(wc->localCenterAX);
+	b2FloatW localCenterAY = b2LoadW(wc->localCenterAY);
+	b2FloatW localCenterBX = b2LoadW(wc->localCenterBX);
+	b2FloatW localCenterBY = b2LoadW(wc->localCenterBY);
+	b2FloatW mA = b2LoadW(wc->invMassA);
+	b2FloatW iA = b2LoadW(wc->invIA);
+	b2FloatW mB = b2LoadW(wc->invMassB);
+	b2FloatW iB = b2LoadW(wc->invIB);
+	b2FloatW radiusA = b2LoadW(wc->radiusA);
+	b2FloatW radiusB = b2LoadW(wc->radiusB);
+	b2FloatW lanePointCount = b2LoadW(wc->pointCount);
+	b2MaskW faceB = b2GreaterW(b2LoadW(wc->faceB), b2SplatW(0.5f));
+	b2FloatW zero = b2SplatW(0.0f);
+
+	b2FloatW minSeparation = zero;
+
+	// Solve normal constraints
+	int32 pointCount = wc->circles ? 1 : b2_maxManifoldPoints;
+	for (int32 j = 0; j < pointCount; ++j)
+	{
+		float rotations[4][b2_simdWidth];
+		b2StoreW(rotations[0], aA);
+		b2StoreW(rotations[2], aB);
+		for (int32 lane = 0; lane < b2_simdWidth; ++lane)
+		{
+			b2Rot qA(rotations[0][lane]);
+			b2Rot qB(rotations[2][lane]);
+			rotations[0][lane] = qA.s;
+			rotations[1][lane] = qA.c;
+			rotations[2][lane] = qB.s;
+			rotations[3][lane] = qB.c;
 		}
 
-		m_positions[indexA].c = cA;
-		m_positions[indexA].a = aA;
+		b2FloatW qAs = b2LoadW(rotations[0]);
+		b2FloatW qAc = b2LoadW(rotations[1]);
+		b2FloatW qBs = b2LoadW(rotations[2]);
+		b2FloatW qBc = b2LoadW(rotations[3]);
+		b2FloatW pAX = cAX - (qAc * localCenterAX - qAs * localCenterAY);
+		b2FloatW pAY = cAY - (qAs * localCenterAX + qAc * localCenterAY);
+		b2FloatW pBX = cBX - (qBc * localCenterBX - qBs * localCenterBY);
+		b2FloatW pBY = cBY - (qBs * localCenterBX + qBc * localCenterBY);
 
-		m_positions[indexB].c = cB;
-		m_positions[indexB].a = aB;
+		b2FloatW normalX, normalY;
+		b2FloatW pointX, pointY;
+		b2FloatW separation;
+
+		if (wc->circles)
+		{
+			b2FloatW localPointX = b2LoadW(wc->localPointX);
+			b2FloatW localPointY = b2LoadW(wc->localPointY);
+			b2FloatW localPointsX = b2LoadW(wc->localPointsX[0]);
+			b2FloatW localPointsY = b2LoadW(wc->localPointsY[0]);
+
+			b2FloatW pointAX = (qAc * localPointX - qAs * localPointY) + pAX;
+			b2FloatW pointAY = (qAs * localPointX + qAc * localPointY) + pAY;
+			b2FloatW pointBX = (qBc * localPointsX - qBs * localPointsY) + pBX;
+			b2FloatW pointBY = (qBs * localPointsX + qBc * localPointsY) + pBY;
+
+			// Same as b2Vec2::Normalize
+			normalX = pointBX - pointAX;
+			normalY = pointBY - pointAY;
+			b2FloatW length = b2SqrtW(normalX * normalX + normalY * normalY);
+			b2MaskW valid = b2GreaterEqualW(length, b2SplatW(b2_epsilon));
+			b2FloatW invLength = b2SplatW(1.0f) / length;
+			normalX = b2SelectW(valid, normalX * invLength, normalX);
+			normalY = b2SelectW(valid, normalY * invLength, normalY);
+
+			b2FloatW half = b2SplatW(0.5f);
+			pointX = half * (pointAX + pointBX);
+			pointY = half * (pointAY + pointBY);
+			separation = (pointBX - pointAX) * normalX + (pointBY - pointAY) * normalY - radiusA - radiusB;
+		}
+		else
+		{
+			// The reference face belongs to body A for e_faceA and to body B for e_faceB.
+			b2FloatW qRs = b2SelectW(faceB, qBs, qAs);
+			b2FloatW qRc = b2SelectW(faceB, qBc, qAc);
+			b2FloatW pRX = b2SelectW(faceB, pBX, pAX);
+			b2FloatW pRY = b2SelectW(faceB, pBY, pAY);
+			b2FloatW qIs = b2SelectW(faceB, qAs, qBs);
+			b2FloatW qIc = b2SelectW(faceB, qAc, qBc);
+			b2FloatW pIX = b2SelectW(faceB, pAX, pBX);
+			b2FloatW pIY = b2SelectW(faceB, pAY, pBY);
+
+			b2FloatW localNormalX = b2LoadW(wc->localNormalX);
+			b2FloatW localNormalY = b2LoadW(wc->localNormalY);
+			b2FloatW localPointX = b2LoadW(wc->localPointX);
+			b2FloatW localPointY = b2LoadW(wc->localPointY);
+			b2FloatW localPointsX = b2LoadW(wc->localPointsX[j]);
+			b2FloatW localPointsY = b2LoadW(wc->localPointsY[j]);
+
+			normalX = qRc * localNormalX - qRs * localNormalY;
+			normalY = qRs * localNormalX + qRc * localNormalY;
+			b2FloatW planePointX = (qRc * localPointX - qRs * localPointY) + pRX;
+			b2FloatW planePointY = (qRs * localPointX + qRc * localPointY) + pRY;
+
+			b2FloatW clipPointX = (qIc * localPointsX - qIs * localPointsY) + pIX;
+			b2FloatW clipPointY = (qIs * localPointsX + qIc * localPointsY) + pIY;
+			separation = (clipPointX - planePointX) * normalX + (clipPointY - planePointY) * normalY - radiusA - radiusB;
+			pointX = clipPointX;
+			pointY = clipPointY;
+
+			// Ensure normal points from A to B
+			normalX = b2SelectW(faceB, -normalX, normalX);
+			normalY = b2SelectW(faceB, -normalY, normalY);
+		}
+
+		b2FloatW rAX = pointX - cAX;
+		b2FloatW rAY = pointY - cAY;
+		b2FloatW rBX = pointX - cBX;
+		b2FloatW rBY = pointY - cBY;
+
+		// Track max constraint error.
+		b2MaskW active = b2LessW(b2SplatW(float(j)), lanePointCount);
+		minSeparation = b2SelectW(active, b2MinW(minSeparation, separation), minSeparation);
+
+		// Prevent large corrections and allow slop.
+		b2FloatW C = b2SplatW(b2_baumgarte) * (separation + b2SplatW(b2_linearSlop));
+		C = b2MaxW(b2SplatW(-b2_maxLinearCorrection), b2MinW(C, zero));
+
+		// Compute the effective mass.
+		b2FloatW rnA = rAX * normalY - rAY * normalX;
+		b2FloatW rnB = rBX * normalY - rBY * normalX;
+		b2FloatW K = mA + mB + iA * rnA * rnA + iB * rnB * rnB;
+
+		// Compute normal impulse
+		b2FloatW impulse = b2SelectW(b2AndW(active, b2GreaterW(K, zero)), -C / K, zero);
+
+		b2FloatW PX = impulse * normalX;
+		b2FloatW PY = impulse * normalY;
+
+		cAX = cAX - mA * PX;
+		cAY = cAY - mA * PY;
+		aA = aA - iA * (rAX * PY - rAY * PX);
+
+		cBX = cBX + mB * PX;
+		cBY = cBY + mB * PY;
+		aB = aB + iB * (rBX * PY - rBY * PX);
 	}
 
-	// We can't expect minSpeparation >= -b2_linearSlop because we don't
-	// push the separation above -b2_linearSlop.
-	return minSeparation >= -3.0f * b2_linearSlop;
+	b2StoreW(positions[0], cAX);
+	b2StoreW(positions[1], cAY);
+	b2StoreW(positions[2], aA);
+	b2StoreW(positions[3], cBX);
+	b2StoreW(positions[4], cBY);
+	b2StoreW(positions[5], aB);
+
+	for (int32 lane = 0; lane < wc->count; ++lane)
+	{
+		b2Position& positionA = m_positions[wc->indexA[lane]];
+		b2Position& positionB = m_positions[wc->indexB[lane]];
+		positionA.c.Set(positions[0][lane], positions[1][lane]);
+		positionA.a = positions[2][lane];
+		positionB.c.Set(positions[3][lane], positions[4][lane]);
+		positionB.a = positions[5][lane];
+	}
+
+	float separations[b2_simdWidth];
+	b2StoreW(separations, minSeparation);
+
+	float result = 0.0f;
+	for (int32 lane = 0; lane < wc->count; ++lane)
+	{
+		result = b2Min(result, separations[lane]);
+	}
+
+	return result;
 }
 
 // Sequential position solver for position constraints.
@@ -31,6 +31,8 @@ class b2Contact;
 class b2Body;
 class b2StackAllocator;
 struct b2ContactPositionConstraint;
+struct b2WideVelocityConstraint;
+struct b2WidePositionConstraint;
 
 struct b2VelocityConstraintPoint
 {
@@ -85,6 +87,14 @@ public:
 	bool SolvePositionConstraints();
 	bool SolveTOIPositionConstraints(int32 toiIndexA, int32 toiIndexB);
 
+	void SolveVelocityConstraint(b2ContactVelocityConstraint* vc);
+	float SolvePositionConstraint(const b2ContactPositionConstraint* pc);
+
+	// See b2TimeStep::wideSolving.
+	void InitializeWideConstraints();
+	void SolveWideVelocityConstraint(b2WideVelocityConstraint* wc);
+	float SolveWidePositionConstraint(const b2WidePositionConstraint* wc);
+
 	b2TimeStep m_step;
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
@@ -93,6 +103,14 @@ public:
 	b2ContactVelocityConstraint* m_velocityConstraints;
 	b2Contact** m_contacts;
 	int m_count;
+
+	// Wide solver, constraints which could not be packed are solved one by one.
+	b2WideVelocityConstraint* m_wideVelocityConstraints;
+	b2WidePositionConstraint* m_widePositionConstraints;
+	int32* m_overflowConstraints;
+	int32 m_wideVelocityCount;
+	int32 m_widePositionCount;
+	int32 m_overflowCount;
 };
 
 #endif
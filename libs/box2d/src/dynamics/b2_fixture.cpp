@@ -133,7 +133,14 @@ void b2Fixture::CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf)
 	{
 		b2FixtureProxy* proxy = m_proxies + i;
 		m_shape->ComputeAABB(&proxy->aabb, xf, i);
-		proxy->proxyId = broadPhase->CreateProxy(proxy->aabb, proxy);
+		if (m_body->GetType() == b2_staticBody)
+		{
+			proxy->proxyId = broadPhase->CreateStaticProxy(proxy->aabb, proxy);
+		}
+		else
+		{
+			proxy->proxyId = broadPhase->CreateProxy(proxy->aabb, proxy);
+		}
 		proxy->fixture = this;
 		proxy->childIndex = i;
 	}
@@ -155,33 +155,43 @@ b2Island::b2Island(
 	int32 contactCapacity,
 	int32 jointCapacity,
 	b2StackAllocator* allocator,
-	b2ContactListener* listener)
+	b2ContactListener* listener,
+	int32 staticCapacity,
+	int32 staticSlotCount)
 {
 	m_bodyCapacity = bodyCapacity;
+	m_staticCapacity = staticCapacity;
+	m_staticSlotCount = staticSlotCount;
 	m_contactCapacity = contactCapacity;
 	m_jointCapacity	 = jointCapacity;
 	m_bodyCount = 0;
+	m_staticCount = 0;
 	m_contactCount = 0;
 	m_jointCount = 0;
 
 	m_allocator = allocator;
 	m_listener = listener;
+	m_impulses = nullptr;
 
 	m_bodies = (b2Body**)m_allocator->Allocate(bodyCapacity * sizeof(b2Body*));
+	m_staticBodies = (b2Body**)m_allocator->Allocate(staticCapacity * sizeof(b2Body*));
 	m_contacts = (b2Contact**)m_allocator->Allocate(contactCapacity	 * sizeof(b2Contact*));
 	m_joints = (b2Joint**)m_allocator->Allocate(jointCapacity * sizeof(b2Joint*));
 
-	m_velocities = (b2Velocity*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Velocity));
-	m_positions = (b2Position*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Position));
+	// Static slots are in front of the body state, at negative indices.
+	int32 stateCount = m_staticSlotCount + m_bodyCapacity;
+	m_velocities = (b2Velocity*)m_allocator->Allocate(stateCount * sizeof(b2Velocity)) + m_staticSlotCount;
+	m_positions = (b2Position*)m_allocator->Allocate(stateCount * sizeof(b2Position)) + m_staticSlotCount;
 }
 
 b2Island::~b2Island()
 {
 	// Warning: the order should reverse the constructor order.
-	m_allocator->Free(m_positions);
-	m_allocator->Free(m_velocities);
+	m_allocator->Free(m_positions - m_staticSlotCount);
+	m_allocator->Free(m_velocities - m_staticSlotCount);
 	m_allocator->Free(m_joints);
 	m_allocator->Free(m_contacts);
+	m_allocator->Free(m_staticBodies);
 	m_allocator->Free(m_bodies);
 }
 
@@ -195,15 +205,16 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* b = m_bodies[i];
+		b2Sweep& sweep = b->Sweep();
 
-		b2Vec2 c = b->m_sweep.c;
-		float a = b->m_sweep.a;
-		b2Vec2 v = b->m_linearVelocity;
-		float w = b->m_angularVelocity;
+		b2Vec2 c = sweep.c;
+		float a = sweep.a;
+		b2Vec2 v = b->LinearVelocity();
+		float w = b->AngularVelocity();
 
 		// Store positions for continuous collision.
-		b->m_sweep.c0 = b->m_sweep.c;
-		b->m_sweep.a0 = b->m_sweep.a;
+		sweep.c0 = sweep.c;
+		sweep.a0 = sweep.a;
 
 		if (b->m_type == b2_dynamicBody)
 		{
@@ -228,6 +239,19 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 		m_velocities[i].w = w;
 	}
 
+	// Static bodies don't move. They may belong to other islands which are solved
+	// at the same time, so they are only read.
+	for (int32 i = 0; i < m_staticCount; ++i)
+	{
+		b2Body* b = m_staticBodies[i];
+		int32 index = b->m_islandIndex;
+
+		m_positions[index].c = b->Sweep().c;
+		m_positions[index].a = b->Sweep().a;
+		m_velocities[index].v.SetZero();
+		m_velocities[index].w = 0.0f;
+	}
+
 	timer.Reset();
 
 	// Solver data
@@ -335,10 +359,11 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* body = m_bodies[i];
-		body->m_sweep.c = m_positions[i].c;
-		body->m_sweep.a = m_positions[i].a;
-		body->m_linearVelocity = m_velocities[i].v;
-		body->m_angularVelocity = m_velocities[i].w;
+		b2Sweep& sweep = body->Sweep();
+		sweep.c = m_positions[i].c;
+		sweep.a = m_positions[i].a;
+		body->LinearVelocity() = m_velocities[i].v;
+		body->AngularVelocity() = m_velocities[i].w;
 		body->SynchronizeTransform();
 	}
 
@@ -350,9 +375,6 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	{
 		float minSleepTime = b2_maxFloat;
 
-		const float linTolSqr = b2_linearSleepTolerance * b2_linearSleepTolerance;
-		const float angTolSqr = b2_angularSleepTolerance * b2_angularSleepTolerance;
-
 		for (int32 i = 0; i < m_bodyCount; ++i)
 		{
 			b2Body* b = m_bodies[i];
@@ -361,9 +383,17 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 				continue;
 			}
 
+			// Tolerances of the body, the angular one is scaled like the linear one.
+			const float linTolSqr = b->m_sleepThreshold * b->m_sleepThreshold;
+			const float angTol = b2_angularSleepTolerance * (b->m_sleepThreshold / b2_linearSleepTolerance);
+			const float angTolSqr = angTol * angTol;
+
+			const b2Vec2& v = b->LinearVelocity();
+			const float w = b->AngularVelocity();
+
 			if ((b->m_flags & b2Body::e_autoSleepFlag) == 0 ||
-				b->m_angularVelocity * b->m_angularVelocity > angTolSqr ||
-				b2Dot(b->m_linearVelocity, b->m_linearVelocity) > linTolSqr)
+				w * w > angTolSqr ||
+				b2Dot(v, v) > linTolSqr)
 			{
 				b->m_sleepTime = 0.0f;
 				minSleepTime = 0.0f;
@@ -375,7 +405,7 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 			}
 		}
 
-		if (minSleepTime >= b2_timeToSleep && positionSolved)
+		if (minSleepTime >= step.timeToSleep && positionSolved)
 		{
 			for (int32 i = 0; i < m_bodyCount; ++i)
 			{
@@ -395,10 +425,10 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* b = m_bodies[i];
-		m_positions[i].c = b->m_sweep.c;
-		m_positions[i].a = b->m_sweep.a;
-		m_velocities[i].v = b->m_linearVelocity;
-		m_velocities[i].w = b->m_angularVelocity;
+		m_positions[i].c = b->Sweep().c;
+		m_positions[i].a = b->Sweep().a;
+		m_velocities[i].v = b->LinearVelocity();
+		m_velocities[i].w = b->AngularVelocity();
 	}
 
 	b2ContactSolverDef contactSolverDef;
@@ -454,10 +484,10 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 #endif
 
 	// Leap of faith to new safe state.
-	m_bodies[toiIndexA]->m_sweep.c0 = m_positions[toiIndexA].c;
-	m_bodies[toiIndexA]->m_sweep.a0 = m_positions[toiIndexA].a;
-	m_bodies[toiIndexB]->m_sweep.c0 = m_positions[toiIndexB].c;
-	m_bodies[toiIndexB]->m_sweep.a0 = m_positions[toiIndexB].a;
+	m_bodies[toiIndexA]->Sweep().c0 = m_positions[toiIndexA].c;
+	m_bodies[toiIndexA]->Sweep().a0 = m_positions[toiIndexA].a;
+	m_bodies[toiIndexB]->Sweep().c0 = m_positions[toiIndexB].c;
+	m_bodies[toiIndexB]->Sweep().a0 = m_positions[toiIndexB].a;
 
 	// No warm starting is needed for TOI events because warm
 	// starting impulses were applied in the discrete solver.
@@ -508,10 +538,11 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 
 		// Sync bodies
 		b2Body* body = m_bodies[i];
-		body->m_sweep.c = c;
-		body->m_sweep.a = a;
-		body->m_linearVelocity = v;
-		body->m_angularVelocity = w;
+		b2Sweep& sweep = body->Sweep();
+		sweep.c = c;
+		sweep.a = a;
+		body->LinearVelocity() = v;
+		body->AngularVelocity() = w;
 		body->SynchronizeTransform();
 	}
 
@@ -520,7 +551,7 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 
 void b2Island::Report(const b2ContactVelocityConstraint* constraints)
 {
-	if (m_listener == nullptr)
+	if (m_listener == nullptr && m_impulses == nullptr)
 	{
 		return;
 	}
@@ -539,6 +570,13 @@ void b2Island::Report(const b2ContactVelocityConstraint* constraints)
 			impulse.tangentImpulses[j] = vc->points[j].tangentImpulse;
 		}
 
-		m_listener->PostSolve(c, &impulse);
+		if (m_impulses != nullptr)
+		{
+			m_impulses[i] = impulse;
+		}
+		else
+		{
+			m_listener->PostSolve(c, &impulse);
+		}
 	}
 }
@@ -31,20 +31,26 @@ class b2Contact;
 class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
+struct b2ContactImpulse;
 struct b2ContactVelocityConstraint;
 struct b2Profile;
 
 /// This is an internal class.
+/// Islands solved in parallel by b2World::Solve may share static bodies. These are added
+/// with AddStatic and use negative island indices, so each of them gets the same slot before
+/// index 0 in every island. staticSlotCount is the number of these slots.
 class b2Island
 {
 public:
 	b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity,
-			b2StackAllocator* allocator, b2ContactListener* listener);
+			b2StackAllocator* allocator, b2ContactListener* listener,
+			int32 staticCapacity = 0, int32 staticSlotCount = 0);
 	~b2Island();
 
 	void Clear()
 	{
 		m_bodyCount = 0;
+		m_staticCount = 0;
 		m_contactCount = 0;
 		m_jointCount = 0;
 	}
@@ -61,6 +67,15 @@ public:
 		++m_bodyCount;
 	}
 
+	/// The island index of the body must be already assigned in [-staticSlotCount, -1].
+	void AddStatic(b2Body* body)
+	{
+		b2Assert(m_staticCount < m_staticCapacity);
+		b2Assert(body->m_type == b2_staticBody);
+		b2Assert(-m_staticSlotCount <= body->m_islandIndex && body->m_islandIndex < 0);
+		m_staticBodies[m_staticCount++] = body;
+	}
+
 	void Add(b2Contact* contact)
 	{
 		b2Assert(m_contactCount < m_contactCapacity);
@@ -79,17 +94,24 @@ public:
 	b2ContactListener* m_listener;
 
 	b2Body** m_bodies;
+	b2Body** m_staticBodies;
 	b2Contact** m_contacts;
 	b2Joint** m_joints;
 
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
 
+	// When set, Report stores the impulses here instead of calling the listener.
+	b2ContactImpulse* m_impulses;
+
 	int32 m_bodyCount;
+	int32 m_staticCount;
 	int32 m_jointCount;
 	int32 m_contactCount;
 
 	int32 m_bodyCapacity;
+	int32 m_staticCapacity;
+	int32 m_staticSlotCount;
 	int32 m_contactCapacity;
 	int32 m_jointCapacity;
 };
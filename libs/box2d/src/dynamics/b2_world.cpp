@@ -34,10 +34,12 @@
 #include "box2d/b2_fixture.h"
 #include "box2d/b2_polygon_shape.h"
 #include "box2d/b2_pulley_joint.h"
+#include "box2d/b2_task_scheduler.h"
 #include "box2d/b2_time_of_impact.h"
 #include "box2d/b2_timer.h"
 #include "box2d/b2_world.h"
 
+#include <algorithm>
 #include <new>
 
 b2World::b2World(const b2Vec2& gravity)
@@ -48,16 +50,29 @@ b2World::b2World(const b2Vec2& gravity)
 	m_bodyList = nullptr;
 	m_jointList = nullptr;
 
+	memset(&m_states, 0, sizeof(b2BodyStateArrays));
+	m_freeStates = nullptr;
+	m_freeStateCount = 0;
+
+	m_contactEventsEnabled = false;
+	memset(&m_contactEvents, 0, sizeof(b2ContactEvents));
+	m_contactEvents.hitThreshold = 1.0f;
+
+	m_bodyMoveEventsEnabled = false;
+	memset(&m_bodyMoveEvents, 0, sizeof(b2BodyMoveEvents));
+
 	m_bodyCount = 0;
 	m_jointCount = 0;
 
 	m_warmStarting = true;
+	m_wideSolving = false;
 	m_continuousPhysics = true;
 	m_subStepping = false;
 
 	m_stepComplete = true;
 
 	m_allowSleep = true;
+	m_timeToSleep = b2_timeToSleep;
 	m_gravity = gravity;
 
 	m_newContacts = false;
@@ -67,6 +82,11 @@ b2World::b2World(const b2Vec2& gravity)
 	m_inv_dt0 = 0.0f;
 
 	m_contactManager.m_allocator = &m_blockAllocator;
+	m_contactManager.m_stackAllocator = &m_stackAllocator;
+
+	m_taskScheduler = nullptr;
+	m_threadAllocators = nullptr;
+	m_threadAllocatorCount = 0;
 
 	memset(&m_profile, 0, sizeof(b2Profile));
 }
@@ -90,6 +110,47 @@ b2World::~b2World()
 
 		b = bNext;
 	}
+
+	b2Free(m_states.transforms);
+	b2Free(m_states.sweeps);
+	b2Free(m_states.linearVelocities);
+	b2Free(m_states.angularVelocities);
+	b2Free(m_states.bodies);
+	b2Free(m_freeStates);
+
+	SetContactEvents(false);
+	SetBodyMoveEvents(false);
+	SetTaskScheduler(nullptr);
+}
+
+void b2World::SetTaskScheduler(b2TaskScheduler* scheduler)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_threadAllocators[i].~b2StackAllocator();
+	}
+	b2Free(m_threadAllocators);
+	m_threadAllocators = nullptr;
+	m_threadAllocatorCount = 0;
+
+	m_taskScheduler = scheduler;
+	m_contactManager.m_taskScheduler = scheduler;
+
+	if (scheduler != nullptr && scheduler->GetThreadCount() > 1)
+	{
+		m_threadAllocatorCount = scheduler->GetThreadCount() - 1;
+		m_threadAllocators = (b2StackAllocator*)b2Alloc(m_threadAllocatorCount * sizeof(b2StackAllocator));
+		for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+		{
+			new (m_threadAllocators + i) b2StackAllocator;
+		}
+	}
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -212,11 +273,108 @@ void b2World::DestroyBody(b2Body* b)
 		m_bodyList = b->m_next;
 	}
 
+	DestroyBodyState(b);
+
 	--m_bodyCount;
 	b->~b2Body();
 	m_blockAllocator.Free(b, sizeof(b2Body));
 }
 
+void b2World::SetContactEvents(bool flag)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked() || flag == m_contactEventsEnabled)
+	{
+		return;
+	}
+
+	m_contactEventsEnabled = flag;
+
+	if (flag == false)
+	{
+		b2Free(m_contactEvents.beginEvents);
+		b2Free(m_contactEvents.endEvents);
+		b2Free(m_contactEvents.hitEvents);
+
+		float hitThreshold = m_contactEvents.hitThreshold;
+		memset(&m_contactEvents, 0, sizeof(b2ContactEvents));
+		m_contactEvents.hitThreshold = hitThreshold;
+	}
+}
+
+void b2World::SetHitEventThreshold(float speed)
+{
+	m_contactEvents.hitThreshold = speed;
+}
+
+void b2World::SetBodyMoveEvents(bool flag)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked() || flag == m_bodyMoveEventsEnabled)
+	{
+		return;
+	}
+
+	m_bodyMoveEventsEnabled = flag;
+
+	if (flag == false)
+	{
+		b2Free(m_bodyMoveEvents.events);
+		memset(&m_bodyMoveEvents, 0, sizeof(b2BodyMoveEvents));
+	}
+}
+
+// Copy the used part of an array into a new allocation.
+static void* b2Reallocate(void* oldMemory, int32 oldSize, int32 newSize)
+{
+	void* memory = b2Alloc(newSize);
+	if (oldMemory != nullptr)
+	{
+		memcpy(memory, oldMemory, oldSize);
+		b2Free(oldMemory);
+	}
+	return memory;
+}
+
+int32 b2World::CreateBodyState(b2Body* body)
+{
+	int32 index;
+	if (m_freeStateCount > 0)
+	{
+		index = m_freeStates[--m_freeStateCount];
+	}
+	else
+	{
+		if (m_states.count == m_states.capacity)
+		{
+			int32 count = m_states.count;
+			int32 capacity = b2Max(16, 2 * m_states.capacity);
+			m_states.transforms = (b2Transform*)b2Reallocate(m_states.transforms, count * sizeof(b2Transform), capacity * sizeof(b2Transform));
+			m_states.sweeps = (b2Sweep*)b2Reallocate(m_states.sweeps, count * sizeof(b2Sweep), capacity * sizeof(b2Sweep));
+			m_states.linearVelocities = (b2Vec2*)b2Reallocate(m_states.linearVelocities, count * sizeof(b2Vec2), capacity * sizeof(b2Vec2));
+			m_states.angularVelocities = (float*)b2Reallocate(m_states.angularVelocities, count * sizeof(float), capacity * sizeof(float));
+			m_states.bodies = (b2Body**)b2Reallocate(m_states.bodies, count * sizeof(b2Body*), capacity * sizeof(b2Body*));
+			m_freeStates = (int32*)b2Reallocate(m_freeStates, m_freeStateCount * sizeof(int32), capacity * sizeof(int32));
+			m_states.capacity = capacity;
+		}
+
+		index = m_states.count++;
+	}
+
+	m_states.bodies[index] = body;
+	return index;
+}
+
+void b2World::DestroyBodyState(b2Body* body)
+{
+	int32 index = body->m_stateIndex;
+	b2Assert(0 <= index && index < m_states.count);
+
+	m_states.bodies[index] = nullptr;
+	m_freeStates[m_freeStateCount++] = index;
+	body->m_stateIndex = b2_nullState;
+}
+
 b2Joint* b2World::CreateJoint(const b2JointDef* def)
 {
 	b2Assert(IsLocked() == false);
@@ -391,23 +549,92 @@ void b2World::SetAllowSleeping(bool flag)
 }
 
 // Find islands, integrate and solve constraints, solve position constraints
+// An island found by b2World::Solve. Its members are ranges of the arrays shared by all islands.
+struct b2IslandTask
+{
+	int32 bodyIndex;
+	int32 bodyCount;
+	int32 staticIndex;
+	int32 staticCount;
+	int32 contactIndex;
+	int32 contactCount;
+	int32 jointIndex;
+	int32 jointCount;
+	b2Profile profile;
+};
+
+// Solves islands in parallel. Islands share no bodies except static ones, which are only read,
+// and every thread allocates its islands from its own stack allocator.
+class b2SolveIslandsTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
+	{
+		b2StackAllocator* allocator = threadIndex == 0 ? mainAllocator : threadAllocators + threadIndex - 1;
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			b2IslandTask* task = tasks + i;
+
+			b2Island island(task->bodyCount, task->contactCount, task->jointCount,
+							allocator, nullptr, task->staticCount, staticSlotCount);
+
+			for (int32 j = 0; j < task->bodyCount; ++j)
+			{
+				island.Add(bodies[task->bodyIndex + j]);
+			}
+			for (int32 j = 0; j < task->staticCount; ++j)
+			{
+				island.AddStatic(statics[task->staticIndex + j]);
+			}
+			for (int32 j = 0; j < task->contactCount; ++j)
+			{
+				island.Add(contacts[task->contactIndex + j]);
+			}
+			for (int32 j = 0; j < task->jointCount; ++j)
+			{
+				island.Add(joints[task->jointIndex + j]);
+			}
+
+			// The listener is called after all islands are solved.
+			if (impulses != nullptr)
+			{
+				island.m_impulses = impulses + task->contactIndex;
+			}
+
+			island.Solve(&task->profile, *step, gravity, allowSleep);
+		}
+	}
+
+	b2IslandTask* tasks;
+	b2Body** bodies;
+	b2Body** statics;
+	b2Contact** contacts;
+	b2Joint** joints;
+	b2ContactImpulse* impulses;
+	int32 staticSlotCount;
+
+	b2StackAllocator* mainAllocator;
+	b2StackAllocator* threadAllocators;
+
+	const b2TimeStep* step;
+	b2Vec2 gravity;
+	bool allowSleep;
+};
+
 void b2World::Solve(const b2TimeStep& step)
 {
 	m_profile.solveInit = 0.0f;
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
 
-	// Size the island for the worst case.
-	b2Island island(m_bodyCount,
-					m_contactManager.m_contactCount,
-					m_jointCount,
-					&m_stackAllocator,
-					m_contactManager.m_contactListener);
-
 	// Clear all the island flags.
 	for (b2Body* b = m_bodyList; b; b = b->m_next)
 	{
 		b->m_flags &= ~b2Body::e_islandFlag;
+
+		// Static bodies get their slot when they are first added to an island.
+		b->m_islandIndex = 0;
 	}
 	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
 	{
@@ -418,7 +645,24 @@ void b2World::Solve(const b2TimeStep& step)
 		j->m_islandFlag = false;
 	}
 
-	// Build and simulate all awake islands.
+	// Members of all islands, sized for the worst case. Every static body in an
+	// island is reached through a contact or joint of that island.
+	int32 contactCapacity = m_contactManager.m_contactCount;
+	int32 staticCapacity = contactCapacity + m_jointCount;
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2Body*));
+	b2Body** statics = (b2Body**)m_stackAllocator.Allocate(staticCapacity * sizeof(b2Body*));
+	b2Contact** contacts = (b2Contact**)m_stackAllocator.Allocate(contactCapacity * sizeof(b2Contact*));
+	b2Joint** joints = (b2Joint**)m_stackAllocator.Allocate(m_jointCount * sizeof(b2Joint*));
+	b2IslandTask* tasks = (b2IslandTask*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2IslandTask));
+
+	int32 bodyCount = 0;
+	int32 staticCount = 0;
+	int32 contactCount = 0;
+	int32 jointCount = 0;
+	int32 taskCount = 0;
+	int32 staticSlotCount = 0;
+
+	// Find all awake islands.
 	int32 stackSize = m_bodyCount;
 	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
 	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
@@ -439,8 +683,13 @@ void b2World::Solve(const b2TimeStep& step)
 			continue;
 		}
 
-		// Reset island and stack.
-		island.Clear();
+		// Start a new island.
+		b2IslandTask* task = tasks + taskCount++;
+		task->bodyIndex = bodyCount;
+		task->staticIndex = staticCount;
+		task->contactIndex = contactCount;
+		task->jointIndex = jointCount;
+
 		int32 stackCount = 0;
 		stack[stackCount++] = seed;
 		seed->m_flags |= b2Body::e_islandFlag;
@@ -451,15 +700,23 @@ void b2World::Solve(const b2TimeStep& step)
 			// Grab the next body off the stack and add it to the island.
 			b2Body* b = stack[--stackCount];
 			b2Assert(b->IsEnabled() == true);
-			island.Add(b);
 
 			// To keep islands as small as possible, we don't
 			// propagate islands across static bodies.
 			if (b->GetType() == b2_staticBody)
 			{
+				if (b->m_islandIndex == 0)
+				{
+					b->m_islandIndex = -(++staticSlotCount);
+				}
+
+				b2Assert(staticCount < staticCapacity);
+				statics[staticCount++] = b;
 				continue;
 			}
 
+			bodies[bodyCount++] = b;
+
 			// Make sure the body is awake (without resetting sleep timer).
 			b->m_flags |= b2Body::e_awakeFlag;
 
@@ -489,7 +746,7 @@ void b2World::Solve(const b2TimeStep& step)
 					continue;
 				}
 
-				island.Add(contact);
+				contacts[contactCount++] = contact;
 				contact->m_flags |= b2Contact::e_islandFlag;
 
 				b2Body* other = ce->other;
@@ -521,7 +778,7 @@ void b2World::Solve(const b2TimeStep& step)
 					continue;
 				}
 
-				island.Add(je->joint);
+				joints[jointCount++] = je->joint;
 				je->joint->m_islandFlag = true;
 
 				if (other->m_flags & b2Body::e_islandFlag)
@@ -535,28 +792,106 @@ void b2World::Solve(const b2TimeStep& step)
 			}
 		}
 
-		b2Profile profile;
-		island.Solve(&profile, step, m_gravity, m_allowSleep);
+		task->bodyCount = bodyCount - task->bodyIndex;
+		task->staticCount = staticCount - task->staticIndex;
+		task->contactCount = contactCount - task->contactIndex;
+		task->jointCount = jointCount - task->jointIndex;
+
+		// Allow static bodies to participate in other islands.
+		for (int32 i = task->staticIndex; i < staticCount; ++i)
+		{
+			statics[i]->m_flags &= ~b2Body::e_islandFlag;
+		}
+	}
+
+	m_stackAllocator.Free(stack);
+
+	// Contact impulses are reported after all islands are solved, in the order of islands.
+	b2ContactListener* listener = m_contactManager.m_contactListener;
+	b2ContactImpulse* impulses = nullptr;
+	if (listener != nullptr)
+	{
+		impulses = (b2ContactImpulse*)m_stackAllocator.Allocate(contactCount * sizeof(b2ContactImpulse));
+	}
+
+	// Simulate the islands.
+	b2SolveIslandsTask solveTask;
+	solveTask.tasks = tasks;
+	solveTask.bodies = bodies;
+	solveTask.statics = statics;
+	solveTask.contacts = contacts;
+	solveTask.joints = joints;
+	solveTask.impulses = impulses;
+	solveTask.staticSlotCount = staticSlotCount;
+	solveTask.mainAllocator = &m_stackAllocator;
+	solveTask.threadAllocators = m_threadAllocators;
+	solveTask.step = &step;
+	solveTask.gravity = m_gravity;
+	solveTask.allowSleep = m_allowSleep;
+
+	if (m_taskScheduler != nullptr)
+	{
+		b2Assert(m_taskScheduler->GetThreadCount() == m_threadAllocatorCount + 1);
+		m_taskScheduler->ParallelFor(&solveTask, taskCount, 1);
+	}
+	else
+	{
+		solveTask.Execute(0, taskCount, 0);
+	}
+
+	// Merge in a fixed order, so the result doesn't depend on scheduling.
+	for (int32 i = 0; i < taskCount; ++i)
+	{
+		const b2Profile& profile = tasks[i].profile;
 		m_profile.solveInit += profile.solveInit;
 		m_profile.solveVelocity += profile.solveVelocity;
 		m_profile.solvePosition += profile.solvePosition;
+	}
 
-		// Post solve cleanup.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
+	// An island falls asleep as a whole. Its bodies moved for the last time.
+	m_profile.awakeIslands = taskCount;
+	m_profile.asleepIslands = 0;
+	for (int32 i = 0; i < taskCount; ++i)
+	{
+		const b2IslandTask* task = tasks + i;
+		bool fellAsleep = bodies[task->bodyIndex]->IsAwake() == false;
+		m_profile.asleepIslands += fellAsleep ? 1 : 0;
+
+		if (m_bodyMoveEventsEnabled == false)
 		{
-			// Allow static bodies to participate in other islands.
-			b2Body* b = island.m_bodies[i];
-			if (b->GetType() == b2_staticBody)
-			{
-				b->m_flags &= ~b2Body::e_islandFlag;
-			}
+			continue;
+		}
+
+		b2BodyMoveEvents& moves = m_bodyMoveEvents;
+		ReserveBodyMoveEvents(task->bodyCount);
+
+		for (int32 j = 0; j < task->bodyCount; ++j)
+		{
+			b2BodyMoveEvent* event = moves.events + moves.count++;
+			event->body = bodies[task->bodyIndex + j];
+			event->fellAsleep = fellAsleep;
 		}
 	}
 
-	m_stackAllocator.Free(stack);
+	if (impulses != nullptr)
+	{
+		for (int32 i = 0; i < contactCount; ++i)
+		{
+			listener->PostSolve(contacts[i], impulses + i);
+		}
+
+		m_stackAllocator.Free(impulses);
+	}
+
+	m_stackAllocator.Free(tasks);
+	m_stackAllocator.Free(joints);
+	m_stackAllocator.Free(contacts);
+	m_stackAllocator.Free(statics);
+	m_stackAllocator.Free(bodies);
 
 	{
 		b2Timer timer;
+
 		// Synchronize fixtures, check for out of range bodies.
 		for (b2Body* b = m_bodyList; b; b = b->GetNext())
 		{
@@ -581,17 +916,147 @@ void b2World::Solve(const b2TimeStep& step)
 	}
 }
 
-// Find TOI contacts and solve them.
+struct b2TOICounters
+{
+	int32 calls;
+	int32 iterations;
+	int32 rootIterations;
+};
+
+// Computes the TOI of contacts without a cached TOI. Every contact is written by one
+// thread only and the sweeps of the bodies are only read, they are put onto the same
+// time interval on copies.
+class b2TOITask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
+	{
+		int32 calls = 0;
+		int32 iterations = 0;
+		int32 rootIterations = 0;
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			b2Contact* c = contacts[i];
+			b2Fixture* fA = c->GetFixtureA();
+			b2Fixture* fB = c->GetFixtureB();
+			const b2Body* bA = fA->GetBody();
+			const b2Body* bB = fB->GetBody();
+
+			// Compute the TOI for this contact.
+			// Put the sweeps onto the same time interval.
+			b2TOIInput input;
+			input.sweepA = bA->Sweep();
+			input.sweepB = bB->Sweep();
+
+			// A static body doesn't move, its sweep fits any interval. Its alpha0 is not
+			// aligned because events are not solved in global TOI order, it could start
+			// the interval after an earlier impact of the other body.
+			float alpha0A = bA->m_type == b2_staticBody ? 0.0f : input.sweepA.alpha0;
+			float alpha0B = bB->m_type == b2_staticBody ? 0.0f : input.sweepB.alpha0;
+			float alpha0 = b2Max(alpha0A, alpha0B);
+			if (input.sweepA.alpha0 < alpha0)
+			{
+				input.sweepA.Advance(alpha0);
+			}
+			else if (input.sweepB.alpha0 < alpha0)
+			{
+				input.sweepB.Advance(alpha0);
+			}
+
+			b2Assert(alpha0 < 1.0f);
+
+			// Compute the time of impact in interval [0, minTOI]
+			input.proxyA.Set(fA->GetShape(), c->GetChildIndexA());
+			input.proxyB.Set(fB->GetShape(), c->GetChildIndexB());
+			input.tMax = 1.0f;
+
+			b2TOIOutput output;
+			b2TimeOfImpact(&output, &input);
+
+			++calls;
+			iterations += output.iterations;
+			rootIterations += output.rootIterations;
+
+			// Beta is the fraction of the remaining portion of the .
+			float beta = output.t;
+			float alpha = 1.0f;
+			if (output.state == b2TOIOutput::e_touching)
+			{
+				alpha = b2Min(alpha0 + (1.0f - alpha0) * beta, 1.0f);
+			}
+
+			c->m_toi = alpha;
+			c->m_flags |= b2Contact::e_toiFlag;
+		}
+
+		b2TOICounters* counter = counters + threadIndex;
+		counter->calls += calls;
+		counter->iterations += iterations;
+		counter->rootIterations += rootIterations;
+	}
+
+	b2Contact** contacts;
+	b2TOICounters* counters;
+};
+
+struct b2TOIEvent
+{
+	b2Contact* contact;
+	float alpha;
+	int32 index;
+
+	// Space which is touched by solving the event.
+	b2AABB region;
+};
+
+static bool b2TOIEventLessThan(const b2TOIEvent& a, const b2TOIEvent& b)
+{
+	if (a.alpha < b.alpha)
+	{
+		return true;
+	}
+
+	return a.alpha == b.alpha && a.index < b.index;
+}
+
+// Add the swept shapes of a body moved by a TOI event, with room for the motion
+// of the rest of the step.
+static void b2AddTOIRegion(b2AABB* region, const b2Body* body)
+{
+	for (const b2Fixture* f = body->GetFixtureList(); f; f = f->GetNext())
+	{
+		int32 childCount = f->GetShape()->GetChildCount();
+		for (int32 i = 0; i < childCount; ++i)
+		{
+			b2AABB aabb = f->GetAABB(i);
+			float margin = b2_aabbExtension + b2_maxTranslation + b2_maxRotation * aabb.GetExtents().Length();
+			aabb.lowerBound -= b2Vec2(margin, margin);
+			aabb.upperBound += b2Vec2(margin, margin);
+			region->Combine(aabb);
+		}
+	}
+}
+
+// Find TOI contacts and solve them. Every round computes the missing TOIs in parallel and
+// solves the earliest events which are too far apart to influence each other, in the order
+// of their TOI. The other events are found again in the next round.
 void b2World::SolveTOI(const b2TimeStep& step)
 {
 	b2Island island(2 * b2_maxTOIContacts, b2_maxTOIContacts, 0, &m_stackAllocator, m_contactManager.m_contactListener);
 
+	m_profile.toiRounds = 0;
+	m_profile.toiEvents = 0;
+	m_profile.toiCalls = 0;
+	m_profile.toiIterations = 0;
+	m_profile.toiRootIterations = 0;
+
 	if (m_stepComplete)
 	{
 		for (b2Body* b = m_bodyList; b; b = b->m_next)
 		{
 			b->m_flags &= ~b2Body::e_islandFlag;
-			b->m_sweep.alpha0 = 0.0f;
+			b->Sweep().alpha0 = 0.0f;
 		}
 
 		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
@@ -603,12 +1068,19 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		}
 	}
 
+	int32 threadCount = m_taskScheduler != nullptr ? m_taskScheduler->GetThreadCount() : 1;
+
 	// Find TOI events and solve them.
 	for (;;)
 	{
-		// Find the first TOI.
-		b2Contact* minContact = nullptr;
-		float minAlpha = 1.0f;
+		++m_profile.toiRounds;
+
+		// Contacts which may have a TOI event.
+		int32 contactCapacity = m_contactManager.m_contactCount;
+		b2Contact** candidates = (b2Contact**)m_stackAllocator.Allocate(contactCapacity * sizeof(b2Contact*));
+		b2Contact** uncached = (b2Contact**)m_stackAllocator.Allocate(contactCapacity * sizeof(b2Contact*));
+		int32 candidateCount = 0;
+		int32 uncachedCount = 0;
 
 		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
 		{
@@ -624,13 +1096,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 				continue;
 			}
 
-			float alpha = 1.0f;
-			if (c->m_flags & b2Contact::e_toiFlag)
-			{
-				// This contact has a valid cached TOI.
-				alpha = c->m_toi;
-			}
-			else
+			if ((c->m_flags & b2Contact::e_toiFlag) == 0)
 			{
 				b2Fixture* fA = c->GetFixtureA();
 				b2Fixture* fB = c->GetFixtureB();
@@ -666,240 +1132,354 @@ void b2World::SolveTOI(const b2TimeStep& step)
 					continue;
 				}
 
-				// Compute the TOI for this contact.
-				// Put the sweeps onto the same time interval.
-				float alpha0 = bA->m_sweep.alpha0;
+				uncached[uncachedCount++] = c;
+			}
 
-				if (bA->m_sweep.alpha0 < bB->m_sweep.alpha0)
-				{
-					alpha0 = bB->m_sweep.alpha0;
-					bA->m_sweep.Advance(alpha0);
-				}
-				else if (bB->m_sweep.alpha0 < bA->m_sweep.alpha0)
-				{
-					alpha0 = bA->m_sweep.alpha0;
-					bB->m_sweep.Advance(alpha0);
-				}
+			candidates[candidateCount++] = c;
+		}
+
+		// Compute the missing TOIs.
+		b2TOICounters* counters = (b2TOICounters*)m_stackAllocator.Allocate(threadCount * sizeof(b2TOICounters));
+		memset(counters, 0, threadCount * sizeof(b2TOICounters));
+
+		b2TOITask toiTask;
+		toiTask.contacts = uncached;
+		toiTask.counters = counters;
+
+		if (m_taskScheduler != nullptr)
+		{
+			m_taskScheduler->ParallelFor(&toiTask, uncachedCount, 32);
+		}
+		else
+		{
+			toiTask.Execute(0, uncachedCount, 0);
+		}
+
+		for (int32 i = 0; i < threadCount; ++i)
+		{
+			m_profile.toiCalls += counters[i].calls;
+			m_profile.toiIterations += counters[i].iterations;
+			m_profile.toiRootIterations += counters[i].rootIterations;
+		}
+
+		m_stackAllocator.Free(counters);
+		m_stackAllocator.Free(uncached);
+
+		// Gather the events in the order of their TOI, ties are broken by the contact order.
+		b2TOIEvent* events = (b2TOIEvent*)m_stackAllocator.Allocate(candidateCount * sizeof(b2TOIEvent));
+		int32 eventCount = 0;
+
+		for (int32 i = 0; i < candidateCount; ++i)
+		{
+			b2Contact* c = candidates[i];
+			if (1.0f - 10.0f * b2_epsilon < c->m_toi)
+			{
+				continue;
+			}
+
+			b2TOIEvent* event = events + eventCount++;
+			event->contact = c;
+			event->alpha = c->m_toi;
+			event->index = i;
+		}
 
-				b2Assert(alpha0 < 1.0f);
+		if (eventCount == 0)
+		{
+			// No more TOI events. Done!
+			m_stackAllocator.Free(events);
+			m_stackAllocator.Free(candidates);
+			m_stepComplete = true;
+			break;
+		}
 
-				int32 indexA = c->GetChildIndexA();
-				int32 indexB = c->GetChildIndexB();
+		std::sort(events, events + eventCount, b2TOIEventLessThan);
 
-				// Compute the time of impact in interval [0, minTOI]
-				b2TOIInput input;
-				input.proxyA.Set(fA->GetShape(), indexA);
-				input.proxyB.Set(fB->GetShape(), indexB);
-				input.sweepA = bA->m_sweep;
-				input.sweepB = bB->m_sweep;
-				input.tMax = 1.0f;
+		// Accept an event only if it is far from all earlier events of this round. Solving it
+		// can't change their bodies, TOIs, or create contacts between them, so the events
+		// are solved as if each was the first one.
+		int32 acceptedCount = 0;
+		for (int32 i = 0; i < eventCount; ++i)
+		{
+			b2TOIEvent* event = events + i;
+			b2Body* bA = event->contact->GetFixtureA()->GetBody();
+			b2Body* bB = event->contact->GetFixtureB()->GetBody();
 
-				b2TOIOutput output;
-				b2TimeOfImpact(&output, &input);
+			// The bodies of the event and those which may join its island.
+			event->region.lowerBound.Set(b2_maxFloat, b2_maxFloat);
+			event->region.upperBound.Set(-b2_maxFloat, -b2_maxFloat);
 
-				// Beta is the fraction of the remaining portion of the .
-				float beta = output.t;
-				if (output.state == b2TOIOutput::e_touching)
+			b2Body* bodies[2] = {bA, bB};
+			for (int32 j = 0; j < 2; ++j)
+			{
+				b2Body* body = bodies[j];
+				if (body->m_type != b2_staticBody)
 				{
-					alpha = b2Min(alpha0 + (1.0f - alpha0) * beta, 1.0f);
+					b2AddTOIRegion(&event->region, body);
 				}
-				else
+
+				if (body->m_type != b2_dynamicBody)
 				{
-					alpha = 1.0f;
+					continue;
 				}
 
-				c->m_toi = alpha;
-				c->m_flags |= b2Contact::e_toiFlag;
+				for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+				{
+					if (ce->other->m_type != b2_staticBody)
+					{
+						b2AddTOIRegion(&event->region, ce->other);
+					}
+				}
 			}
 
-			if (alpha < minAlpha)
+			bool independent = true;
+			for (int32 j = 0; j < i; ++j)
 			{
-				// This is the minimum TOI found so far.
-				minContact = c;
-				minAlpha = alpha;
+				if (b2TestOverlap(event->region, events[j].region))
+				{
+					independent = false;
+					break;
+				}
+			}
+
+			// Rejected events keep their region, events behind them must wait as well.
+			if (independent)
+			{
+				b2TOIEvent tmp = events[acceptedCount];
+				events[acceptedCount] = *event;
+				*event = tmp;
+				++acceptedCount;
 			}
 		}
 
-		if (minContact == nullptr || 1.0f - 10.0f * b2_epsilon < minAlpha)
+		// With sub-stepping only the first event is solved.
+		if (m_subStepping)
 		{
-			// No more TOI events. Done!
-			m_stepComplete = true;
-			break;
+			acceptedCount = 1;
 		}
 
-		// Advance the bodies to the TOI.
-		b2Fixture* fA = minContact->GetFixtureA();
-		b2Fixture* fB = minContact->GetFixtureB();
-		b2Body* bA = fA->GetBody();
-		b2Body* bB = fB->GetBody();
+		for (int32 i = 0; i < acceptedCount; ++i)
+		{
+			b2Assert(events[i].contact->m_flags & b2Contact::e_toiFlag);
 
-		b2Sweep backup1 = bA->m_sweep;
-		b2Sweep backup2 = bB->m_sweep;
+			if (SolveTOIEvent(&island, events[i].contact, events[i].alpha, step))
+			{
+				++m_profile.toiEvents;
+			}
+		}
 
-		bA->Advance(minAlpha);
-		bB->Advance(minAlpha);
+		m_stackAllocator.Free(events);
+		m_stackAllocator.Free(candidates);
 
-		// The TOI contact likely has some new contact points.
-		minContact->Update(m_contactManager.m_contactListener);
-		minContact->m_flags &= ~b2Contact::e_toiFlag;
-		++minContact->m_toiCount;
+		// Commit fixture proxy movements to the broad-phase so that new contacts are created.
+		// Also, some contacts can be destroyed.
+		m_contactManager.FindNewContacts();
 
-		// Is the contact solid?
-		if (minContact->IsEnabled() == false || minContact->IsTouching() == false)
+		if (m_subStepping)
 		{
-			// Restore the sweeps.
-			minContact->SetEnabled(false);
-			bA->m_sweep = backup1;
-			bB->m_sweep = backup2;
-			bA->SynchronizeTransform();
-			bB->SynchronizeTransform();
-			continue;
+			m_stepComplete = false;
+			break;
 		}
+	}
+}
+
+// Advance the bodies of a TOI contact to its TOI and solve them with the bodies they touch.
+// Return false if the contact has no contact points at the TOI.
+bool b2World::SolveTOIEvent(b2Island* island, b2Contact* minContact, float minAlpha, const b2TimeStep& step)
+{
+	// Advance the bodies to the TOI.
+	b2Fixture* fA = minContact->GetFixtureA();
+	b2Fixture* fB = minContact->GetFixtureB();
+	b2Body* bA = fA->GetBody();
+	b2Body* bB = fB->GetBody();
+
+	b2Sweep backup1 = bA->Sweep();
+	b2Sweep backup2 = bB->Sweep();
+
+	// Static bodies are shared by events of one round, which are not in TOI order.
+	// Advancing them would move their alpha0 past impacts of the later rounds.
+	if (bA->m_type != b2_staticBody)
+	{
+		bA->Advance(minAlpha);
+	}
+	if (bB->m_type != b2_staticBody)
+	{
+		bB->Advance(minAlpha);
+	}
+
+	// The TOI contact likely has some new contact points.
+	minContact->Update(m_contactManager.m_contactListener, m_contactManager.m_contactEvents);
+	minContact->m_flags &= ~b2Contact::e_toiFlag;
+	++minContact->m_toiCount;
+
+	// Is the contact solid?
+	if (minContact->IsEnabled() == false || minContact->IsTouching() == false)
+	{
+		// Restore the sweeps.
+		minContact->SetEnabled(false);
+		bA->Sweep() = backup1;
+		bB->Sweep() = backup2;
+		bA->SynchronizeTransform();
+		bB->SynchronizeTransform();
+		return false;
+	}
 
-		bA->SetAwake(true);
-		bB->SetAwake(true);
+	bA->SetAwake(true);
+	bB->SetAwake(true);
 
-		// Build the island
-		island.Clear();
-		island.Add(bA);
-		island.Add(bB);
-		island.Add(minContact);
+	// Build the island
+	island->Clear();
+	island->Add(bA);
+	island->Add(bB);
+	island->Add(minContact);
 
-		bA->m_flags |= b2Body::e_islandFlag;
-		bB->m_flags |= b2Body::e_islandFlag;
-		minContact->m_flags |= b2Contact::e_islandFlag;
+	bA->m_flags |= b2Body::e_islandFlag;
+	bB->m_flags |= b2Body::e_islandFlag;
+	minContact->m_flags |= b2Contact::e_islandFlag;
 
-		// Get contacts on bodyA and bodyB.
-		b2Body* bodies[2] = {bA, bB};
-		for (int32 i = 0; i < 2; ++i)
+	// Get contacts on bodyA and bodyB.
+	b2Body* bodies[2] = {bA, bB};
+	for (int32 i = 0; i < 2; ++i)
+	{
+		b2Body* body = bodies[i];
+		if (body->m_type == b2_dynamicBody)
 		{
-			b2Body* body = bodies[i];
-			if (body->m_type == b2_dynamicBody)
+			for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
 			{
-				for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+				if (island->m_bodyCount == island->m_bodyCapacity)
 				{
-					if (island.m_bodyCount == island.m_bodyCapacity)
-					{
-						break;
-					}
-
-					if (island.m_contactCount == island.m_contactCapacity)
-					{
-						break;
-					}
+					break;
+				}
 
-					b2Contact* contact = ce->contact;
+				if (island->m_contactCount == island->m_contactCapacity)
+				{
+					break;
+				}
 
-					// Has this contact already been added to the island?
-					if (contact->m_flags & b2Contact::e_islandFlag)
-					{
-						continue;
-					}
+				b2Contact* contact = ce->contact;
 
-					// Only add static, kinematic, or bullet bodies.
-					b2Body* other = ce->other;
-					if (other->m_type == b2_dynamicBody &&
-						body->IsBullet() == false && other->IsBullet() == false)
-					{
-						continue;
-					}
+				// Has this contact already been added to the island?
+				if (contact->m_flags & b2Contact::e_islandFlag)
+				{
+					continue;
+				}
 
-					// Skip sensors.
-					bool sensorA = contact->m_fixtureA->m_isSensor;
-					bool sensorB = contact->m_fixtureB->m_isSensor;
-					if (sensorA || sensorB)
-					{
-						continue;
-					}
+				// Only add static, kinematic, or bullet bodies.
+				b2Body* other = ce->other;
+				if (other->m_type == b2_dynamicBody &&
+					body->IsBullet() == false && other->IsBullet() == false)
+				{
+					continue;
+				}
 
-					// Tentatively advance the body to the TOI.
-					b2Sweep backup = other->m_sweep;
-					if ((other->m_flags & b2Body::e_islandFlag) == 0)
-					{
-						other->Advance(minAlpha);
-					}
+				// Skip sensors.
+				bool sensorA = contact->m_fixtureA->m_isSensor;
+				bool sensorB = contact->m_fixtureB->m_isSensor;
+				if (sensorA || sensorB)
+				{
+					continue;
+				}
 
-					// Update the contact points
-					contact->Update(m_contactManager.m_contactListener);
+				// Tentatively advance the body to the TOI.
+				b2Sweep backup = other->Sweep();
+				if ((other->m_flags & b2Body::e_islandFlag) == 0 && other->m_type != b2_staticBody)
+				{
+					other->Advance(minAlpha);
+				}
 
-					// Was the contact disabled by the user?
-					if (contact->IsEnabled() == false)
-					{
-						other->m_sweep = backup;
-						other->SynchronizeTransform();
-						continue;
-					}
+				// Update the contact points
+				contact->Update(m_contactManager.m_contactListener, m_contactManager.m_contactEvents);
 
-					// Are there contact points?
-					if (contact->IsTouching() == false)
-					{
-						other->m_sweep = backup;
-						other->SynchronizeTransform();
-						continue;
-					}
+				// Was the contact disabled by the user?
+				if (contact->IsEnabled() == false)
+				{
+					other->Sweep() = backup;
+					other->SynchronizeTransform();
+					continue;
+				}
 
-					// Add the contact to the island
-					contact->m_flags |= b2Contact::e_islandFlag;
-					island.Add(contact);
+				// Are there contact points?
+				if (contact->IsTouching() == false)
+				{
+					other->Sweep() = backup;
+					other->SynchronizeTransform();
+					continue;
+				}
 
-					// Has the other body already been added to the island?
-					if (other->m_flags & b2Body::e_islandFlag)
-					{
-						continue;
-					}
-					
-					// Add the other body to the island.
-					other->m_flags |= b2Body::e_islandFlag;
+				// Add the contact to the island
+				contact->m_flags |= b2Contact::e_islandFlag;
+				island->Add(contact);
 
-					if (other->m_type != b2_staticBody)
-					{
-						other->SetAwake(true);
-					}
+				// Has the other body already been added to the island?
+				if (other->m_flags & b2Body::e_islandFlag)
+				{
+					continue;
+				}
+				
+				// Add the other body to the island.
+				other->m_flags |= b2Body::e_islandFlag;
 
-					island.Add(other);
+				if (other->m_type != b2_staticBody)
+				{
+					other->SetAwake(true);
 				}
+
+				island->Add(other);
 			}
 		}
+	}
 
-		b2TimeStep subStep;
-		subStep.dt = (1.0f - minAlpha) * step.dt;
-		subStep.inv_dt = 1.0f / subStep.dt;
-		subStep.dtRatio = 1.0f;
-		subStep.positionIterations = 20;
-		subStep.velocityIterations = step.velocityIterations;
-		subStep.warmStarting = false;
-		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
-
-		// Reset island flags and synchronize broad-phase proxies.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
-		{
-			b2Body* body = island.m_bodies[i];
-			body->m_flags &= ~b2Body::e_islandFlag;
+	b2TimeStep subStep;
+	subStep.dt = (1.0f - minAlpha) * step.dt;
+	subStep.inv_dt = 1.0f / subStep.dt;
+	subStep.dtRatio = 1.0f;
+	subStep.positionIterations = 20;
+	subStep.velocityIterations = step.velocityIterations;
+	subStep.warmStarting = false;
+	subStep.wideSolving = false;
+	subStep.timeToSleep = step.timeToSleep;
+	island->SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
+
+	// The bodies of the island were woken above, they may be reported by Solve already.
+	if (m_bodyMoveEventsEnabled)
+	{
+		b2BodyMoveEvents& moves = m_bodyMoveEvents;
+		ReserveBodyMoveEvents(island->m_bodyCount);
 
-			if (body->m_type != b2_dynamicBody)
+		for (int32 i = 0; i < island->m_bodyCount; ++i)
+		{
+			b2Body* body = island->m_bodies[i];
+			if (body->m_type == b2_staticBody)
 			{
 				continue;
 			}
 
-			body->SynchronizeFixtures();
+			b2BodyMoveEvent* event = moves.events + moves.count++;
+			event->body = body;
+			event->fellAsleep = false;
+		}
+	}
 
-			// Invalidate all contact TOIs on this displaced body.
-			for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
-			{
-				ce->contact->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
-			}
+	// Reset island flags and synchronize broad-phase proxies.
+	for (int32 i = 0; i < island->m_bodyCount; ++i)
+	{
+		b2Body* body = island->m_bodies[i];
+		body->m_flags &= ~b2Body::e_islandFlag;
+
+		if (body->m_type != b2_dynamicBody)
+		{
+			continue;
 		}
 
-		// Commit fixture proxy movements to the broad-phase so that new contacts are created.
-		// Also, some contacts can be destroyed.
-		m_contactManager.FindNewContacts();
+		body->SynchronizeFixtures();
 
-		if (m_subStepping)
+		// Invalidate all contact TOIs on this displaced body.
+		for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
 		{
-			m_stepComplete = false;
-			break;
+			ce->contact->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
 		}
 	}
+
+	return true;
 }
 
 void b2World::Step(float dt, int32 velocityIterations, int32 positionIterations)
@@ -915,6 +1495,21 @@ void b2World::Step(float dt, int32 velocityIterations, int32 positionIterations)
 
 	m_locked = true;
 
+	// Events are recorded only inside the step, fixtures of them are alive until the user destroys them.
+	if (m_contactEventsEnabled)
+	{
+		m_contactEvents.beginCount = 0;
+		m_contactEvents.endCount = 0;
+		m_contactEvents.hitCount = 0;
+		m_contactManager.m_contactEvents = &m_contactEvents;
+	}
+
+	m_bodyMoveEvents.count = 0;
+
+	// Set by Solve, which doesn't run on every step.
+	m_profile.awakeIslands = 0;
+	m_profile.asleepIslands = 0;
+
 	b2TimeStep step;
 	step.dt = dt;
 	step.velocityIterations	= velocityIterations;
@@ -931,6 +1526,8 @@ void b2World::Step(float dt, int32 velocityIterations, int32 positionIterations)
 	step.dtRatio = m_inv_dt0 * dt;
 
 	step.warmStarting = m_warmStarting;
+	step.wideSolving = m_wideSolving;
+	step.timeToSleep = m_timeToSleep;
 	
 	// Update contacts. This is where some contacts are destroyed.
 	{
@@ -960,16 +1557,52 @@ void b2World::Step(float dt, int32 velocityIterations, int32 positionIterations)
 		m_inv_dt0 = step.inv_dt;
 	}
 
+	// Count after the TOI events, they wake bodies.
+	m_profile.awakeBodies = 0;
+	m_profile.sleepingBodies = 0;
+	for (b2Body* b = m_bodyList; b; b = b->GetNext())
+	{
+		if (b->GetType() != b2_staticBody && b->IsEnabled())
+		{
+			m_profile.awakeBodies += b->IsAwake() ? 1 : 0;
+			m_profile.sleepingBodies += b->IsAwake() ? 0 : 1;
+		}
+	}
+
 	if (m_clearForces)
 	{
 		ClearForces();
 	}
 
+	m_contactManager.m_contactEvents = nullptr;
 	m_locked = false;
 
+	// All per step temporaries are freed. Grow the stacks for the peak of this step,
+	// so the next step does not fall back to the heap.
+	m_profile.stackPeak = m_stackAllocator.GetPeakAllocation();
+	m_profile.stackMallocCount = m_stackAllocator.GetMallocCount();
+	m_stackAllocator.Reset();
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_profile.stackPeak += m_threadAllocators[i].GetPeakAllocation();
+		m_profile.stackMallocCount += m_threadAllocators[i].GetMallocCount();
+		m_threadAllocators[i].Reset();
+	}
+
 	m_profile.step = stepTimer.GetMilliseconds();
 }
 
+void b2World::ReserveBodyMoveEvents(int32 count)
+{
+	b2BodyMoveEvents& moves = m_bodyMoveEvents;
+	if (moves.count + count > moves.capacity)
+	{
+		int32 capacity = b2Max(b2Max(16, 2 * moves.capacity), moves.count + count);
+		moves.events = (b2BodyMoveEvent*)b2Reallocate(moves.events, moves.count * sizeof(b2BodyMoveEvent), capacity * sizeof(b2BodyMoveEvent));
+		moves.capacity = capacity;
+	}
+}
+
 void b2World::ClearForces()
 {
 	for (b2Body* body = m_bodyList; body; body = body->GetNext())
@@ -1036,6 +1669,86 @@ void b2World::RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b
 	m_contactManager.m_broadPhase.RayCast(&wrapper, input);
 }
 
+struct b2WorldQueryBatchWrapper
+{
+	bool QueryCallback(int32 index, int32 proxyId)
+	{
+		if (count < capacity)
+		{
+			b2FixtureProxy* proxy = (b2FixtureProxy*)broadPhase->GetUserData(proxyId);
+			hits[count].index = index;
+			hits[count].fixture = proxy->fixture;
+			hits[count].childIndex = proxy->childIndex;
+		}
+		++count;
+		return true;
+	}
+
+	const b2BroadPhase* broadPhase;
+	b2QueryHit* hits;
+	int32 capacity;
+	int32 count;
+};
+
+int32 b2World::QueryAABBBatch(const b2AABB* aabbs, int32 count, b2QueryHit* hits, int32 capacity) const
+{
+	b2WorldQueryBatchWrapper wrapper;
+	wrapper.broadPhase = &m_contactManager.m_broadPhase;
+	wrapper.hits = hits;
+	wrapper.capacity = capacity;
+	wrapper.count = 0;
+	m_contactManager.m_broadPhase.QueryBatch(&wrapper, aabbs, count);
+	return wrapper.count;
+}
+
+struct b2WorldRayCastClosestWrapper
+{
+	float RayCastCallback(int32 index, const b2RayCastInput& input, int32 proxyId)
+	{
+		b2FixtureProxy* proxy = (b2FixtureProxy*)broadPhase->GetUserData(proxyId);
+		b2Fixture* fixture = proxy->fixture;
+		if (fixture->IsSensor() || (fixture->GetFilterData().categoryBits & maskBits) == 0)
+		{
+			return -1.0f;
+		}
+
+		b2RayCastOutput output;
+		bool hit = fixture->RayCast(&output, input, proxy->childIndex);
+		if (hit == false)
+		{
+			return input.maxFraction;
+		}
+
+		// The ray is clipped, so any later hit is closer.
+		float fraction = output.fraction;
+		b2RayCastHit* result = hits + index;
+		result->fixture = fixture;
+		result->point = (1.0f - fraction) * input.p1 + fraction * input.p2;
+		result->normal = output.normal;
+		result->fraction = fraction;
+		return fraction;
+	}
+
+	const b2BroadPhase* broadPhase;
+	b2RayCastHit* hits;
+	uint16 maskBits;
+};
+
+void b2World::RayCastClosest(const b2RayCastInput* inputs, int32 count, b2RayCastHit* hits, uint16 maskBits) const
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		hits[i].fixture = nullptr;
+		hits[i].fraction = inputs[i].maxFraction;
+	}
+
+	b2WorldRayCastClosestWrapper wrapper;
+	wrapper.broadPhase = &m_contactManager.m_broadPhase;
+	wrapper.hits = hits;
+	wrapper.maskBits = maskBits;
+	m_contactManager.m_broadPhase.RayCastBatch(&wrapper, inputs, count);
+}
+
 void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color& color)
 {
 	switch (fixture->GetType())
@@ -1214,6 +1927,28 @@ void b2World::DebugDraw()
 	}
 }
 
+void b2World::SetBroadPhaseType(b2BroadPhaseType type)
+{
+	b2Assert(IsLocked() == false);
+	m_contactManager.m_broadPhase.SetType(type);
+}
+
+b2BroadPhaseType b2World::GetBroadPhaseType() const
+{
+	return m_contactManager.m_broadPhase.GetType();
+}
+
+void b2World::SetGridCellSize(float cellSize)
+{
+	b2Assert(IsLocked() == false);
+	m_contactManager.m_broadPhase.SetGridCellSize(cellSize);
+}
+
+float b2World::GetGridCellSize() const
+{
+	return m_contactManager.m_broadPhase.GetGridCellSize();
+}
+
 int32 b2World::GetProxyCount() const
 {
 	return m_contactManager.m_broadPhase.GetProxyCount();
@@ -1244,9 +1979,10 @@ void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 
 	for (b2Body* b = m_bodyList; b; b = b->m_next)
 	{
-		b->m_xf.p -= newOrigin;
-		b->m_sweep.c0 -= newOrigin;
-		b->m_sweep.c -= newOrigin;
+		b2Sweep& sweep = b->Sweep();
+		b->Transform().p -= newOrigin;
+		sweep.c0 -= newOrigin;
+		sweep.c -= newOrigin;
 	}
 
 	for (b2Joint* j = m_jointList; j; j = j->m_next)
@@ -1257,6 +1993,22 @@ void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 	m_contactManager.m_broadPhase.ShiftOrigin(newOrigin);
 }
 
+void b2World::CompactMemory()
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_blockAllocator.Compact();
+}
+
+void b2World::GetMemoryStats(b2BlockAllocatorStats* stats) const
+{
+	m_blockAllocator.GetStats(stats);
+}
+
 void b2World::Dump()
 {
 	if (m_locked)
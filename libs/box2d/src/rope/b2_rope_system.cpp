@@ -0,0 +1,1099 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "box2d/b2_draw.h"
+#include "box2d/b2_rope_system.h"
+#include "box2d/b2_task_scheduler.h"
+
+#include "common/b2_simd.h"
+
+#include <new>
+#include <string.h>
+
+struct b2RopeRange
+{
+	int32 index;
+	int32 oddIndex;		// slot of particle 1, see b2GetSlot
+	int32 count;
+	b2Vec2 position;
+	b2Vec2 gravity;
+	b2RopeTuning tuning;
+};
+
+// Steps a range of ropes, every rope is touched by one thread only.
+class b2RopeSystemTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
+	{
+		B2_NOT_USED(threadIndex);
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			system->StepRope(system->m_ropes + i, dt, iterations);
+		}
+	}
+
+	b2RopeSystem* system;
+	float dt;
+	int32 iterations;
+};
+
+static inline b2Vec2 b2LoadVec2(const float* xs, const float* ys, int32 i)
+{
+	return b2Vec2(xs[i], ys[i]);
+}
+
+static inline void b2StoreVec2(float* xs, float* ys, int32 i, const b2Vec2& v)
+{
+	xs[i] = v.x;
+	ys[i] = v.y;
+}
+
+// Slot of particle i of the rope, or of stretch constraint i connecting particles i and i + 1.
+// Even ones come first, then odd ones, so constraints of the same color and both of their
+// particles are contiguous.
+static inline int32 b2GetSlot(const b2RopeRange* rope, int32 i)
+{
+	return ((i & 1) == 0 ? rope->index : rope->oddIndex) + (i >> 1);
+}
+
+b2RopeSystem::b2RopeSystem()
+{
+	m_ropes = nullptr;
+	m_ropeCount = 0;
+	m_ropeCapacity = 0;
+
+	m_particleCount = 0;
+	m_particleCapacity = 0;
+
+	m_pxs = nullptr;
+	m_pys = nullptr;
+	m_p0xs = nullptr;
+	m_p0ys = nullptr;
+	m_vxs = nullptr;
+	m_vys = nullptr;
+	m_bindXs = nullptr;
+	m_bindYs = nullptr;
+	m_invMasses = nullptr;
+
+	m_stretchLs = nullptr;
+	m_stretchLambdas = nullptr;
+	m_stretchSprings = nullptr;
+	m_stretchDampers = nullptr;
+
+	m_bendL1s = nullptr;
+	m_bendL2s = nullptr;
+	m_bendAlpha1s = nullptr;
+	m_bendAlpha2s = nullptr;
+	m_bendInvEffectiveMasses = nullptr;
+	m_bendLambdas = nullptr;
+	m_bendSprings = nullptr;
+	m_bendDampers = nullptr;
+
+	m_taskScheduler = nullptr;
+}
+
+b2RopeSystem::~b2RopeSystem()
+{
+	// Release the arrays by growing them to nothing.
+	m_particleCount = 0;
+	Grow(0);
+
+	b2Free(m_ropes);
+}
+
+void b2RopeSystem::Grow(int32 particleCapacity)
+{
+	float** arrays[] =
+	{
+		&m_pxs, &m_pys, &m_p0xs, &m_p0ys, &m_vxs, &m_vys, &m_bindXs, &m_bindYs, &m_invMasses,
+		&m_stretchLs, &m_stretchLambdas, &m_stretchSprings, &m_stretchDampers,
+		&m_bendL1s, &m_bendL2s, &m_bendAlpha1s, &m_bendAlpha2s, &m_bendInvEffectiveMasses,
+		&m_bendLambdas, &m_bendSprings, &m_bendDampers
+	};
+
+	for (float** array : arrays)
+	{
+		float* data = nullptr;
+		if (particleCapacity > 0)
+		{
+			data = (float*)b2Alloc(particleCapacity * sizeof(float));
+			if (m_particleCount > 0)
+			{
+				memcpy(data, *array, m_particleCount * sizeof(float));
+			}
+		}
+
+		b2Free(*array);
+		*array = data;
+	}
+
+	m_particleCapacity = particleCapacity;
+}
+
+int32 b2RopeSystem::CreateRope(const b2RopeDef& def)
+{
+	b2Assert(def.count >= 3);
+
+	if (m_ropeCount == m_ropeCapacity)
+	{
+		b2RopeRange* oldRopes = m_ropes;
+		m_ropeCapacity = b2Max(2 * m_ropeCapacity, 16);
+		m_ropes = (b2RopeRange*)b2Alloc(m_ropeCapacity * sizeof(b2RopeRange));
+		if (m_ropeCount > 0)
+		{
+			memcpy(m_ropes, oldRopes, m_ropeCount * sizeof(b2RopeRange));
+		}
+		b2Free(oldRopes);
+	}
+
+	if (m_particleCount + def.count > m_particleCapacity)
+	{
+		Grow(b2Max(2 * m_particleCapacity, m_particleCount + def.count));
+	}
+
+	int32 ropeIndex = m_ropeCount++;
+	b2RopeRange* rope = new (m_ropes + ropeIndex) b2RopeRange;
+	rope->index = m_particleCount;
+	rope->oddIndex = m_particleCount + (def.count + 1) / 2;
+	rope->count = def.count;
+	rope->position = def.position;
+	rope->gravity = def.gravity;
+
+	m_particleCount += def.count;
+
+	for (int32 i = 0; i < def.count; ++i)
+	{
+		int32 j = b2GetSlot(rope, i);
+		b2Vec2 p = def.vertices[i] + def.position;
+
+		m_bindXs[j] = def.vertices[i].x;
+		m_bindYs[j] = def.vertices[i].y;
+		m_pxs[j] = p.x;
+		m_pys[j] = p.y;
+		m_p0xs[j] = p.x;
+		m_p0ys[j] = p.y;
+		m_vxs[j] = 0.0f;
+		m_vys[j] = 0.0f;
+
+		float m = def.masses[i];
+		if (m > 0.0f)
+		{
+			m_invMasses[j] = 1.0f / m;
+		}
+		else
+		{
+			m_invMasses[j] = 0.0f;
+		}
+
+		// The constraint slots past the end of the rope are never solved.
+		m_stretchLs[j] = 0.0f;
+		m_stretchLambdas[j] = 0.0f;
+		m_stretchSprings[j] = 0.0f;
+		m_stretchDampers[j] = 0.0f;
+
+		m_bendL1s[j] = 0.0f;
+		m_bendL2s[j] = 0.0f;
+		m_bendAlpha1s[j] = 0.0f;
+		m_bendAlpha2s[j] = 0.0f;
+		m_bendInvEffectiveMasses[j] = 0.0f;
+		m_bendLambdas[j] = 0.0f;
+		m_bendSprings[j] = 0.0f;
+		m_bendDampers[j] = 0.0f;
+	}
+
+	for (int32 i = 0; i < def.count - 1; ++i)
+	{
+		const int32 i1 = b2GetSlot(rope, i);
+		b2Vec2 p1 = b2LoadVec2(m_pxs, m_pys, i1);
+		b2Vec2 p2 = b2LoadVec2(m_pxs, m_pys, b2GetSlot(rope, i + 1));
+		m_stretchLs[i1] = b2Distance(p1, p2);
+	}
+
+	const int32 first = rope->index;
+	for (int32 n = 0; n < def.count - 2; ++n)
+	{
+		const int32 i = first + n;
+		const int32 i1 = b2GetSlot(rope, n);
+		const int32 i2 = b2GetSlot(rope, n + 1);
+		const int32 i3 = b2GetSlot(rope, n + 2);
+
+		b2Vec2 p1 = b2LoadVec2(m_pxs, m_pys, i1);
+		b2Vec2 p2 = b2LoadVec2(m_pxs, m_pys, i2);
+		b2Vec2 p3 = b2LoadVec2(m_pxs, m_pys, i3);
+
+		m_bendL1s[i] = b2Distance(p1, p2);
+		m_bendL2s[i] = b2Distance(p2, p3);
+
+		// Pre-compute effective mass
+		b2Vec2 e1 = p2 - p1;
+		b2Vec2 e2 = p3 - p2;
+		float L1sqr = e1.LengthSquared();
+		float L2sqr = e2.LengthSquared();
+
+		if (L1sqr * L2sqr == 0.0f)
+		{
+			continue;
+		}
+
+		b2Vec2 Jd1 = (-1.0f / L1sqr) * e1.Skew();
+		b2Vec2 Jd2 = (1.0f / L2sqr) * e2.Skew();
+
+		b2Vec2 J1 = -Jd1;
+		b2Vec2 J2 = Jd1 - Jd2;
+		b2Vec2 J3 = Jd2;
+
+		m_bendInvEffectiveMasses[i] = m_invMasses[i1] * b2Dot(J1, J1) + m_invMasses[i2] * b2Dot(J2, J2) + m_invMasses[i3] * b2Dot(J3, J3);
+
+		b2Vec2 r = p3 - p1;
+
+		float rr = r.LengthSquared();
+		if (rr == 0.0f)
+		{
+			continue;
+		}
+
+		// a1 = h2 / (h1 + h2)
+		// a2 = h1 / (h1 + h2)
+		m_bendAlpha1s[i] = b2Dot(e2, r) / rr;
+		m_bendAlpha2s[i] = b2Dot(e1, r) / rr;
+	}
+
+	SetTuning(ropeIndex, def.tuning);
+
+	return ropeIndex;
+}
+
+void b2RopeSystem::Clear()
+{
+	m_ropeCount = 0;
+	m_particleCount = 0;
+}
+
+void b2RopeSystem::SetTuning(int32 ropeIndex, const b2RopeTuning& tuning)
+{
+	b2Assert(0 <= ropeIndex && ropeIndex < m_ropeCount);
+	b2RopeRange* rope = m_ropes + ropeIndex;
+	rope->tuning = tuning;
+
+	// Pre-compute spring and damper values based on tuning
+
+	const float bendOmega = 2.0f * b2_pi * tuning.bendHertz;
+
+	for (int32 n = 0; n < rope->count - 2; ++n)
+	{
+		const int32 i = rope->index + n;
+		const int32 i1 = b2GetSlot(rope, n);
+		const int32 i2 = b2GetSlot(rope, n + 1);
+		const int32 i3 = b2GetSlot(rope, n + 2);
+
+		float L1 = m_bendL1s[i];
+		float L2 = m_bendL2s[i];
+		float L1sqr = L1 * L1;
+		float L2sqr = L2 * L2;
+
+		m_bendSprings[i] = 0.0f;
+		m_bendDampers[i] = 0.0f;
+
+		if (L1sqr * L2sqr == 0.0f)
+		{
+			continue;
+		}
+
+		// Flatten the triangle formed by the two edges
+		float J2 = 1.0f / L1 + 1.0f / L2;
+		float sum = m_invMasses[i1] / L1sqr + m_invMasses[i2] * J2 * J2 + m_invMasses[i3] / L2sqr;
+		if (sum == 0.0f)
+		{
+			continue;
+		}
+
+		float mass = 1.0f / sum;
+
+		m_bendSprings[i] = mass * bendOmega * bendOmega;
+		m_bendDampers[i] = 2.0f * mass * tuning.bendDamping * bendOmega;
+	}
+
+	const float stretchOmega = 2.0f * b2_pi * tuning.stretchHertz;
+
+	for (int32 n = 0; n < rope->count - 1; ++n)
+	{
+		const int32 i = b2GetSlot(rope, n);
+		float sum = m_invMasses[i] + m_invMasses[b2GetSlot(rope, n + 1)];
+		if (sum == 0.0f)
+		{
+			continue;
+		}
+
+		float mass = 1.0f / sum;
+
+		m_stretchSprings[i] = mass * stretchOmega * stretchOmega;
+		m_stretchDampers[i] = 2.0f * mass * tuning.stretchDamping * stretchOmega;
+	}
+}
+
+void b2RopeSystem::SetPosition(int32 ropeIndex, const b2Vec2& position)
+{
+	b2Assert(0 <= ropeIndex && ropeIndex < m_ropeCount);
+	m_ropes[ropeIndex].position = position;
+}
+
+void b2RopeSystem::Reset(int32 ropeIndex, const b2Vec2& position)
+{
+	b2Assert(0 <= ropeIndex && ropeIndex < m_ropeCount);
+	b2RopeRange* rope = m_ropes + ropeIndex;
+	rope->position = position;
+
+	const int32 end = rope->index + rope->count;
+	for (int32 i = rope->index; i < end; ++i)
+	{
+		m_pxs[i] = m_bindXs[i] + position.x;
+		m_pys[i] = m_bindYs[i] + position.y;
+		m_p0xs[i] = m_pxs[i];
+		m_p0ys[i] = m_pys[i];
+		m_vxs[i] = 0.0f;
+		m_vys[i] = 0.0f;
+		m_stretchLambdas[i] = 0.0f;
+		m_bendLambdas[i] = 0.0f;
+	}
+}
+
+int32 b2RopeSystem::GetVertexCount(int32 ropeIndex) const
+{
+	b2Assert(0 <= ropeIndex && ropeIndex < m_ropeCount);
+	return m_ropes[ropeIndex].count;
+}
+
+b2Vec2 b2RopeSystem::GetVertex(int32 ropeIndex, int32 vertexIndex) const
+{
+	b2Assert(0 <= ropeIndex && ropeIndex < m_ropeCount);
+	const b2RopeRange* rope = m_ropes + ropeIndex;
+	b2Assert(0 <= vertexIndex && vertexIndex < rope->count);
+	return b2LoadVec2(m_pxs, m_pys, b2GetSlot(rope, vertexIndex));
+}
+
+void b2RopeSystem::Step(float dt, int32 iterations)
+{
+	if (dt == 0.0f)
+	{
+		return;
+	}
+
+	b2RopeSystemTask task;
+	task.system = this;
+	task.dt = dt;
+	task.iterations = iterations;
+
+	if (m_taskScheduler != nullptr)
+	{
+		m_taskScheduler->ParallelFor(&task, m_ropeCount, 1);
+	}
+	else
+	{
+		task.Execute(0, m_ropeCount, 0);
+	}
+}
+
+void b2RopeSystem::StepRope(b2RopeRange* rope, float dt, int32 iterations)
+{
+	const b2RopeTuning& tuning = rope->tuning;
+	const int32 first = rope->index;
+	const int32 end = rope->index + rope->count;
+
+	const float inv_dt = 1.0f / dt;
+	float d = expf(- dt * tuning.damping);
+
+	// Apply gravity and damping
+	for (int32 i = first; i < end; ++i)
+	{
+		if (m_invMasses[i] > 0.0f)
+		{
+			m_vxs[i] = d * m_vxs[i] + dt * rope->gravity.x;
+			m_vys[i] = d * m_vys[i] + dt * rope->gravity.y;
+		}
+		else
+		{
+			m_vxs[i] = inv_dt * (m_bindXs[i] + rope->position.x - m_p0xs[i]);
+			m_vys[i] = inv_dt * (m_bindYs[i] + rope->position.y - m_p0ys[i]);
+		}
+	}
+
+	// Apply bending spring
+	if (tuning.bendingModel == b2_springAngleBendingModel)
+	{
+		ApplyBendForces(rope, dt);
+	}
+
+	for (int32 i = first; i < end; ++i)
+	{
+		m_bendLambdas[i] = 0.0f;
+		m_stretchLambdas[i] = 0.0f;
+	}
+
+	// Update position
+	for (int32 i = first; i < end; ++i)
+	{
+		m_pxs[i] += dt * m_vxs[i];
+		m_pys[i] += dt * m_vys[i];
+	}
+
+	// Solve constraints
+	for (int32 i = 0; i < iterations; ++i)
+	{
+		if (tuning.bendingModel == b2_pbdAngleBendingModel)
+		{
+			SolveBend_PBD_Angle(rope);
+		}
+		else if (tuning.bendingModel == b2_xpbdAngleBendingModel)
+		{
+			SolveBend_XPBD_Angle(rope, dt);
+		}
+		else if (tuning.bendingModel == b2_pbdDistanceBendingModel)
+		{
+			SolveBend_PBD_Distance(rope);
+		}
+		else if (tuning.bendingModel == b2_pbdHeightBendingModel)
+		{
+			SolveBend_PBD_Height(rope);
+		}
+
+		if (tuning.stretchingModel == b2_pbdStretchingModel)
+		{
+			SolveStretch_PBD(rope);
+		}
+		else if (tuning.stretchingModel == b2_xpbdStretchingModel)
+		{
+			SolveStretch_XPBD(rope, dt);
+		}
+	}
+
+	// Constrain velocity
+	for (int32 i = first; i < end; ++i)
+	{
+		m_vxs[i] = inv_dt * (m_pxs[i] - m_p0xs[i]);
+		m_vys[i] = inv_dt * (m_pys[i] - m_p0ys[i]);
+		m_p0xs[i] = m_pxs[i];
+		m_p0ys[i] = m_pys[i];
+	}
+}
+
+void b2RopeSystem::SolveStretch_PBD(const b2RopeRange* rope)
+{
+	const float stiffness = rope->tuning.stretchStiffness;
+
+	const b2FloatW stiffnessW = b2SplatW(stiffness);
+	const b2FloatW epsilonW = b2SplatW(b2_epsilon);
+	const b2FloatW zeroW = b2SplatW(0.0f);
+	const b2FloatW oneW = b2SplatW(1.0f);
+
+	for (int32 color = 0; color < 2; ++color)
+	{
+		// Constraint k of the color is at slot i1 + k and connects particles at i1 + k and i2 + k.
+		const int32 i1 = color == 0 ? rope->index : rope->oddIndex;
+		const int32 i2 = color == 0 ? rope->oddIndex : rope->index + 1;
+		const int32 count = color == 0 ? rope->count / 2 : (rope->count - 1) / 2;
+
+		int32 k = 0;
+
+		// Four constraints of the same color at once.
+		for (; k + b2_simdWidth <= count; k += b2_simdWidth)
+		{
+			const int32 j1 = i1 + k;
+			const int32 j2 = i2 + k;
+
+			b2FloatW x1 = b2LoadW(m_pxs + j1);
+			b2FloatW y1 = b2LoadW(m_pys + j1);
+			b2FloatW x2 = b2LoadW(m_pxs + j2);
+			b2FloatW y2 = b2LoadW(m_pys + j2);
+			b2FloatW invMass1 = b2LoadW(m_invMasses + j1);
+			b2FloatW invMass2 = b2LoadW(m_invMasses + j2);
+
+			b2FloatW dx = x2 - x1;
+			b2FloatW dy = y2 - y1;
+			b2FloatW length = b2SqrtW(dx * dx + dy * dy);
+
+			// Same as b2Vec2::Normalize, short vectors are left as they are.
+			b2MaskW isShort = b2LessW(length, epsilonW);
+			b2FloatW invLength = b2SelectW(isShort, oneW, oneW / length);
+			length = b2SelectW(isShort, zeroW, length);
+			dx = dx * invLength;
+			dy = dy * invLength;
+
+			b2FloatW sum = invMass1 + invMass2;
+			b2MaskW solve = b2GreaterW(sum, zeroW);
+
+			b2FloatW s1 = invMass1 / sum;
+			b2FloatW s2 = invMass2 / sum;
+
+			b2FloatW C = b2LoadW(m_stretchLs + j1) - length;
+			b2FloatW c1 = stiffnessW * s1 * C;
+			b2FloatW c2 = stiffnessW * s2 * C;
+
+			b2StoreW(m_pxs + j1, b2SelectW(solve, x1 - c1 * dx, x1));
+			b2StoreW(m_pys + j1, b2SelectW(solve, y1 - c1 * dy, y1));
+			b2StoreW(m_pxs + j2, b2SelectW(solve, x2 + c2 * dx, x2));
+			b2StoreW(m_pys + j2, b2SelectW(solve, y2 + c2 * dy, y2));
+		}
+
+		for (; k < count; ++k)
+		{
+			const int32 j1 = i1 + k;
+			const int32 j2 = i2 + k;
+
+			b2Vec2 p1 = b2LoadVec2(m_pxs, m_pys, j1);
+			b2Vec2 p2 = b2LoadVec2(m_pxs, m_pys, j2);
+
+			b2Vec2 d = p2 - p1;
+			float L = d.Normalize();
+
+			float invMass1 = m_invMasses[j1];
+			float invMass2 = m_invMasses[j2];
+			float sum = invMass1 + invMass2;
+			if (sum == 0.0f)
+			{
+				continue;
+			}
+
+			float s1 = invMass1 / sum;
+			float s2 = invMass2 / sum;
+
+			p1 -= stiffness * s1 * (m_stretchLs[j1] - L) * d;
+			p2 += stiffness * s2 * (m_stretchLs[j1] - L) * d;
+
+			b2StoreVec2(m_pxs, m_pys, j1, p1);
+			b2StoreVec2(m_pxs, m_pys, j2, p2);
+		}
+	}
+}
+
+void b2RopeSystem::SolveStretch_XPBD(const b2RopeRange* rope, float dt)
+{
+	b2Assert(dt > 0.0f);
+
+	const b2FloatW dtW = b2SplatW(dt);
+	const b2FloatW epsilonW = b2SplatW(b2_epsilon);
+	const b2FloatW zeroW = b2SplatW(0.0f);
+	const b2FloatW oneW = b2SplatW(1.0f);
+
+	for (int32 color = 0; color < 2; ++color)
+	{
+		// Constraint k of the color is at slot i1 + k and connects particles at i1 + k and i2 + k.
+		const int32 i1 = color == 0 ? rope->index : rope->oddIndex;
+		const int32 i2 = color == 0 ? rope->oddIndex : rope->index + 1;
+		const int32 count = color == 0 ? rope->count / 2 : (rope->count - 1) / 2;
+
+		int32 k = 0;
+
+		// Four constraints of the same color at once.
+		for (; k + b2_simdWidth <= count; k += b2_simdWidth)
+		{
+			const int32 j1 = i1 + k;
+			const int32 j2 = i2 + k;
+
+			b2FloatW x1 = b2LoadW(m_pxs + j1);
+			b2FloatW y1 = b2LoadW(m_pys + j1);
+			b2FloatW x2 = b2LoadW(m_pxs + j2);
+			b2FloatW y2 = b2LoadW(m_pys + j2);
+			b2FloatW invMass1 = b2LoadW(m_invMasses + j1);
+			b2FloatW invMass2 = b2LoadW(m_invMasses + j2);
+
+			b2FloatW dx1 = x1 - b2LoadW(m_p0xs + j1);
+			b2FloatW dy1 = y1 - b2LoadW(m_p0ys + j1);
+			b2FloatW dx2 = x2 - b2LoadW(m_p0xs + j2);
+			b2FloatW dy2 = y2 - b2LoadW(m_p0ys + j2);
+
+			b2FloatW ux = x2 - x1;
+			b2FloatW uy = y2 - y1;
+			b2FloatW length = b2SqrtW(ux * ux + uy * uy);
+
+			// Same as b2Vec2::Normalize, short vectors are left as they are.
+			b2MaskW isShort = b2LessW(length, epsilonW);
+			b2FloatW invLength = b2SelectW(isShort, oneW, oneW / length);
+			length = b2SelectW(isShort, zeroW, length);
+			ux = ux * invLength;
+			uy = uy * invLength;
+
+			b2FloatW sum = invMass1 + invMass2;
+			b2MaskW solve = b2GreaterW(sum, zeroW);
+
+			b2FloatW lambda = b2LoadW(m_stretchLambdas + j1);
+			b2FloatW alpha = oneW / (b2LoadW(m_stretchSprings + j1) * dtW * dtW);
+			b2FloatW beta = dtW * dtW * b2LoadW(m_stretchDampers + j1);
+			b2FloatW sigma = alpha * beta / dtW;
+			b2FloatW C = length - b2LoadW(m_stretchLs + j1);
+
+			// This is using the initial velocities, J1 = -u and J2 = u
+			b2FloatW Cdot = (-ux * dx1 + -uy * dy1) + (ux * dx2 + uy * dy2);
+
+			b2FloatW B = C + alpha * lambda + sigma * Cdot;
+			b2FloatW sum2 = (oneW + sigma) * sum + alpha;
+
+			b2FloatW impulse = -B / sum2;
+			b2FloatW c1 = invMass1 * impulse;
+			b2FloatW c2 = invMass2 * impulse;
+
+			b2StoreW(m_pxs + j1, b2SelectW(solve, x1 + c1 * -ux, x1));
+			b2StoreW(m_pys + j1, b2SelectW(solve, y1 + c1 * -uy, y1));
+			b2StoreW(m_pxs + j2, b2SelectW(solve, x2 + c2 * ux, x2));
+			b2StoreW(m_pys + j2, b2SelectW(solve, y2 + c2 * uy, y2));
+			b2StoreW(m_stretchLambdas + j1, b2SelectW(solve, lambda + impulse, lambda));
+		}
+
+		for (; k < count; ++k)
+		{
+			const int32 j1 = i1 + k;
+			const int32 j2 = i2 + k;
+
+			b2Vec2 p1 = b2LoadVec2(m_pxs, m_pys, j1);
+			b2Vec2 p2 = b2LoadVec2(m_pxs, m_pys, j2);
+
+			b2Vec2 dp1 = p1 - b2LoadVec2(m_p0xs, m_p0ys, j1);
+			b2Vec2 dp2 = p2 - b2LoadVec2(m_p0xs, m_p0ys, j2);
+
+			b2Vec2 u = p2 - p1;
+			float L = u.Normalize();
+
+			b2Vec2 J1 = -u;
+			b2Vec2 J2 = u;
+
+			float invMass1 = m_invMasses[j1];
+			float invMass2 = m_invMasses[j2];
+			float sum = invMass1 + invMass2;
+			if (sum == 0.0f)
+			{
+				continue;
+			}
+
+			const float alpha = 1.0f / (m_stretchSprings[j1] * dt * dt);	// 1 / kg
+			const float beta = dt * dt * m_stretchDampers[j1];				// kg * s
+			const float sigma = alpha * beta / dt;							// non-dimensional
+			float C = L - m_stretchLs[j1];
+
+			// This is using the initial velocities
+			float Cdot = b2Dot(J1, dp1) + b2Dot(J2, dp2);
+
+			float B = C + alpha * m_stretchLambdas[j1] + sigma * Cdot;
+			float sum2 = (1.0f + sigma) * sum + alpha;
+
+			float impulse = -B / sum2;
+
+			p1 += (invMass1 * impulse) * J1;
+			p2 += (invMass2 * impulse) * J2;
+
+			b2StoreVec2(m_pxs, m_pys, j1, p1);
+			b2StoreVec2(m_pxs, m_pys, j2, p2);
+			m_stretchLambdas[j1] += impulse;
+		}
+	}
+}
+
+void b2RopeSystem::SolveBend_PBD_Angle(const b2RopeRange* rope)
+{
+	const b2RopeTuning& tuning = rope->tuning;
+	const float stiffness = tuning.bendStiffness;
+	const int32 end = rope->index + rope->count - 2;
+
+	for (int32 i = rope->index; i < end; ++i)
+	{
+		const int32 i1 = b2GetSlot(rope, i - rope->index);
+		const int32 i2 = b2GetSlot(rope, i - rope->index + 1);
+		const int32 i3 = b2GetSlot(rope, i - rope->index + 2);
+
+		b2Vec2 p1 = b2LoadVec2(m_pxs, m_pys, i1);
+		b2Vec2 p2 = b2LoadVec2(m_pxs, m_pys, i2);
+		b2Vec2 p3 = b2LoadVec2(m_pxs, m_pys, i3);
+
+		float invMass1 = m_invMasses[i1];
+		float invMass2 = m_invMasses[i2];
+		float invMass3 = m_invMasses[i3];
+
+		b2Vec2 d1 = p2 - p1;
+		b2Vec2 d2 = p3 - p2;
+		float a = b2Cross(d1, d2);
+		float b = b2Dot(d1, d2);
+
+		float angle = b2Atan2(a, b);
+
+		float L1sqr, L2sqr;
+
+		if (tuning.isometric)
+		{
+			L1sqr = m_bendL1s[i] * m_bendL1s[i];
+			L2sqr = m_bendL2s[i] * m_bendL2s[i];
+		}
+		else
+		{
+			L1sqr = d1.LengthSquared();
+			L2sqr = d2.LengthSquared();
+		}
+
+		if (L1sqr * L2sqr == 0.0f)
+		{
+			continue;
+		}
+
+		b2Vec2 Jd1 = (-1.0f / L1sqr) * d1.Skew();
+		b2Vec2 Jd2 = (1.0f / L2sqr) * d2.Skew();
+
+		b2Vec2 J1 = -Jd1;
+		b2Vec2 J2 = Jd1 - Jd2;
+		b2Vec2 J3 = Jd2;
+
+		float sum;
+		if (tuning.fixedEffectiveMass)
+		{
+			sum = m_bendInvEffectiveMasses[i];
+		}
+		else
+		{
+			sum = invMass1 * b2Dot(J1, J1) + invMass2 * b2Dot(J2, J2) + invMass3 * b2Dot(J3, J3);
+		}
+
+		if (sum == 0.0f)
+		{
+			sum = m_bendInvEffectiveMasses[i];
+		}
+
+		float impulse = -stiffness * angle / sum;
+
+		p1 += (invMass1 * impulse) * J1;
+		p2 += (invMass2 * impulse) * J2;
+		p3 += (invMass3 * impulse) * J3;
+
+		b2StoreVec2(m_pxs, m_pys, i1, p1);
+		b2StoreVec2(m_pxs, m_pys, i2, p2);
+		b2StoreVec2(m_pxs, m_pys, i3, p3);
+	}
+}
+
+void b2RopeSystem::SolveBend_XPBD_Angle(const b2RopeRange* rope, float dt)
+{
+	b2Assert(dt > 0.0f);
+
+	const b2RopeTuning& tuning = rope->tuning;
+	const int32 end = rope->index + rope->count - 2;
+
+	for (int32 i = rope->index; i < end; ++i)
+	{
+		const int32 i1 = b2GetSlot(rope, i - rope->index);
+		const int32 i2 = b2GetSlot(rope, i - rope->index + 1);
+		const int32 i3 = b2GetSlot(rope, i - rope->index + 2);
+
+		b2Vec2 p1 = b2LoadVec2(m_pxs, m_pys, i1);
+		b2Vec2 p2 = b2LoadVec2(m_pxs, m_pys, i2);
+		b2Vec2 p3 = b2LoadVec2(m_pxs, m_pys, i3);
+
+		float invMass1 = m_invMasses[i1];
+		float invMass2 = m_invMasses[i2];
+		float invMass3 = m_invMasses[i3];
+
+		b2Vec2 dp1 = p1 - b2LoadVec2(m_p0xs, m_p0ys, i1);
+		b2Vec2 dp2 = p2 - b2LoadVec2(m_p0xs, m_p0ys, i2);
+		b2Vec2 dp3 = p3 - b2LoadVec2(m_p0xs, m_p0ys, i3);
+
+		b2Vec2 d1 = p2 - p1;
+		b2Vec2 d2 = p3 - p2;
+
+		float L1sqr, L2sqr;
+
+		if (tuning.isometric)
+		{
+			L1sqr = m_bendL1s[i] * m_bendL1s[i];
+			L2sqr = m_bendL2s[i] * m_bendL2s[i];
+		}
+		else
+		{
+			L1sqr = d1.LengthSquared();
+			L2sqr = d2.LengthSquared();
+		}
+
+		if (L1sqr * L2sqr == 0.0f)
+		{
+			continue;
+		}
+
+		float a = b2Cross(d1, d2);
+		float b = b2Dot(d1, d2);
+
+		float angle = b2Atan2(a, b);
+
+		b2Vec2 Jd1 = (-1.0f / L1sqr) * d1.Skew();
+		b2Vec2 Jd2 = (1.0f / L2sqr) * d2.Skew();
+
+		b2Vec2 J1 = -Jd1;
+		b2Vec2 J2 = Jd1 - Jd2;
+		b2Vec2 J3 = Jd2;
+
+		float sum;
+		if (tuning.fixedEffectiveMass)
+		{
+			sum = m_bendInvEffectiveMasses[i];
+		}
+		else
+		{
+			sum = invMass1 * b2Dot(J1, J1) + invMass2 * b2Dot(J2, J2) + invMass3 * b2Dot(J3, J3);
+		}
+
+		if (sum == 0.0f)
+		{
+			continue;
+		}
+
+		const float alpha = 1.0f / (m_bendSprings[i] * dt * dt);
+		const float beta = dt * dt * m_bendDampers[i];
+		const float sigma = alpha * beta / dt;
+		float C = angle;
+
+		// This is using the initial velocities
+		float Cdot = b2Dot(J1, dp1) + b2Dot(J2, dp2) + b2Dot(J3, dp3);
+
+		float B = C + alpha * m_bendLambdas[i] + sigma * Cdot;
+		float sum2 = (1.0f + sigma) * sum + alpha;
+
+		float impulse = -B / sum2;
+
+		p1 += (invMass1 * impulse) * J1;
+		p2 += (invMass2 * impulse) * J2;
+		p3 += (invMass3 * impulse) * J3;
+
+		b2StoreVec2(m_pxs, m_pys, i1, p1);
+		b2StoreVec2(m_pxs, m_pys, i2, p2);
+		b2StoreVec2(m_pxs, m_pys, i3, p3);
+		m_bendLambdas[i] += impulse;
+	}
+}
+
+void b2RopeSystem::ApplyBendForces(const b2RopeRange* rope, float dt)
+{
+	const b2RopeTuning& tuning = rope->tuning;
+	const int32 end = rope->index + rope->count - 2;
+
+	// omega = 2 * pi * hz
+	const float omega = 2.0f * b2_pi * tuning.bendHertz;
+
+	for (int32 i = rope->index; i < end; ++i)
+	{
+		const int32 i1 = b2GetSlot(rope, i - rope->index);
+		const int32 i2 = b2GetSlot(rope, i - rope->index + 1);
+		const int32 i3 = b2GetSlot(rope, i - rope->index + 2);
+
+		b2Vec2 p1 = b2LoadVec2(m_pxs, m_pys, i1);
+		b2Vec2 p2 = b2LoadVec2(m_pxs, m_pys, i2);
+		b2Vec2 p3 = b2LoadVec2(m_pxs, m_pys, i3);
+
+		b2Vec2 v1 = b2LoadVec2(m_vxs, m_vys, i1);
+		b2Vec2 v2 = b2LoadVec2(m_vxs, m_vys, i2);
+		b2Vec2 v3 = b2LoadVec2(m_vxs, m_vys, i3);
+
+		float invMass1 = m_invMasses[i1];
+		float invMass2 = m_invMasses[i2];
+		float invMass3 = m_invMasses[i3];
+
+		b2Vec2 d1 = p2 - p1;
+		b2Vec2 d2 = p3 - p2;
+
+		float L1sqr, L2sqr;
+
+		if (tuning.isometric)
+		{
+			L1sqr = m_bendL1s[i] * m_bendL1s[i];
+			L2sqr = m_bendL2s[i] * m_bendL2s[i];
+		}
+		else
+		{
+			L1sqr = d1.LengthSquared();
+			L2sqr = d2.LengthSquared();
+		}
+
+		if (L1sqr * L2sqr == 0.0f)
+		{
+			continue;
+		}
+
+		float a = b2Cross(d1, d2);
+		float b = b2Dot(d1, d2);
+
+		float angle = b2Atan2(a, b);
+
+		b2Vec2 Jd1 = (-1.0f / L1sqr) * d1.Skew();
+		b2Vec2 Jd2 = (1.0f / L2sqr) * d2.Skew();
+
+		b2Vec2 J1 = -Jd1;
+		b2Vec2 J2 = Jd1 - Jd2;
+		b2Vec2 J3 = Jd2;
+
+		float sum;
+		if (tuning.fixedEffectiveMass)
+		{
+			sum = m_bendInvEffectiveMasses[i];
+		}
+		else
+		{
+			sum = invMass1 * b2Dot(J1, J1) + invMass2 * b2Dot(J2, J2) + invMass3 * b2Dot(J3, J3);
+		}
+
+		if (sum == 0.0f)
+		{
+			continue;
+		}
+
+		float mass = 1.0f / sum;
+
+		const float spring = mass * omega * omega;
+		const float damper = 2.0f * mass * tuning.bendDamping * omega;
+
+		float C = angle;
+		float Cdot = b2Dot(J1, v1) + b2Dot(J2, v2) + b2Dot(J3, v3);
+
+		float impulse = -dt * (spring * C + damper * Cdot);
+
+		v1 += (invMass1 * impulse) * J1;
+		v2 += (invMass2 * impulse) * J2;
+		v3 += (invMass3 * impulse) * J3;
+
+		b2StoreVec2(m_vxs, m_vys, i1, v1);
+		b2StoreVec2(m_vxs, m_vys, i2, v2);
+		b2StoreVec2(m_vxs, m_vys, i3, v3);
+	}
+}
+
+void b2RopeSystem::SolveBend_PBD_Distance(const b2RopeRange* rope)
+{
+	const float stiffness = rope->tuning.bendStiffness;
+	const int32 end = rope->index + rope->count - 2;
+
+	for (int32 i = rope->index; i < end; ++i)
+	{
+		int32 i1 = b2GetSlot(rope, i - rope->index);
+		int32 i2 = b2GetSlot(rope, i - rope->index + 2);
+
+		b2Vec2 p1 = b2LoadVec2(m_pxs, m_pys, i1);
+		b2Vec2 p2 = b2LoadVec2(m_pxs, m_pys, i2);
+
+		b2Vec2 d = p2 - p1;
+		float L = d.Normalize();
+
+		float sum = m_invMasses[i1] + m_invMasses[i2];
+		if (sum == 0.0f)
+		{
+			continue;
+		}
+
+		float s1 = m_invMasses[i1] / sum;
+		float s2 = m_invMasses[i2] / sum;
+
+		float C = m_bendL1s[i] + m_bendL2s[i] - L;
+		p1 -= stiffness * s1 * C * d;
+		p2 += stiffness * s2 * C * d;
+
+		b2StoreVec2(m_pxs, m_pys, i1, p1);
+		b2StoreVec2(m_pxs, m_pys, i2, p2);
+	}
+}
+
+// Constraint based implementation of:
+// P. Volino: Simple Linear Bending Stiffness in Particle Systems
+void b2RopeSystem::SolveBend_PBD_Height(const b2RopeRange* rope)
+{
+	const float stiffness = rope->tuning.bendStiffness;
+	const int32 end = rope->index + rope->count - 2;
+
+	for (int32 i = rope->index; i < end; ++i)
+	{
+		const int32 i1 = b2GetSlot(rope, i - rope->index);
+		const int32 i2 = b2GetSlot(rope, i - rope->index + 1);
+		const int32 i3 = b2GetSlot(rope, i - rope->index + 2);
+
+		b2Vec2 p1 = b2LoadVec2(m_pxs, m_pys, i1);
+		b2Vec2 p2 = b2LoadVec2(m_pxs, m_pys, i2);
+		b2Vec2 p3 = b2LoadVec2(m_pxs, m_pys, i3);
+
+		float invMass1 = m_invMasses[i1];
+		float invMass2 = m_invMasses[i2];
+		float invMass3 = m_invMasses[i3];
+
+		float alpha1 = m_bendAlpha1s[i];
+		float alpha2 = m_bendAlpha2s[i];
+
+		// Barycentric coordinates are held constant
+		b2Vec2 d = alpha1 * p1 + alpha2 * p3 - p2;
+		float dLen = d.Length();
+
+		if (dLen == 0.0f)
+		{
+			continue;
+		}
+
+		b2Vec2 dHat = (1.0f / dLen) * d;
+
+		b2Vec2 J1 = alpha1 * dHat;
+		b2Vec2 J2 = -dHat;
+		b2Vec2 J3 = alpha2 * dHat;
+
+		float sum = invMass1 * alpha1 * alpha1 + invMass2 + invMass3 * alpha2 * alpha2;
+
+		if (sum == 0.0f)
+		{
+			continue;
+		}
+
+		float C = dLen;
+		float mass = 1.0f / sum;
+		float impulse = -stiffness * mass * C;
+
+		p1 += (invMass1 * impulse) * J1;
+		p2 += (invMass2 * impulse) * J2;
+		p3 += (invMass3 * impulse) * J3;
+
+		b2StoreVec2(m_pxs, m_pys, i1, p1);
+		b2StoreVec2(m_pxs, m_pys, i2, p2);
+		b2StoreVec2(m_pxs, m_pys, i3, p3);
+	}
+}
+
+void b2RopeSystem::Draw(b2Draw* draw) const
+{
+	b2Color c(0.4f, 0.5f, 0.7f);
+	b2Color pg(0.1f, 0.8f, 0.1f);
+	b2Color pd(0.7f, 0.2f, 0.4f);
+
+	for (int32 r = 0; r < m_ropeCount; ++r)
+	{
+		const b2RopeRange* rope = m_ropes + r;
+		const int32 last = rope->count - 1;
+
+		for (int32 i = 0; i < last; ++i)
+		{
+			const int32 i1 = b2GetSlot(rope, i);
+			b2Vec2 p = b2LoadVec2(m_pxs, m_pys, i1);
+			draw->DrawSegment(p, b2LoadVec2(m_pxs, m_pys, b2GetSlot(rope, i + 1)), c);
+
+			const b2Color& pc = m_invMasses[i1] > 0.0f ? pd : pg;
+			draw->DrawPoint(p, 5.0f, pc);
+		}
+
+		const int32 i1 = b2GetSlot(rope, last);
+		const b2Color& pc = m_invMasses[i1] > 0.0f ? pd : pg;
+		draw->DrawPoint(b2LoadVec2(m_pxs, m_pys, i1), 5.0f, pc);
+	}
+}
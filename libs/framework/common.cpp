@@ -0,0 +1,330 @@
+#include "common.h"
+#include "framework.h"
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+using namespace frame;
+
+NVGcontext* vg;
+
+std::vector<world_transform> transforms;
+
+world_transform::world_transform(const mat3& transform)
+    : transform(transform)
+{
+}
+
+void world_transform::set(const mat3& new_transform)
+{
+    transform = new_transform;
+    has_inverted = false;
+    has_rectangle = false;
+}
+
+const mat3& world_transform::get_inverted()
+{
+    if (!has_inverted)
+    {
+        inverted = transform.inverted();
+        has_inverted = true;
+    }
+    return inverted;
+}
+
+const frame::rectangle& world_transform::get_rectangle()
+{
+    vec2 screen_size = get_screen_size();
+    if (!has_rectangle || screen_size.x != rectangle_screen_size.x || screen_size.y != rectangle_screen_size.y)
+    {
+        vec2 p1 = get_inverted().transform_point(vec2{ 0.0f, 0.0f });
+        vec2 p2 = get_inverted().transform_point(screen_size);
+
+        vec2 min_v(std::min(p1.x, p2.x), std::min(p1.y, p2.y));
+        vec2 max_v(std::max(p1.x, p2.x), std::max(p1.y, p2.y));
+
+        rectangle = frame::rectangle::from_min_max(min_v, max_v);
+        rectangle_screen_size = screen_size;
+        has_rectangle = true;
+    }
+    return rectangle;
+}
+
+void apply_transform(const mat3& m)
+{
+    nvgTransform(vg, m.data[0], m.data[3], m.data[1], m.data[4], m.data[2], m.data[5]);
+}
+
+static const size_t FrameTimeHistory = 240;
+static const double FrameTimeSmoothing = 0.1; // weight of the last frame in smoothed delta
+
+// delta times of last frames, for smoothing and statistics
+struct
+{
+    double delta = 0.0;
+    double smoothed = 0.0;
+
+    std::vector<double> deltas = std::vector<double>(FrameTimeHistory);
+    size_t next = 0;
+    size_t count = 0;
+} frame_time;
+
+namespace frame
+{
+    void update_frame_time(double delta)
+    {
+        frame_time.delta = delta;
+        frame_time.smoothed = frame_time.count == 0 ? delta : frame_time.smoothed + (delta - frame_time.smoothed) * FrameTimeSmoothing;
+
+        frame_time.deltas[frame_time.next] = delta;
+        frame_time.next = (frame_time.next + 1) % frame_time.deltas.size();
+        frame_time.count = std::min(frame_time.count + 1, frame_time.deltas.size());
+    }
+
+    double get_delta_time()
+    {
+        return frame_time.delta;
+    }
+
+    double get_smoothed_delta_time()
+    {
+        return frame_time.smoothed;
+    }
+
+    frame_time_stats get_frame_time_stats()
+    {
+        frame_time_stats stats{};
+        stats.frames = frame_time.count;
+        if (frame_time.count == 0)
+            return stats;
+
+        // order of deltas in ring buffer doesn't matter
+        std::vector<double> deltas(std::begin(frame_time.deltas), std::begin(frame_time.deltas) + frame_time.count);
+        std::sort(std::begin(deltas), std::end(deltas));
+
+        auto percentile = [&deltas](double p)
+        {
+            return deltas[std::min((size_t)(p * deltas.size()), deltas.size() - 1)];
+        };
+
+        double sum = 0.0;
+        for (double delta : deltas)
+            sum += delta;
+
+        stats.average = sum / deltas.size();
+        stats.minimum = deltas.front();
+        stats.maximum = deltas.back();
+        stats.percentile_50 = percentile(0.50);
+        stats.percentile_95 = percentile(0.95);
+        stats.percentile_99 = percentile(0.99);
+
+        return stats;
+    }
+
+    col4 rgb(char r, char g, char b)
+    {
+        return col4::RGB(r, g, b);
+    }
+
+    col4 rgba(char r, char g, char b, char a)
+    {
+        return col4::RGB(r, g, b, a);
+    }
+
+    float deg_to_rad(float deg)
+    {
+        return deg * 0.0174533f;
+    }
+
+    float rad_to_deg(float rad)
+    {
+        return rad * 57.2958f;
+    }
+
+    mat3 translation(const vec2& translation)
+    {
+        return mat3::translation(translation);
+    }
+
+    mat3 rotation(float rotation)
+    {
+        return mat3::rotation(rotation);
+    }
+
+    mat3 scale(const vec2& scale)
+    {
+        return mat3::scaling(scale);
+    }
+
+    mat3 identity()
+    {
+        return mat3::identity();
+    }
+
+    void set_world_transform(const mat3& transform)
+    {
+        if (transforms.size() == 1)
+            transforms.push_back(transform);
+        else
+            transforms.back().set(transform);
+
+        nvgResetTransform(vg);
+        apply_transform(transform);
+    }
+
+    void set_world_transform_multiply(const mat3& transform)
+    {
+        transforms.back().set(transform * transforms.back().get());
+        apply_transform(transform);
+    }
+
+    void save_world_transform()
+    {
+        // copy keeps the cached values, they are valid until transform is changed
+        transforms.push_back(transforms.back());
+    }
+
+    void restore_world_transform()
+    {
+        assert(transforms.size());
+        if (transforms.size() == 1) // we do not pop first identity matrix
+            return;
+
+        transforms.pop_back();
+
+        nvgResetTransform(vg);
+        apply_transform(transforms.back().get());
+    }
+
+    const mat3& get_world_transform()
+    {
+        return transforms.back().get();
+    }
+
+    const mat3& get_world_transform_inverted()
+    {
+        return transforms.back().get_inverted();
+    }
+
+    vec2 get_mouse_world_position()
+    {
+        return transforms.back().get_inverted().transform_point(get_mouse_screen_position());
+    }
+
+    vec2 get_world_position_screen_relative(const vec2& rel)
+    {
+        auto world_rect = get_world_rectangle();
+
+        return world_rect.min + world_rect.size() * rel;
+    }
+
+    vec2 get_world_size()
+    {
+        auto result = get_screen_size() / transforms.back().get().get_scale();
+        return { std::abs(result.x), std::abs(result.y) };
+    }
+
+    vec2 get_world_translation()
+    {
+        return transforms.back().get().get_translation();
+    }
+
+    void set_world_translation(const vec2& translation)
+    {
+        mat3 transform = transforms.back().get();
+        transform.set_translation(translation);
+        transforms.back().set(transform);
+
+        nvgResetTransform(vg);
+        apply_transform(transform);
+    }
+
+    vec2 get_world_scale()
+    {
+        return transforms.back().get().get_scale();
+    }
+
+    void set_world_scale(const vec2& scale)
+    {
+        mat3 transform = transforms.back().get();
+        transform.set_scale(scale);
+        set_world_transform(transform);
+    }
+
+    void set_world_scale(const vec2& scale, const vec2& stationary_world_point)
+    {
+        mat3 new_transform = mat3::scaling(scale);
+        // find new translation such that we will preserve stationary_world_point(after scale)
+        // what we need to achieve is that current stationary screen position s maps to same world position w (as with current transform)
+        // M * w = s
+        //
+        // |a b c|   |wx|   |sx|
+        // |d e f| * |wy| = |sy|
+        // |0 0 1|   | 1|   | 1|
+        //
+        // we need to find new c,f (translation) for this equation to hold
+        // sx = a*wx + b*wy + c
+        // sy = d*wx + e*wy + f
+        {
+            vec2 s = transforms.back().get().transform_point(stationary_world_point);
+            const vec2& w = stationary_world_point;
+            float c = s.x - new_transform.data[0] * w.x - new_transform.data[1] * w.y;
+            float f = s.y - new_transform.data[3] * w.x - new_transform.data[4] * w.y;
+
+            new_transform.set_translation({ c,f });
+        }
+        set_world_transform(new_transform);
+    }
+
+    rectangle get_world_rectangle()
+    {
+        return transforms.back().get_rectangle();
+    }
+
+    rectangle rectangle::from_min_max(const vec2& min, const vec2& max)
+    {
+        return { min, max };
+    }
+
+    rectangle rectangle::from_center_size(const vec2& center, const vec2& size)
+    {
+        return { center - size / 2.0f, center + size / 2.0f };
+    }
+
+    bool rectangle::contains(const vec2& o) const
+    {
+        return o.x >= min.x && o.x < max.x && o.y >= min.y && o.x < max.y;
+    }
+
+    rectangle rectangle::overlap(const rectangle& o) const
+    {
+        rectangle result;
+
+        result.min.x = std::max(min.x, o.min.x);
+        result.min.y = std::max(min.y, o.min.y);
+        result.max.x = std::min(max.x, o.max.x);
+        result.max.y = std::min(max.y, o.max.y);
+
+        if (result.min.x < result.max.x && result.min.y < result.max.y)
+            return result;
+        else
+            return { {0, 0}, {0, 0} }; // No overlap, return a rectangle with zero area
+    }
+
+    bool rectangle::has_overlap(const rectangle& o) const
+    {
+        auto over = overlap(o);
+
+        return !(over.min.x == 0 && over.min.y == 0 && over.max.x == 0 && over.max.y == 0);
+    }
+
+    vec2 rectangle::center() const
+    {
+        return min + (max - min) / 2.0f;
+    }
+
+    vec2 rectangle::size() const
+    {
+        return max - min;
+    }
+}
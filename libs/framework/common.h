@@ -0,0 +1,42 @@
+#pragma once
+
+#include "framework.h"
+#include <vector>
+
+// state shared between the sokol application runtime (framework.cpp) and the headless runtime (headless.cpp)
+
+// world transform with values derived from it, which are computed lazily when they are needed
+struct world_transform
+{
+    world_transform(const frame::mat3& transform);
+
+    const frame::mat3& get() const { return transform; }
+    void set(const frame::mat3& transform);
+
+    const frame::mat3& get_inverted();
+    const frame::rectangle& get_rectangle();
+
+private:
+    frame::mat3 transform;
+
+    bool has_inverted = false;
+    frame::mat3 inverted{};
+
+    bool has_rectangle = false;
+    frame::vec2 rectangle_screen_size{}; // rectangle is valid only for this screen size
+    frame::rectangle rectangle{};
+};
+
+extern std::vector<world_transform> transforms;
+
+void apply_transform(const frame::mat3& m);
+
+namespace frame
+{
+    // called by runtime at the start of frame with time since start of previous frame [ms]
+    void update_frame_time(double delta);
+
+    // frame of profiler, zones of runtime phases are recorded between these calls
+    void profiler_begin_frame();
+    void profiler_end_frame();
+}
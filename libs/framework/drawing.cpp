@@ -1,4 +1,6 @@
 #include "framework.h"
+#include "renderer.h"
+#include "slot_map.h"
 #include <cmath>
 #include <vector>
 
@@ -6,6 +8,9 @@ namespace frame
 {
     void draw_rectangle(const vec2& position, float width, float height, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         float hw = width / 2.0f, hh = height / 2.0f;
 
         nvgSave(vg);
@@ -32,6 +37,9 @@ namespace frame
                            const float outline_thickness,
                            const col4& outline_color)
     {
+        if (!renderer::enabled)
+            return;
+
         float hw = width / 2.0f, hh = height / 2.0f;
 
         nvgSave(vg);
@@ -58,6 +66,9 @@ namespace frame
 
     void draw_rounded_rectangle(const vec2& position, float width, float height, float radius, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         float hw = width / 2.0f, hh = height / 2.0f;
 
         nvgSave(vg);
@@ -82,6 +93,9 @@ namespace frame
                                    const float outline_thickness,
                                    const col4& outline_color)
     {
+        if (!renderer::enabled)
+            return;
+
         float hw = width / 2.0f, hh = height / 2.0f;
 
         nvgSave(vg);
@@ -104,6 +118,9 @@ namespace frame
 
     void draw_circle(const vec2& position, float radius, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         nvgSave(vg);
 
         nvgTranslate(vg, position.x, position.y);
@@ -129,6 +146,9 @@ namespace frame
                         const float outline_thickness,
                         const col4& outline_color)
     {
+        if (!renderer::enabled)
+            return;
+
         nvgSave(vg);
 
         nvgTranslate(vg, position.x, position.y);
@@ -154,6 +174,9 @@ namespace frame
 
     void draw_ellipse(const vec2& position, float major, float minor, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         nvgSave(vg);
 
         nvgTranslate(vg, position.x, position.y);
@@ -175,6 +198,9 @@ namespace frame
                          float outline_thickness,
                          const col4& outline_color)
     {
+        if (!renderer::enabled)
+            return;
+
         nvgSave(vg);
 
         nvgTranslate(vg, position.x, position.y);
@@ -200,6 +226,9 @@ namespace frame
                         float outline_thickness,
                         const col4& outline_color)
     {
+        if (!renderer::enabled)
+            return;
+
         static const float min_value = -10.0f;
         static const float max_value =  10.0f;
         static const float step_value = 0.1f;
@@ -245,6 +274,9 @@ namespace frame
 
     void draw_polygon(const vec2& position, const vec2* vertices, size_t count, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         nvgSave(vg);
 
         nvgTranslate(vg, position.x, position.y);
@@ -268,6 +300,9 @@ namespace frame
                          const float outline_thickness,
                          const col4& outline_color)
     {
+        if (!renderer::enabled)
+            return;
+
         nvgSave(vg);
 
         nvgTranslate(vg, position.x, position.y);
@@ -291,9 +326,12 @@ namespace frame
 
     void draw_line_directed(const vec2& from, const vec2& to, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         static const float arrowLength = 5.0f;
         static const float arrowAngle = nvgDegToRad(45.0f);
-        static const float offset = std::sinf(arrowAngle) * arrowLength;
+        static const float offset = std::sin(arrowAngle) * arrowLength;
 
         auto vec = to - from;
 
@@ -321,9 +359,12 @@ namespace frame
 
     void draw_line_directed_ex(const vec2& from, const vec2& to, float thickness, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         static const float arrowLength = 5.0f;
         static const float arrowAngle = nvgDegToRad(45.0f);
-        static const float offset = std::sinf(arrowAngle) * arrowLength;
+        static const float offset = std::sin(arrowAngle) * arrowLength;
 
         auto vec = to - from;
 
@@ -352,6 +393,9 @@ namespace frame
 
     void draw_line_solid(const vec2& from, const vec2& to, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         nvgSave(vg);
 
         nvgBeginPath(vg);
@@ -367,6 +411,9 @@ namespace frame
 
     void draw_line_solid_ex(const vec2& from, const vec2& to, float thickness, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         nvgSave(vg);
 
         nvgBeginPath(vg);
@@ -383,6 +430,9 @@ namespace frame
 
     void draw_line_dashed(const vec2& from, const vec2& to, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         static const float DashLength = 3.0f;
 
         float m = (to.y - from.y) / (to.x - from.x);
@@ -416,6 +466,9 @@ namespace frame
 
     void draw_line_dashed_ex(const vec2& from, const vec2& to, float thickness, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         static const float DashLength = 3.0f;
 
         float m = (to.y - from.y) / (to.x - from.x);
@@ -450,6 +503,9 @@ namespace frame
 
     void draw_quad_bezier(const vec2& from, const vec2& control, const vec2& to, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         nvgSave(vg);
 
         nvgBeginPath(vg);
@@ -465,6 +521,9 @@ namespace frame
 
     void draw_quad_bezier_ex(const vec2& from, const vec2& control, const vec2& to, float thickness, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         nvgSave(vg);
 
         nvgBeginPath(vg);
@@ -563,6 +622,9 @@ namespace frame
 
     void draw_bezier_polyline(const std::vector<vec2>& points, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         auto [c1, c2] = get_polyline_bezier_control_points(points);
 
         nvgSave(vg);
@@ -581,6 +643,9 @@ namespace frame
 
     void draw_bezier_polyline_ex(const std::vector<vec2>& points, float thickness, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         auto [c1, c2] = get_polyline_bezier_control_points(points);
 
         nvgSave(vg);
@@ -600,6 +665,9 @@ namespace frame
 
     void draw_polyline(const std::vector<vec2>& points, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         nvgSave(vg);
 
         nvgBeginPath(vg);
@@ -616,6 +684,9 @@ namespace frame
 
     void draw_polyline_ex(const std::vector<vec2>& points, float thickness, const col4& color)
     {
+        if (!renderer::enabled)
+            return;
+
         nvgSave(vg);
 
         nvgBeginPath(vg);
@@ -631,6 +702,225 @@ namespace frame
         nvgRestore(vg);
     }
 
+    // *** retained shapes ***
+
+    struct shape_data
+    {
+        shape_desc desc;
+        mat3 transform = mat3::identity();
+
+        renderer::mesh mesh = 0;
+        bool dirty = true; // points changed since last tessellation
+        float tessellation_scale = 0.0f; // world scale for which stroke was tessellated
+    };
+
+    slot_map<shape_data> shapes;
+
+    // bezier curves of smooth shape are approximated by line segments
+    static const int32_t SmoothShapeSegments = 8;
+    // limit of miter length for sharp angles, as multiple of half of thickness
+    static const float ShapeMiterLimit = 4.0f;
+
+    std::vector<vec2> get_shape_outline(const shape_desc& desc)
+    {
+        if (!desc.smooth || desc.points.size() < 2)
+            return desc.points;
+
+        std::vector<vec2> points = desc.points;
+        if (desc.closed)
+            points.push_back(points.front());
+
+        auto [c1, c2] = get_polyline_bezier_control_points(points);
+
+        std::vector<vec2> result;
+        result.reserve((points.size() - 1) * SmoothShapeSegments + 1);
+        for (size_t i = 0; i < points.size() - 1; i++)
+        {
+            for (int32_t j = 0; j < SmoothShapeSegments; j++)
+            {
+                float t = (float)j / SmoothShapeSegments, u = 1.0f - t;
+                result.push_back(points[i] * (u * u * u) + c1[i] * (3.0f * u * u * t) + c2[i] * (3.0f * u * t * t) + points[i + 1] * (t * t * t));
+            }
+        }
+        // closed outline ends with the first point
+        if (!desc.closed)
+            result.push_back(points.back());
+
+        return result;
+    }
+
+    void tessellate_shape_fill(const std::vector<vec2>& points, const col4& color, std::vector<renderer::vertex>& vertices)
+    {
+        uint32_t packed = renderer::pack_color(color);
+
+        for (size_t i = 1; i + 1 < points.size(); i++)
+        {
+            vertices.push_back({ { points[0].x, points[0].y }, packed });
+            vertices.push_back({ { points[i].x, points[i].y }, packed });
+            vertices.push_back({ { points[i + 1].x, points[i + 1].y }, packed });
+        }
+    }
+
+    void tessellate_shape_stroke(const std::vector<vec2>& outline, bool closed, float thickness, float fringe, const col4& color, std::vector<renderer::vertex>& vertices)
+    {
+        // coincident points have no direction
+        std::vector<vec2> points;
+        points.reserve(outline.size());
+        for (const auto& point : outline)
+        {
+            if (points.empty() || (point - points.back()).length_sqr() > 1e-12f)
+                points.push_back(point);
+        }
+        if (closed && points.size() > 1 && (points.back() - points.front()).length_sqr() <= 1e-12f)
+            points.pop_back();
+
+        const size_t n = points.size();
+        if (n < 2)
+            return;
+
+        // stroke thinner than fringe is drawn as wide as fringe and fainter
+        col4 stroke_color = color;
+        if (thickness < fringe)
+        {
+            stroke_color = col4::RGBf(color.red(), color.green(), color.blue(), color.alpha() * thickness / fringe);
+            thickness = fringe;
+        }
+
+        // edges of stroke fade out to transparent over fringe (1 pixel), it's antialiased like nanovg strokes
+        uint32_t packed = renderer::pack_color(stroke_color);
+        uint32_t transparent = packed & 0x00ffffff;
+        float inner = (thickness - fringe) / 2.0f;
+        float outer = (thickness + fringe) / 2.0f;
+
+        auto get_normal = [&points](size_t from, size_t to)
+        {
+            vec2 direction = (points[to] - points[from]).normalized();
+            return vec2(-direction.y, direction.x);
+        };
+
+        // offset of outline from each point for half thickness 1, segments are joined with miter
+        std::vector<vec2> offsets(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            bool has_previous = closed || i > 0;
+            bool has_next = closed || i + 1 < n;
+
+            if (!has_previous)
+            {
+                offsets[i] = get_normal(i, i + 1);
+                continue;
+            }
+            if (!has_next)
+            {
+                offsets[i] = get_normal(i - 1, i);
+                continue;
+            }
+
+            vec2 previous = get_normal((i + n - 1) % n, i);
+            vec2 next = get_normal(i, (i + 1) % n);
+            vec2 miter = previous + next;
+            // segment turns back
+            if (miter.length_sqr() < 1e-12f)
+            {
+                offsets[i] = next;
+                continue;
+            }
+            miter.normalize();
+
+            float cos_half_angle = miter.dot(next);
+            offsets[i] = miter * (1.0f / std::max(cos_half_angle, 1.0f / ShapeMiterLimit));
+        }
+
+        // strip of segments between two offsets (negative on the other side) with color at each of them
+        size_t segments = closed ? n : n - 1;
+        auto add_strip = [&](float offset1, uint32_t color1, float offset2, uint32_t color2)
+        {
+            for (size_t i = 0; i < segments; i++)
+            {
+                size_t j = (i + 1) % n;
+                vec2 a1 = points[i] + offsets[i] * offset1, a2 = points[i] + offsets[i] * offset2;
+                vec2 b1 = points[j] + offsets[j] * offset1, b2 = points[j] + offsets[j] * offset2;
+
+                vertices.push_back({ { a1.x, a1.y }, color1 });
+                vertices.push_back({ { a2.x, a2.y }, color2 });
+                vertices.push_back({ { b1.x, b1.y }, color1 });
+                vertices.push_back({ { a2.x, a2.y }, color2 });
+                vertices.push_back({ { b2.x, b2.y }, color2 });
+                vertices.push_back({ { b1.x, b1.y }, color1 });
+            }
+        };
+
+        // vertex count doesn't depend on thickness, so mesh buffer is updated in place on zoom
+        add_strip(-outer, transparent, -inner, packed);
+        add_strip(-inner, packed, inner, packed);
+        add_strip(inner, packed, outer, transparent);
+    }
+
+    void tessellate_shape(shape_data& data, float scale)
+    {
+        std::vector<vec2> outline = get_shape_outline(data.desc);
+        std::vector<renderer::vertex> vertices;
+
+        if (data.desc.fill_color.alpha() > 0.0f)
+            tessellate_shape_fill(outline, data.desc.fill_color, vertices);
+        if (data.desc.stroke_color.alpha() > 0.0f && data.desc.stroke_thickness > 0.0f)
+            tessellate_shape_stroke(outline, data.desc.closed, data.desc.stroke_thickness / scale, 1.0f / scale, data.desc.stroke_color, vertices);
+
+        renderer::update_mesh(data.mesh, vertices);
+
+        data.dirty = false;
+        data.tessellation_scale = scale;
+    }
+
+    shape create_shape(const shape_desc& desc)
+    {
+        shape_data data;
+        data.desc = desc;
+        data.mesh = renderer::create_mesh({});
+
+        return shapes.insert(std::move(data));
+    }
+
+    void update_shape_geometry(shape s, const std::vector<vec2>& points)
+    {
+        auto& data = shapes[s];
+
+        data.desc.points = points;
+        data.dirty = true;
+    }
+
+    void update_shape_transform(shape s, const mat3& transform)
+    {
+        shapes[s].transform = transform;
+    }
+
+    void draw_shape(shape s)
+    {
+        if (!renderer::enabled)
+            return;
+
+        auto& data = shapes[s];
+
+        mat3 transform = get_world_transform() * data.transform;
+
+        // length of transformed unit vector, stroke thickness is given in screen pixels
+        float scale = vec2(transform.data[0], transform.data[3]).length();
+        if (scale <= 0.0f)
+            return;
+
+        bool has_stroke = data.desc.stroke_color.alpha() > 0.0f && data.desc.stroke_thickness > 0.0f;
+        if (data.dirty || (has_stroke && scale != data.tessellation_scale))
+            tessellate_shape(data, scale);
+
+        renderer::draw_mesh(data.mesh, transform);
+    }
+
+    void destroy_shape(shape s)
+    {
+        renderer::destroy_mesh(shapes[s].mesh);
+        shapes.erase(s);
+    }
+
     int map_to_nvg_align(text_align align)
     {
         switch (align)
@@ -695,6 +985,9 @@ namespace frame
 
     void draw_text(const char* text, const vec2& position, float size, const col4& color, text_align align)
     {
+        if (!renderer::enabled)
+            return;
+
         nvgSave(vg);
 
         set_text_transform(position);
@@ -5,6 +5,7 @@
 #include "matrix_type.h"
 #include "color_type.h"
 #include <functional>
+#include <vector>
 
 void setup();
 void update();
@@ -44,8 +45,24 @@ namespace frame
     col4 rgb(char r, char g, char b);
     col4 rgba(char r, char g, char b, char a);
 
-    float get_delta_time(); // time since last frame [ms]
-    float get_time(); // time since start [ms]
+    double get_delta_time(); // time since last frame [ms]
+    double get_time(); // time since start [ms]
+
+    // delta time averaged over last frames [ms], without jitter of single frames, suitable for animations
+    double get_smoothed_delta_time();
+
+    // statistics of delta times of last frames [ms]
+    struct frame_time_stats
+    {
+        size_t frames; // number of frames in statistics
+        double average;
+        double minimum;
+        double maximum;
+        double percentile_50;
+        double percentile_95;
+        double percentile_99;
+    };
+    frame_time_stats get_frame_time_stats();
 
     float deg_to_rad(float deg);
     float rad_to_deg(float rad);
@@ -70,6 +87,7 @@ namespace frame
     void restore_world_transform();
 
     const mat3& get_world_transform();
+    const mat3& get_world_transform_inverted(); // cached until world transform changes
 
     vec2 get_world_translation();
     void set_world_translation(const vec2& translation);
@@ -161,6 +179,27 @@ namespace frame
     void draw_polyline(const std::vector<vec2>& points, const col4& color);
     void draw_polyline_ex(const std::vector<vec2>& points, float thickness, const col4& color);
 
+    // *** retained shapes ***
+    // Geometry of shape is tessellated once and kept in GPU buffer, drawing of shape only applies its transform.
+    // Shape is tessellated again only when its points change or when stroke thickness in world units changes (zoom).
+    using shape = int32_t; // handle, 0 is null handle
+
+    struct shape_desc
+    {
+        std::vector<vec2> points;
+        bool closed = false;            // last point is connected with first
+        bool smooth = false;            // points are connected by bezier curves, like in draw_bezier_polyline
+        col4 fill_color = col4::BLANK;  // fill of polygon given by points, polygon must be convex
+        float stroke_thickness = 1.0f;  // in screen pixels, independent of world scale
+        col4 stroke_color = col4::BLANK;
+    };
+
+    shape create_shape(const shape_desc& desc);
+    void update_shape_geometry(shape s, const std::vector<vec2>& points);
+    void update_shape_transform(shape s, const mat3& transform); // from shape to world coordinates
+    void draw_shape(shape s);
+    void destroy_shape(shape s);
+
     // *** text ***
     enum class text_align { top_left,    top_middle,    top_right, 
                             middle_left, middle_middle, middle_right,
@@ -0,0 +1,216 @@
+// Headless runtime, replaces sokol application runtime (framework.cpp) when FRAMEWORK_HEADLESS is defined.
+// Drives setup()/update() in a tight loop without window, GL context or sokol_app. Drawing functions of
+// framework return at once (see renderer::enabled). nanovg still runs with null render backend for projects
+// calling it directly and for text measurement. ImGui frames are processed but never rendered.
+
+#include "framework.h"
+#include "common.h"
+#include "events.h"
+#include "renderer.h"
+#include "profiler.h"
+#include "imgui.h"
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+using namespace frame;
+
+struct
+{
+    int64_t frames = 3600;          // number of frames to simulate, 0 means run forever
+    double frame_delta = 1000.0 / 60.0; // fixed time of one frame [ms]
+    vec2 screen_size = { 800.0f, 600.0f };
+
+    const char* profile_path = nullptr; // Chrome trace of profiler is written here at the end
+
+    int64_t frame = 0;
+    double time = 0.0;
+    col4 background_color;
+} headless;
+
+namespace frame
+{
+    void set_screen_background(const col4& color)
+    {
+        headless.background_color = color;
+    }
+
+    const col4& get_screen_background()
+    {
+        return headless.background_color;
+    }
+
+    vec2 get_screen_size()
+    {
+        return headless.screen_size;
+    }
+
+    double get_time()
+    {
+        return headless.time;
+    }
+}
+
+// *** batched renderer, nothing is rendered ***
+
+namespace renderer
+{
+    void setup() {}
+
+    void begin_batch() {}
+    void end_batch() {}
+
+    void push_rectangle(const vec2&, float, float, float, const col4&) {}
+    void push_circle(const vec2&, float, float, const col4&) {}
+
+    mesh create_mesh(const std::vector<vertex>&) { return 0; }
+    void update_mesh(mesh, const std::vector<vertex>&) {}
+    void destroy_mesh(mesh) {}
+    void draw_mesh(mesh, const mat3&) {}
+}
+
+// *** null nanovg backend ***
+
+namespace null_renderer
+{
+    int create(void*) { return 1; }
+    int create_texture(void*, int, int, int, int, const unsigned char*) { return 1; }
+    int delete_texture(void*, int) { return 1; }
+    int update_texture(void*, int, int, int, int, int, const unsigned char*) { return 1; }
+    int get_texture_size(void*, int, int* w, int* h) { *w = *h = 0; return 1; }
+    void viewport(void*, float, float, float) {}
+    void cancel(void*) {}
+    void flush(void*) {}
+    void fill(void*, NVGpaint*, NVGcompositeOperationState, NVGscissor*, float, const float*, const NVGpath*, int) {}
+    void stroke(void*, NVGpaint*, NVGcompositeOperationState, NVGscissor*, float, float, const NVGpath*, int) {}
+    void triangles(void*, NVGpaint*, NVGcompositeOperationState, NVGscissor*, const NVGvertex*, int, float) {}
+    void destroy(void*) {}
+
+    NVGcontext* create_context()
+    {
+        NVGparams params{};
+        params.renderCreate = create;
+        params.renderCreateTexture = create_texture;
+        params.renderDeleteTexture = delete_texture;
+        params.renderUpdateTexture = update_texture;
+        params.renderGetTextureSize = get_texture_size;
+        params.renderViewport = viewport;
+        params.renderCancel = cancel;
+        params.renderFlush = flush;
+        params.renderFill = fill;
+        params.renderStroke = stroke;
+        params.renderTriangles = triangles;
+        params.renderDelete = destroy;
+
+        return nvgCreateInternal(&params);
+    }
+}
+
+// usage: <app> [--frames N] [--delta ms] [--width W] [--height H] [--profile trace.json]
+void parse_arguments(int argc, char* argv[])
+{
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--frames") == 0)
+            headless.frames = std::atoll(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--delta") == 0)
+            headless.frame_delta = std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--width") == 0)
+            headless.screen_size.x = (float)std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--height") == 0)
+            headless.screen_size.y = (float)std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--profile") == 0)
+            headless.profile_path = argv[i + 1];
+    }
+}
+
+void init()
+{
+    transforms.push_back(mat3::identity());
+
+    vg = null_renderer::create_context();
+
+    ImGui::CreateContext();
+    auto& io = ImGui::GetIO();
+    io.DisplaySize = { headless.screen_size.x, headless.screen_size.y };
+    io.IniFilename = nullptr;
+
+    // font atlas must be built before first frame, texture data are not used
+    unsigned char* pixels = nullptr;
+    int width = 0, height = 0;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+    if (headless.profile_path)
+    {
+        // all frames are written, not only the last ones
+        set_profiler_history(headless.frames > 0 ? (size_t)headless.frames : 3600);
+        set_profiler_enabled(true);
+    }
+
+    setup();
+}
+
+void frame_update()
+{
+    profiler_begin_frame();
+
+    update_frame_time(headless.frame_delta);
+
+    ImGui::GetIO().DeltaTime = (float)(headless.frame_delta / 1000.0);
+    ImGui::NewFrame();
+
+    nvgBeginFrame(vg, headless.screen_size.x, headless.screen_size.y, 1.0f);
+
+    nvgResetTransform(vg);
+    apply_transform(transforms.back().get());
+
+    {
+        PROFILE_ZONE("update");
+        update();
+    }
+
+    {
+        PROFILE_ZONE("nanovg flush");
+        nvgEndFrame(vg);
+    }
+
+    ImGui::EndFrame();
+
+    events_end_frame();
+
+    profiler_end_frame();
+
+    headless.time += headless.frame_delta;
+    headless.frame++;
+}
+
+void cleanup()
+{
+    if (headless.profile_path && !dump_profiler_trace(headless.profile_path))
+        std::fprintf(stderr, "can't write profile to %s\n", headless.profile_path);
+
+    ImGui::DestroyContext();
+    nvgDeleteInternal(vg);
+}
+
+int main(int argc, char* argv[])
+{
+    parse_arguments(argc, argv);
+
+    init();
+
+    while (headless.frames == 0 || headless.frame < headless.frames)
+        frame_update();
+
+    cleanup();
+
+    return 0;
+}
+
+#ifdef _WIN32
+// windowed apps are linked with windows subsystem
+int __stdcall WinMain(void*, void*, char*, int)
+{
+    return main(__argc, __argv);
+}
+#endif
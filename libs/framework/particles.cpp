@@ -0,0 +1,331 @@
+#include "particles.h"
+#include "framework.h"
+#include "renderer.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cassert>
+
+ParticleSystem::ParticleSystem(World& world)
+    : m_world(world)
+{
+}
+
+void ParticleSystem::SetRadius(float radius)
+{
+    assert(radius > 0.0f);
+
+    m_radius = radius / WorldScale;
+}
+
+void ParticleSystem::SetIterations(int32_t iterations)
+{
+    assert(iterations > 0);
+
+    m_iterations = iterations;
+}
+
+void ParticleSystem::SetFriction(float friction)
+{
+    m_friction = std::clamp(friction, 0.0f, 1.0f);
+}
+
+void ParticleSystem::SetDamping(float damping)
+{
+    m_damping = damping;
+}
+
+void ParticleSystem::SetCollisionMask(uint16_t mask)
+{
+    m_collisionMask = mask;
+}
+
+ParticleSystem::Particle ParticleSystem::CreateParticle(const point_type<float>& position, float mass)
+{
+    assert(mass >= 0.0f);
+
+    b2Vec2 point = WorldScalePoint(position);
+    m_positions.push_back(point);
+    m_previousPositions.push_back(point);
+    m_inverseMasses.push_back(mass > 0.0f ? 1.0f / mass : 0.0f);
+
+    return (Particle)m_positions.size() - 1;
+}
+
+void ParticleSystem::CreateLink(Particle a, Particle b)
+{
+    assert(a != b && (size_t)a < m_positions.size() && (size_t)b < m_positions.size());
+
+    m_links.push_back({ a, b, b2Distance(m_positions[a], m_positions[b]) });
+}
+
+ParticleSystem::Particle ParticleSystem::CreateRope(const point_type<float>& start, const point_type<float>& end, int32_t count, float mass)
+{
+    assert(count > 1);
+
+    Particle first = CreateParticle(start, mass);
+    for (int32_t i = 1; i < count; i++)
+    {
+        float t = (float)i / (count - 1);
+        Particle particle = CreateParticle(start + (end - start) * t, mass);
+        CreateLink(particle - 1, particle);
+    }
+
+    return first;
+}
+
+void ParticleSystem::SetPosition(Particle particle, const point_type<float>& position)
+{
+    m_positions[particle] = WorldScalePoint(position);
+}
+
+void ParticleSystem::SetMass(Particle particle, float mass)
+{
+    assert(mass >= 0.0f);
+
+    m_inverseMasses[particle] = mass > 0.0f ? 1.0f / mass : 0.0f;
+}
+
+point_type<float> ParticleSystem::GetPosition(Particle particle) const
+{
+    return WorldScalePoint(m_positions[particle]);
+}
+
+size_t ParticleSystem::GetParticleCount() const
+{
+    return m_positions.size();
+}
+
+void ParticleSystem::Clear()
+{
+    m_positions.clear();
+    m_previousPositions.clear();
+    m_inverseMasses.clear();
+    m_links.clear();
+    m_contacts.clear();
+}
+
+void ParticleSystem::Step(float dt)
+{
+    PROFILE_ZONE("ParticleSystem::Step");
+
+    if (m_positions.empty() || dt <= 0.0f)
+        return;
+
+    Integrate(dt);
+    FindContacts();
+
+    for (int32_t i = 0; i < m_iterations; i++)
+    {
+        SolveLinks();
+        SolveContacts();
+    }
+
+    ApplyFriction(dt);
+    ApplyImpulses(dt);
+}
+
+void ParticleSystem::Integrate(float dt)
+{
+    const b2Vec2 gravity = (dt * dt) * m_world.m_world.GetGravity();
+    // the same damping as of box2d bodies
+    const float damping = 1.0f / (1.0f + dt * m_damping);
+
+    for (size_t i = 0; i < m_positions.size(); i++)
+    {
+        b2Vec2 position = m_positions[i];
+        if (m_inverseMasses[i] > 0.0f)
+            m_positions[i] += damping * (position - m_previousPositions[i]) + gravity;
+        m_previousPositions[i] = position;
+    }
+}
+
+void ParticleSystem::FindContacts()
+{
+    const size_t count = m_positions.size();
+
+    // box covers move of the step and what links may add to it in iterations
+    const b2Vec2 extension(2.0f * m_radius, 2.0f * m_radius);
+    m_queryBoxes.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        m_queryBoxes[i].lowerBound = b2Min(m_positions[i], m_previousPositions[i]) - extension;
+        m_queryBoxes[i].upperBound = b2Max(m_positions[i], m_previousPositions[i]) + extension;
+    }
+
+    // the same as in World::QueryObjects, query again if fixtures don't fit
+    m_queryHits.resize(std::max(m_queryHits.size(), count));
+    int32_t fixtureCount = m_world.m_world.QueryAABBBatch(m_queryBoxes.data(), (int32_t)count, m_queryHits.data(), (int32_t)m_queryHits.size());
+    if ((size_t)fixtureCount > m_queryHits.size())
+    {
+        m_queryHits.resize(fixtureCount);
+        m_world.m_world.QueryAABBBatch(m_queryBoxes.data(), (int32_t)count, m_queryHits.data(), fixtureCount);
+    }
+
+    m_contacts.clear();
+    for (int32_t i = 0; i < fixtureCount; i++)
+    {
+        const auto& hit = m_queryHits[i];
+        if (m_inverseMasses[hit.index] == 0.0f)
+            continue;
+
+        if (hit.fixture->IsSensor() || (hit.fixture->GetFilterData().categoryBits & m_collisionMask) == 0)
+            continue;
+
+        m_contacts.push_back({ hit.index, hit.fixture, hit.childIndex, b2Vec2_zero, b2Vec2_zero, false });
+    }
+
+    // fast particle could pass through thin fixture before it's projected out, it's stopped one radius in front
+    // of the surface (center on the surface of edge is pushed out to either side), move of particle is shortened
+    // by every hit so it ends at the first one
+    for (const auto& contact : m_contacts)
+    {
+        b2RayCastInput input;
+        input.p1 = m_previousPositions[contact.particle];
+        input.p2 = m_positions[contact.particle];
+        input.maxFraction = 1.0f;
+
+        b2RayCastOutput output;
+        if (contact.fixture->RayCast(&output, input, contact.childIndex))
+            m_positions[contact.particle] = input.p1 + output.fraction * (input.p2 - input.p1) + m_radius * output.normal;
+    }
+}
+
+void ParticleSystem::SolveLinks()
+{
+    for (const auto& link : m_links)
+    {
+        const float inverseMassA = m_inverseMasses[link.a];
+        const float inverseMassB = m_inverseMasses[link.b];
+        const float inverseMass = inverseMassA + inverseMassB;
+        if (inverseMass == 0.0f)
+            continue;
+
+        b2Vec2& positionA = m_positions[link.a];
+        b2Vec2& positionB = m_positions[link.b];
+
+        b2Vec2 d = positionB - positionA;
+        float length = d.Length();
+        if (length < b2_epsilon)
+            continue;
+
+        // heavier particle moves less
+        b2Vec2 correction = ((length - link.length) / (length * inverseMass)) * d;
+        positionA += inverseMassA * correction;
+        positionB -= inverseMassB * correction;
+    }
+}
+
+void ParticleSystem::SolveContacts()
+{
+    for (auto& contact : m_contacts)
+    {
+        b2Vec2& position = m_positions[contact.particle];
+
+        float separation;
+        contact.touching = Collide(position, contact, contact.normal, separation);
+        if (!contact.touching)
+            continue;
+
+        b2Vec2 correction = -separation * contact.normal;
+        position += correction;
+        contact.correction += correction;
+    }
+}
+
+void ParticleSystem::ApplyFriction(float dt)
+{
+    if (m_friction == 0.0f)
+        return;
+
+    for (const auto& contact : m_contacts)
+    {
+        if (!contact.touching)
+            continue;
+
+        b2Vec2& position = m_positions[contact.particle];
+        const b2Body* body = contact.fixture->GetBody();
+
+        // tangential move relative to surface of body
+        b2Vec2 move = position - m_previousPositions[contact.particle] - dt * body->GetLinearVelocityFromWorldPoint(position);
+        b2Vec2 tangentMove = move - b2Dot(move, contact.normal) * contact.normal;
+        position -= m_friction * tangentMove;
+    }
+}
+
+void ParticleSystem::ApplyImpulses(float dt)
+{
+    for (const auto& contact : m_contacts)
+    {
+        b2Body* body = contact.fixture->GetBody();
+        if (body->GetType() != b2_dynamicBody || contact.correction.LengthSquared() == 0.0f)
+            continue;
+
+        // particle pushed out of body pushes body back, body reacts in the next step of world
+        const float mass = 1.0f / m_inverseMasses[contact.particle];
+        body->ApplyLinearImpulse(-(mass / dt) * contact.correction, m_positions[contact.particle], true);
+    }
+}
+
+bool ParticleSystem::Collide(const b2Vec2& position, const Contact& contact, b2Vec2& normal, float& separation) const
+{
+    b2CircleShape circle;
+    circle.m_radius = m_radius;
+    const b2Transform particleTransform(position, b2Rot(0.0f));
+
+    const b2Shape* shape = contact.fixture->GetShape();
+    const b2Transform& transform = contact.fixture->GetBody()->GetTransform();
+
+    b2Manifold manifold;
+    switch (shape->GetType())
+    {
+    case b2Shape::e_circle:
+        b2CollideCircles(&manifold, (const b2CircleShape*)shape, transform, &circle, particleTransform);
+        break;
+    case b2Shape::e_polygon:
+        b2CollidePolygonAndCircle(&manifold, (const b2PolygonShape*)shape, transform, &circle, particleTransform);
+        break;
+    case b2Shape::e_edge:
+        b2CollideEdgeAndCircle(&manifold, (const b2EdgeShape*)shape, transform, &circle, particleTransform);
+        break;
+    case b2Shape::e_chain:
+    {
+        b2EdgeShape edge;
+        ((const b2ChainShape*)shape)->GetChildEdge(&edge, contact.childIndex);
+        b2CollideEdgeAndCircle(&manifold, &edge, transform, &circle, particleTransform);
+        break;
+    }
+    default:
+        return false;
+    }
+
+    if (manifold.pointCount == 0)
+        return false;
+
+    b2WorldManifold worldManifold;
+    worldManifold.Initialize(&manifold, transform, shape->m_radius, particleTransform, m_radius);
+
+    normal = worldManifold.normal;
+    separation = worldManifold.separations[0];
+
+    return separation < 0.0f;
+}
+
+void ParticleSystem::Draw(const color_type& color, bool drawLinks)
+{
+    PROFILE_ZONE("ParticleSystem::Draw");
+
+    if (!renderer::enabled)
+        return;
+
+    if (drawLinks)
+    {
+        for (const auto& link : m_links)
+            frame::draw_line_solid(WorldScalePoint(m_positions[link.a]), WorldScalePoint(m_positions[link.b]), color);
+    }
+
+    // there may be thousands of particles, draw them by single draw call
+    renderer::begin_batch();
+    for (const auto& position : m_positions)
+        renderer::push_circle(WorldScalePoint(position), 0.0f, m_radius * WorldScale, color);
+    renderer::end_batch();
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "world.h"
+#include "point_type.h"
+#include "color_type.h"
+#include <box2d/box2d.h>
+#include <vector>
+
+// Verlet particles connected by distance links and solved by projection (position based dynamics), e.g. ropes or cloth.
+// Particles are not bodies of box2d world, so there may be thousands of them. They collide with fixtures of world as circles:
+// broad-phase is queried once per step for all particles together and penetrations are projected out in every iteration.
+// Dynamic bodies are pushed by impulses of those projections. Particles don't collide with each other.
+// Positions and radius are in screen units, the same as of World.
+class ParticleSystem
+{
+public:
+    // index, particles are removed only all together by Clear
+    using Particle = int32_t;
+
+    ParticleSystem(World& world);
+
+    // radius of all particles
+    void SetRadius(float radius);
+    // link and collision iterations per step
+    void SetIterations(int32_t iterations);
+    // fraction of tangential motion removed on contact, 0 slides, 1 sticks
+    void SetFriction(float friction);
+    // velocity damping per second
+    void SetDamping(float damping);
+    // category bits of fixtures particles collide with
+    void SetCollisionMask(uint16_t mask);
+
+    // mass is in box2d units (10x10 rectangle of World has 0.04), particle with mass 0 is pinned, it moves only by SetPosition
+    Particle CreateParticle(const point_type<float>& position, float mass = 0.01f);
+    // rest length of link is current distance of particles
+    void CreateLink(Particle a, Particle b);
+    // count particles linked in chain from start to end, particles of rope follow the returned first one
+    Particle CreateRope(const point_type<float>& start, const point_type<float>& end, int32_t count, float mass = 0.01f);
+
+    // velocity is difference to position before last step, moved particle keeps what it gains by move
+    void SetPosition(Particle particle, const point_type<float>& position);
+    void SetMass(Particle particle, float mass);
+    point_type<float> GetPosition(Particle particle) const;
+    size_t GetParticleCount() const;
+
+    void Clear();
+
+    // call after World::Update with time step of world, once for each step of it (World::GetStepCount)
+    void Step(float dt);
+    void Draw(const color_type& color, bool drawLinks = true);
+
+private:
+    struct Link
+    {
+        Particle a;
+        Particle b;
+        float length;
+    };
+
+    // particle touching child of fixture, found by broad-phase at start of step
+    struct Contact
+    {
+        Particle particle;
+        b2Fixture* fixture;
+        int32_t childIndex;
+        b2Vec2 correction; // sum of projections of step, pushes body of fixture
+        b2Vec2 normal;     // from fixture to particle, valid if touching
+        bool touching;     // in last iteration
+    };
+
+    void Integrate(float dt);
+    void FindContacts();
+    void SolveLinks();
+    void SolveContacts();
+    void ApplyFriction(float dt);
+    void ApplyImpulses(float dt);
+    // false if particle doesn't touch fixture, otherwise normal points from fixture to particle and separation is negative
+    bool Collide(const b2Vec2& position, const Contact& contact, b2Vec2& normal, float& separation) const;
+
+    World& m_world;
+
+    float m_radius = 4.0f / WorldScale;
+    int32_t m_iterations = 20;
+    float m_friction = 0.3f;
+    float m_damping = 0.1f;
+    uint16_t m_collisionMask = 0xffff;
+
+    // in box2d units
+    std::vector<b2Vec2> m_positions;
+    std::vector<b2Vec2> m_previousPositions;
+    std::vector<float> m_inverseMasses;
+
+    std::vector<Link> m_links;
+    std::vector<Contact> m_contacts;
+
+    // scratch buffers of broad-phase query, keep their capacity
+    std::vector<b2AABB> m_queryBoxes;
+    std::vector<b2QueryHit> m_queryHits;
+};
@@ -0,0 +1,285 @@
+#include "profiler.h"
+#include "framework.h"
+#include "common.h"
+#include "imgui.h"
+#include <chrono>
+#include <cstdio>
+#include <cassert>
+#include <cfloat>
+#include <algorithm>
+
+namespace frame
+{
+    struct
+    {
+        bool enabled = false;
+        bool enabled_requested = false;
+        bool paused = false; // frames are not recorded, set from overlay
+
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        uint64_t frame_index = 0;
+
+        bool recording = false; // current frame is recorded
+        std::vector<profile_frame> frames = std::vector<profile_frame>(240);
+        size_t next = 0;  // frame which is recorded
+        size_t count = 0; // completed frames
+
+        std::vector<size_t> open_zones; // indices of zones of recorded frame
+
+        int32_t selected_age = 0; // frame shown in timeline of overlay
+    } profiler;
+
+    double get_profiler_time()
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - profiler.epoch).count();
+    }
+
+    void set_profiler_enabled(bool enabled)
+    {
+        profiler.enabled_requested = enabled;
+    }
+
+    bool is_profiler_enabled()
+    {
+        return profiler.enabled;
+    }
+
+    void set_profiler_history(size_t frames)
+    {
+        assert(frames > 0);
+
+        profiler.frames.clear();
+        profiler.frames.resize(frames);
+        profiler.next = 0;
+        profiler.count = 0;
+        profiler.recording = false;
+        profiler.open_zones.clear();
+    }
+
+    void profiler_begin_zone(const char* name)
+    {
+        if (!profiler.recording)
+            return;
+
+        auto& frame = profiler.frames[profiler.next];
+
+        profiler.open_zones.push_back(frame.zones.size());
+        frame.zones.push_back({ name, (int32_t)profiler.open_zones.size() - 1, get_profiler_time() - frame.start, 0.0 });
+    }
+
+    void profiler_end_zone()
+    {
+        if (!profiler.recording || profiler.open_zones.empty())
+            return;
+
+        auto& frame = profiler.frames[profiler.next];
+        auto& zone = frame.zones[profiler.open_zones.back()];
+        profiler.open_zones.pop_back();
+
+        zone.duration = get_profiler_time() - frame.start - zone.start;
+    }
+
+    void profiler_record_value(const char* name, double value)
+    {
+        if (!profiler.recording)
+            return;
+
+        profiler.frames[profiler.next].values.push_back({ name, value });
+    }
+
+    void profiler_begin_frame()
+    {
+        profiler.enabled = profiler.enabled_requested;
+        profiler.recording = profiler.enabled && !profiler.paused;
+        profiler.open_zones.clear();
+
+        if (!profiler.recording)
+            return;
+
+        // vectors of reused frame keep their capacity
+        auto& frame = profiler.frames[profiler.next];
+        frame.index = profiler.frame_index;
+        frame.start = get_profiler_time();
+        frame.duration = 0.0;
+        frame.zones.clear();
+        frame.values.clear();
+    }
+
+    void profiler_end_frame()
+    {
+        profiler.frame_index++;
+
+        if (!profiler.recording)
+            return;
+
+        // zones which were not ended end with the frame
+        while (!profiler.open_zones.empty())
+            profiler_end_zone();
+
+        auto& frame = profiler.frames[profiler.next];
+        frame.duration = get_profiler_time() - frame.start;
+
+        profiler.next = (profiler.next + 1) % profiler.frames.size();
+        profiler.count = std::min(profiler.count + 1, profiler.frames.size());
+        profiler.recording = false;
+    }
+
+    size_t get_profiler_frame_count()
+    {
+        return profiler.count;
+    }
+
+    const profile_frame& get_profiler_frame(size_t age)
+    {
+        assert(age < profiler.count);
+
+        size_t size = profiler.frames.size();
+        return profiler.frames[(profiler.next + size - 1 - age) % size];
+    }
+
+    ImU32 get_zone_color(const char* name)
+    {
+        // FNV-1a, same zone has the same color in every frame
+        uint32_t hash = 2166136261u;
+        for (const char* c = name; *c; c++)
+            hash = (hash ^ (uint8_t)*c) * 16777619u;
+
+        return IM_COL32(80 + hash % 150, 80 + (hash >> 8) % 150, 80 + (hash >> 16) % 150, 255);
+    }
+
+    void draw_profiler_timeline(const profile_frame& frame)
+    {
+        static const float RowHeight = 18.0f;
+
+        int32_t max_depth = 0;
+        for (const auto& zone : frame.zones)
+            max_depth = std::max(max_depth, zone.depth);
+
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        float width = std::max(ImGui::GetContentRegionAvail().x, 100.0f);
+        float height = (max_depth + 1) * RowHeight;
+        float scale = frame.duration > 0.0 ? width / (float)frame.duration : 0.0f;
+
+        ImGui::InvisibleButton("timeline", { width, height });
+        bool hovered = ImGui::IsItemHovered();
+        ImVec2 mouse = ImGui::GetIO().MousePos;
+
+        auto* draw_list = ImGui::GetWindowDrawList();
+        for (const auto& zone : frame.zones)
+        {
+            ImVec2 min = { origin.x + (float)zone.start * scale, origin.y + zone.depth * RowHeight };
+            ImVec2 max = { min.x + std::max((float)zone.duration * scale, 1.0f), min.y + RowHeight - 1.0f };
+
+            draw_list->AddRectFilled(min, max, get_zone_color(zone.name));
+
+            if (ImGui::CalcTextSize(zone.name).x + 4.0f < max.x - min.x)
+                draw_list->AddText({ min.x + 2.0f, min.y + 2.0f }, IM_COL32(0, 0, 0, 255), zone.name);
+
+            if (hovered && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+                ImGui::SetTooltip("%s\n%.3f ms", zone.name, zone.duration);
+        }
+    }
+
+    void draw_profiler_overlay()
+    {
+        ImGui::SetNextWindowSize({ 500.0f, 400.0f }, ImGuiCond_FirstUseEver);
+        if (!ImGui::Begin("Profiler"))
+        {
+            ImGui::End();
+            return;
+        }
+
+        bool enabled = profiler.enabled_requested;
+        if (ImGui::Checkbox("Enabled", &enabled))
+            set_profiler_enabled(enabled);
+        ImGui::SameLine();
+        ImGui::Checkbox("Pause", &profiler.paused);
+
+        auto stats = get_frame_time_stats();
+        ImGui::Text("delta [ms] avg %.2f, p50 %.2f, p95 %.2f, p99 %.2f, max %.2f",
+            stats.average, stats.percentile_50, stats.percentile_95, stats.percentile_99, stats.maximum);
+
+        if (profiler.count == 0)
+        {
+            ImGui::End();
+            return;
+        }
+
+        // frame times, oldest first
+        auto get_duration = [](void*, int i) { return (float)get_profiler_frame(profiler.count - 1 - i).duration; };
+        ImGui::PlotHistogram("##frames", get_duration, nullptr, (int)profiler.count, 0, "frame [ms]", 0.0f, FLT_MAX, { 0.0f, 60.0f });
+
+        profiler.selected_age = std::clamp(profiler.selected_age, 0, (int32_t)profiler.count - 1);
+        ImGui::SliderInt("age", &profiler.selected_age, 0, (int32_t)profiler.count - 1);
+
+        const auto& frame = get_profiler_frame(profiler.selected_age);
+        ImGui::Text("frame %llu: %.3f ms", (unsigned long long)frame.index, frame.duration);
+
+        draw_profiler_timeline(frame);
+
+        if (!frame.values.empty() && ImGui::CollapsingHeader("Values"))
+        {
+            for (const auto& value : frame.values)
+                ImGui::Text("%s: %.3f", value.name, value.value);
+        }
+
+        ImGui::End();
+    }
+
+    void write_trace_string(FILE* file, const char* text)
+    {
+        std::fputc('"', file);
+        for (const char* c = text; *c; c++)
+        {
+            if (*c == '"' || *c == '\\')
+                std::fputc('\\', file);
+            std::fputc(*c, file);
+        }
+        std::fputc('"', file);
+    }
+
+    bool dump_profiler_trace(const char* path)
+    {
+        FILE* file = std::fopen(path, "w");
+        if (!file)
+            return false;
+
+        std::fprintf(file, "{\"traceEvents\":[\n");
+
+        bool first = true;
+        auto begin_event = [&first, file](const char* name)
+        {
+            std::fprintf(file, first ? "{\"name\":" : ",\n{\"name\":");
+            write_trace_string(file, name);
+            first = false;
+        };
+
+        // timestamps are in microseconds
+        for (size_t age = profiler.count; age-- > 0;)
+        {
+            const auto& frame = get_profiler_frame(age);
+
+            begin_event("frame");
+            std::fprintf(file, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":0,\"args\":{\"index\":%llu}}",
+                frame.start * 1000.0, frame.duration * 1000.0, (unsigned long long)frame.index);
+
+            for (const auto& zone : frame.zones)
+            {
+                begin_event(zone.name);
+                std::fprintf(file, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":0}",
+                    (frame.start + zone.start) * 1000.0, zone.duration * 1000.0);
+            }
+
+            for (const auto& value : frame.values)
+            {
+                begin_event(value.name);
+                std::fprintf(file, ",\"ph\":\"C\",\"ts\":%.3f,\"pid\":0,\"tid\":0,\"args\":{\"value\":%f}}",
+                    (frame.start + frame.duration) * 1000.0, value.value);
+            }
+        }
+
+        std::fprintf(file, "\n]}\n");
+
+        return std::fclose(file) == 0;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Frame profiler. CPU time of (nested) zones and recorded values are kept for the last frames in ring buffer.
+// Phases of frame are measured by runtime, user zones are added with PROFILE_ZONE macro:
+//
+//     void update()
+//     {
+//         PROFILE_ZONE("physics");
+//         world.Update();
+//     }
+//
+// Zone names are not copied, they must be string literals (or live as long as profiler).
+namespace frame
+{
+    struct profile_zone
+    {
+        const char* name;
+        int32_t depth;   // 0 for top level zones
+        double start;    // since start of frame [ms]
+        double duration; // [ms]
+    };
+
+    struct profile_value
+    {
+        const char* name;
+        double value;
+    };
+
+    struct profile_frame
+    {
+        uint64_t index = 0;
+        double start = 0.0;    // since start of profiler [ms]
+        double duration = 0.0; // [ms]
+
+        std::vector<profile_zone> zones; // in order in which zones were started
+        std::vector<profile_value> values;
+    };
+
+    // profiler is disabled by default, change is applied at the start of next frame
+    void set_profiler_enabled(bool enabled);
+    bool is_profiler_enabled();
+    // number of recorded frames, clears recorded frames
+    void set_profiler_history(size_t frames);
+
+    void profiler_begin_zone(const char* name);
+    void profiler_end_zone();
+    // e.g. counters or timings measured elsewhere (b2Profile)
+    void profiler_record_value(const char* name, double value);
+
+    // number of completed frames in history
+    size_t get_profiler_frame_count();
+    // 0 is the last completed frame
+    const profile_frame& get_profiler_frame(size_t age);
+
+    // ImGui window with frame times and timeline of selected frame
+    void draw_profiler_overlay();
+    // write recorded frames as Chrome trace JSON (chrome://tracing, Perfetto), return false if file can't be written
+    bool dump_profiler_trace(const char* path);
+
+    struct profile_scope
+    {
+        profile_scope(const char* name) { profiler_begin_zone(name); }
+        ~profile_scope() { profiler_end_zone(); }
+    };
+}
+
+#define PROFILE_ZONE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_IMPL(a, b)
+#define PROFILE_ZONE(name) frame::profile_scope PROFILE_ZONE_CONCAT(profile_scope_, __LINE__)(name)
@@ -0,0 +1,323 @@
+#include "renderer.h"
+#include "common.h"
+#include "slot_map.h"
+
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+
+#include "renderer.glsl.h"
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+using namespace frame;
+
+namespace renderer
+{
+    // layout must match instance attributes in renderer.glsl
+    struct instance
+    {
+        float position[2];
+        float size[2];      // width and height of rectangle, diameter of circle
+        float radians;
+        float kind;         // 0 rectangle, 1 circle
+        uint32_t color;     // RGBA8
+    };
+
+    // instance buffer is streamed, all batches of one frame must fit into it
+    constexpr size_t MaxFrameInstances = 1 << 16;
+
+    struct mesh_data
+    {
+        sg_buffer buffer{}; // dynamic, updated in place while vertices fit into it
+        int count = 0;
+        size_t capacity = 0;    // vertices
+        uint64_t update_frame = 0;
+    };
+
+    struct
+    {
+        sg_pipeline pipeline;
+        sg_bindings bindings;
+
+        sg_pipeline mesh_pipeline;
+        slot_map<mesh_data> meshes;
+
+        std::vector<instance> instances;
+        bool batching = false;
+
+        uint64_t frame = 0;
+        size_t frame_instances = 0; // already appended to instance buffer in current frame
+    } state;
+
+    col4 unpack_color(uint32_t color)
+    {
+        return col4::RGB(color & 0xff, (color >> 8) & 0xff, (color >> 16) & 0xff, (color >> 24) & 0xff);
+    }
+
+    void setup_blending(sg_pipeline_desc& desc)
+    {
+        desc.colors[0].blend.enabled = true;
+        desc.colors[0].blend.src_factor_rgb = SG_BLENDFACTOR_SRC_ALPHA;
+        desc.colors[0].blend.dst_factor_rgb = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+        desc.colors[0].blend.src_factor_alpha = SG_BLENDFACTOR_ONE;
+        desc.colors[0].blend.dst_factor_alpha = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+    }
+
+    void setup_mesh_pipeline()
+    {
+        sg_pipeline_desc desc{};
+        desc.shader = sg_make_shader(shape_shader_desc(sg_query_backend()));
+        desc.layout.attrs[ATTR_shape_vs_position].offset = offsetof(vertex, position);
+        desc.layout.attrs[ATTR_shape_vs_position].format = SG_VERTEXFORMAT_FLOAT2;
+        desc.layout.attrs[ATTR_shape_vs_color0].offset = offsetof(vertex, color);
+        desc.layout.attrs[ATTR_shape_vs_color0].format = SG_VERTEXFORMAT_UBYTE4N;
+        setup_blending(desc);
+        desc.label = "renderer-mesh-pipeline";
+
+        state.mesh_pipeline = sg_make_pipeline(&desc);
+    }
+
+    void setup()
+    {
+        const float corners[] =
+        {
+            -0.5f, -0.5f,
+             0.5f, -0.5f,
+             0.5f,  0.5f,
+            -0.5f,  0.5f,
+        };
+        const uint16_t indices[] = { 0, 1, 2, 0, 2, 3 };
+
+        {
+            sg_buffer_desc desc{};
+            desc.data = SG_RANGE(corners);
+            desc.label = "renderer-corners";
+            state.bindings.vertex_buffers[0] = sg_make_buffer(&desc);
+        }
+        {
+            sg_buffer_desc desc{};
+            desc.size = MaxFrameInstances * sizeof(instance);
+            desc.usage = SG_USAGE_STREAM;
+            desc.label = "renderer-instances";
+            state.bindings.vertex_buffers[1] = sg_make_buffer(&desc);
+        }
+        {
+            sg_buffer_desc desc{};
+            desc.type = SG_BUFFERTYPE_INDEXBUFFER;
+            desc.data = SG_RANGE(indices);
+            desc.label = "renderer-indices";
+            state.bindings.index_buffer = sg_make_buffer(&desc);
+        }
+
+        sg_pipeline_desc desc{};
+        desc.shader = sg_make_shader(renderer_shader_desc(sg_query_backend()));
+        desc.index_type = SG_INDEXTYPE_UINT16;
+        desc.layout.buffers[1].step_func = SG_VERTEXSTEP_PER_INSTANCE;
+
+        auto set_attribute = [&desc](int attribute, int buffer, size_t offset, sg_vertex_format format)
+        {
+            desc.layout.attrs[attribute].buffer_index = buffer;
+            desc.layout.attrs[attribute].offset = (int)offset;
+            desc.layout.attrs[attribute].format = format;
+        };
+        set_attribute(ATTR_vs_corner, 0, 0, SG_VERTEXFORMAT_FLOAT2);
+        set_attribute(ATTR_vs_position, 1, offsetof(instance, position), SG_VERTEXFORMAT_FLOAT2);
+        set_attribute(ATTR_vs_size, 1, offsetof(instance, size), SG_VERTEXFORMAT_FLOAT2);
+        set_attribute(ATTR_vs_rotation_kind, 1, offsetof(instance, radians), SG_VERTEXFORMAT_FLOAT2);
+        set_attribute(ATTR_vs_color0, 1, offsetof(instance, color), SG_VERTEXFORMAT_UBYTE4N);
+
+        setup_blending(desc);
+        desc.label = "renderer-pipeline";
+
+        state.pipeline = sg_make_pipeline(&desc);
+
+        setup_mesh_pipeline();
+    }
+
+    // flush what nanovg collected until now, so what is drawn by sokol is drawn over it
+    void flush_nanovg()
+    {
+        nvgEndFrame(vg);
+        sg_reset_state_cache();
+    }
+
+    // continue nanovg drawing with the same world transform
+    void resume_nanovg()
+    {
+        const auto screen_size = get_screen_size();
+        nvgBeginFrame(vg, screen_size.x, screen_size.y, 1.0f);
+        nvgResetTransform(vg);
+        apply_transform(transforms.back().get());
+    }
+
+    template<typename T>
+    void fill_transform_params(T& params, const mat3& transform)
+    {
+        const auto screen_size = get_screen_size();
+
+        params.transform_x[0] = transform.data[0];
+        params.transform_x[1] = transform.data[1];
+        params.transform_x[2] = transform.data[2];
+        params.transform_y[0] = transform.data[3];
+        params.transform_y[1] = transform.data[4];
+        params.transform_y[2] = transform.data[5];
+        params.screen_size[0] = screen_size.x;
+        params.screen_size[1] = screen_size.y;
+    }
+
+    void begin_batch()
+    {
+        assert(!state.batching);
+
+        state.batching = true;
+        state.instances.clear();
+    }
+
+    void push_rectangle(const vec2& position, float radians, float width, float height, const col4& color)
+    {
+        assert(state.batching);
+
+        // nothing to see
+        if (color.alpha() <= 0.0f)
+            return;
+
+        state.instances.push_back({ { position.x, position.y }, { width, height }, radians, 0.0f, pack_color(color) });
+    }
+
+    void push_circle(const vec2& position, float radians, float radius, const col4& color)
+    {
+        assert(state.batching);
+
+        if (color.alpha() <= 0.0f)
+            return;
+
+        state.instances.push_back({ { position.x, position.y }, { 2.0f * radius, 2.0f * radius }, radians, 1.0f, pack_color(color) });
+    }
+
+    void draw_instances(const instance* instances, size_t count)
+    {
+        vs_params_t params{};
+        fill_transform_params(params, transforms.back().get());
+
+        state.bindings.vertex_buffer_offsets[1] = sg_append_buffer(state.bindings.vertex_buffers[1], { instances, count * sizeof(instance) });
+
+        sg_apply_pipeline(state.pipeline);
+        sg_apply_bindings(&state.bindings);
+        sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_params, SG_RANGE(params));
+        sg_draw(0, 6, (int)count);
+    }
+
+    void end_batch()
+    {
+        assert(state.batching);
+        state.batching = false;
+
+        if (state.instances.empty())
+            return;
+
+        if (state.frame != sapp_frame_count())
+        {
+            state.frame = sapp_frame_count();
+            state.frame_instances = 0;
+        }
+
+        size_t count = std::min(state.instances.size(), MaxFrameInstances - state.frame_instances);
+
+        flush_nanovg();
+
+        if (count > 0)
+        {
+            draw_instances(state.instances.data(), count);
+            state.frame_instances += count;
+        }
+
+        resume_nanovg();
+
+        // what did not fit into instance buffer is drawn by nanovg
+        for (size_t i = count; i < state.instances.size(); i++)
+        {
+            const auto& item = state.instances[i];
+            vec2 position(item.position[0], item.position[1]);
+
+            if (item.kind == 0.0f)
+                draw_rectangle_ex(position, item.radians, item.size[0], item.size[1], unpack_color(item.color), 0.0f, col4::BLANK);
+            else
+                draw_circle_ex(position, item.radians, item.size[0] / 2.0f, unpack_color(item.color), 0.0f, col4::BLANK);
+        }
+
+        state.instances.clear();
+    }
+
+    mesh create_mesh(const std::vector<vertex>& vertices)
+    {
+        mesh m = state.meshes.insert(mesh_data{});
+        update_mesh(m, vertices);
+
+        return m;
+    }
+
+    void update_mesh(mesh m, const std::vector<vertex>& vertices)
+    {
+        auto& data = state.meshes[m];
+        data.count = (int)vertices.size();
+
+        if (vertices.empty())
+            return;
+
+        // dynamic buffer could be updated only once per frame, mesh updated again in the same frame
+        // (e.g. drawn at different scales) or grown over capacity gets new buffer
+        const uint64_t current_frame = sapp_frame_count();
+        if (data.buffer.id == SG_INVALID_ID || vertices.size() > data.capacity || data.update_frame == current_frame)
+        {
+            if (data.buffer.id != SG_INVALID_ID)
+                sg_destroy_buffer(data.buffer);
+
+            // room for growing geometry, e.g. trajectory
+            if (vertices.size() > data.capacity)
+                data.capacity = std::max(vertices.size(), data.capacity + data.capacity / 2);
+
+            sg_buffer_desc desc{};
+            desc.size = data.capacity * sizeof(vertex);
+            desc.usage = SG_USAGE_DYNAMIC;
+            desc.label = "renderer-mesh";
+            data.buffer = sg_make_buffer(&desc);
+        }
+
+        sg_update_buffer(data.buffer, { vertices.data(), vertices.size() * sizeof(vertex) });
+        data.update_frame = current_frame;
+    }
+
+    void destroy_mesh(mesh m)
+    {
+        auto& data = state.meshes[m];
+        if (data.buffer.id != SG_INVALID_ID)
+            sg_destroy_buffer(data.buffer);
+
+        state.meshes.erase(m);
+    }
+
+    void draw_mesh(mesh m, const mat3& transform)
+    {
+        const auto& data = state.meshes[m];
+        if (data.count == 0)
+            return;
+
+        flush_nanovg();
+
+        shape_vs_params_t params{};
+        fill_transform_params(params, transform);
+
+        sg_bindings bindings{};
+        bindings.vertex_buffers[0] = data.buffer;
+
+        sg_apply_pipeline(state.mesh_pipeline);
+        sg_apply_bindings(&bindings);
+        sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_shape_vs_params, SG_RANGE(params));
+        sg_draw(0, data.count, 1);
+
+        resume_nanovg();
+    }
+}
@@ -0,0 +1,96 @@
+// Shaders of renderer.cpp, compiled by sokol-shdc.
+// Instance of rectangle or circle is a quad with corners in <-0.5, 0.5>, scaled by size, rotated and moved
+// to position, then transformed by world transform into screen coordinates.
+
+@vs vs
+uniform vs_params {
+    vec4 transform_x; // first row of world transform
+    vec4 transform_y; // second row of world transform
+    vec4 screen_size;
+};
+
+in vec2 corner;
+in vec2 position;
+in vec2 size;
+in vec2 rotation_kind;
+in vec4 color0;
+
+out vec4 color;
+out vec2 uv;
+out vec2 kind_softness;
+
+void main() {
+    float c = cos(rotation_kind.x);
+    float s = sin(rotation_kind.x);
+    vec2 local = corner * size;
+    vec3 world = vec3(position + vec2(c * local.x - s * local.y, s * local.x + c * local.y), 1.0);
+
+    vec2 screen = vec2(dot(transform_x.xyz, world), dot(transform_y.xyz, world));
+    vec2 ndc = screen / screen_size.xy * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+
+    color = color0;
+    uv = corner * 2.0;
+
+    // edge of circle is antialiased over one pixel, size.x is diameter of circle
+    float radius = 0.5 * size.x * length(vec2(transform_x.x, transform_y.x));
+    kind_softness = vec2(rotation_kind.y, 1.0 / max(radius, 1.0));
+}
+@end
+
+@fs fs
+in vec4 color;
+in vec2 uv;
+in vec2 kind_softness;
+
+out vec4 frag_color;
+
+void main() {
+    float alpha = 1.0;
+    if (kind_softness.x > 0.5) {
+        alpha = clamp((1.0 - length(uv)) / kind_softness.y + 0.5, 0.0, 1.0);
+        if (alpha <= 0.0) {
+            discard;
+        }
+    }
+    frag_color = vec4(color.rgb, color.a * alpha);
+}
+@end
+
+@program renderer vs fs
+
+// Retained shapes, vertices are tessellated on cpu (drawing.cpp) and transformed by world transform of shape.
+
+@vs shape_vs
+uniform shape_vs_params {
+    vec4 transform_x;
+    vec4 transform_y;
+    vec4 screen_size;
+};
+
+in vec2 position;
+in vec4 color0;
+
+out vec4 color;
+
+void main() {
+    vec3 world = vec3(position, 1.0);
+    vec2 screen = vec2(dot(transform_x.xyz, world), dot(transform_y.xyz, world));
+    vec2 ndc = screen / screen_size.xy * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+
+    color = color0;
+}
+@end
+
+@fs shape_fs
+in vec4 color;
+
+out vec4 frag_color;
+
+void main() {
+    frag_color = color;
+}
+@end
+
+@program shape shape_vs shape_fs
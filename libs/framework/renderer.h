@@ -0,0 +1,49 @@
+#pragma once
+#include "framework.h"
+#include <algorithm>
+#include <vector>
+
+// Batched drawing of rectangles and circles. Shapes pushed between begin_batch and end_batch are
+// collected into one instance buffer and drawn by single instanced draw call in end_batch.
+// Drawing done by nanovg before the batch is flushed in end_batch, so the draw order is preserved.
+namespace renderer
+{
+    // headless runtime renders nothing, drawing functions return before doing any work
+#if defined(FRAMEWORK_HEADLESS)
+    constexpr bool enabled = false;
+#else
+    constexpr bool enabled = true;
+#endif
+
+    void setup();
+
+    void begin_batch();
+    void end_batch();
+
+    // position, size and radius are in world coordinates (world transform is applied)
+    void push_rectangle(const frame::vec2& position, float radians, float width, float height, const frame::col4& color);
+    void push_circle(const frame::vec2& position, float radians, float radius, const frame::col4& color);
+
+    // Meshes are triangle lists kept in GPU buffers, used by retained shapes (see frame::create_shape).
+    // Like batch, drawing of mesh flushes nanovg drawing first.
+    using mesh = int32_t; // handle, 0 is null handle
+
+    struct vertex
+    {
+        float position[2];
+        uint32_t color; // RGBA8, see pack_color
+    };
+
+    mesh create_mesh(const std::vector<vertex>& vertices);
+    void update_mesh(mesh m, const std::vector<vertex>& vertices);
+    void destroy_mesh(mesh m);
+    // transform is from mesh coordinates to screen
+    void draw_mesh(mesh m, const frame::mat3& transform);
+
+    inline uint32_t pack_color(const frame::col4& color)
+    {
+        auto to_byte = [](float value) { return (uint32_t)(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); };
+
+        return to_byte(color.red()) | (to_byte(color.green()) << 8) | (to_byte(color.blue()) << 16) | (to_byte(color.alpha()) << 24);
+    }
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+// Dense storage addressed by generational handles.
+// Values are kept contiguous (erase moves last value into the hole), so iteration does not skip holes.
+// Handle stores slot index and generation of the slot, handle of erased value is detected as stale.
+// Handle is never 0, so 0 can be used as null handle.
+template<typename T>
+class slot_map
+{
+public:
+    using handle = int32_t;
+
+    static constexpr uint32_t index_bits = 20;
+    static constexpr uint32_t index_mask = (1u << index_bits) - 1;
+    static constexpr uint32_t generation_mask = (1u << (31 - index_bits)) - 1;
+
+    handle insert(T&& value);
+    void erase(handle h);
+    void clear();
+
+    bool contains(handle h) const;
+
+    // return nullptr for stale handle
+    T* get(handle h);
+    const T* get(handle h) const;
+
+    // handle must be valid
+    T& operator[](handle h);
+    const T& operator[](handle h) const;
+
+    size_t size() const { return m_values.size(); }
+    bool empty() const { return m_values.empty(); }
+
+    // dense index is position of value during iteration, it changes when other value is erased
+    size_t dense_index(handle h) const;
+    handle handle_at(size_t dense_index) const { return m_handles[dense_index]; }
+
+    typename std::vector<T>::iterator begin() { return m_values.begin(); }
+    typename std::vector<T>::iterator end() { return m_values.end(); }
+    typename std::vector<T>::const_iterator begin() const { return m_values.begin(); }
+    typename std::vector<T>::const_iterator end() const { return m_values.end(); }
+
+private:
+    static constexpr uint32_t invalid_index = ~0u;
+
+    static uint32_t get_index(handle h) { return (uint32_t)h & index_mask; }
+    static uint32_t get_generation(handle h) { return ((uint32_t)h >> index_bits) & generation_mask; }
+    static handle make_handle(uint32_t index, uint32_t generation) { return (handle)((generation << index_bits) | index); }
+
+    struct slot
+    {
+        uint32_t dense_index = invalid_index;
+        uint32_t generation = 1; // 0 is never used, so handle is never 0
+    };
+
+    std::vector<T> m_values;
+    std::vector<handle> m_handles; // handle of each value in m_values
+    std::vector<slot> m_slots;
+    std::vector<uint32_t> m_free_slots;
+};
+
+// implementation of template methods
+
+template<typename T>
+typename slot_map<T>::handle slot_map<T>::insert(T&& value)
+{
+    uint32_t index;
+    if (!m_free_slots.empty())
+    {
+        index = m_free_slots.back();
+        m_free_slots.pop_back();
+    }
+    else
+    {
+        assert(m_slots.size() < index_mask);
+        index = (uint32_t)m_slots.size();
+        m_slots.emplace_back();
+    }
+
+    slot& s = m_slots[index];
+    s.dense_index = (uint32_t)m_values.size();
+
+    handle h = make_handle(index, s.generation);
+    m_values.push_back(std::move(value));
+    m_handles.push_back(h);
+
+    return h;
+}
+
+template<typename T>
+void slot_map<T>::erase(handle h)
+{
+    assert(contains(h));
+
+    uint32_t index = get_index(h);
+    slot& s = m_slots[index];
+
+    // move last value into the hole
+    uint32_t last = (uint32_t)m_values.size() - 1;
+    if (s.dense_index != last)
+    {
+        m_values[s.dense_index] = std::move(m_values[last]);
+        m_handles[s.dense_index] = m_handles[last];
+        m_slots[get_index(m_handles[last])].dense_index = s.dense_index;
+    }
+    m_values.pop_back();
+    m_handles.pop_back();
+
+    s.dense_index = invalid_index;
+    s.generation = (s.generation + 1) & generation_mask;
+    if (s.generation == 0)
+        s.generation = 1;
+
+    m_free_slots.push_back(index);
+}
+
+template<typename T>
+void slot_map<T>::clear()
+{
+    for (auto h : m_handles)
+    {
+        slot& s = m_slots[get_index(h)];
+        s.dense_index = invalid_index;
+        s.generation = (s.generation + 1) & generation_mask;
+        if (s.generation == 0)
+            s.generation = 1;
+
+        m_free_slots.push_back(get_index(h));
+    }
+
+    m_values.clear();
+    m_handles.clear();
+}
+
+template<typename T>
+bool slot_map<T>::contains(handle h) const
+{
+    uint32_t index = get_index(h);
+    if (h <= 0 || index >= m_slots.size())
+        return false;
+
+    const slot& s = m_slots[index];
+    return s.dense_index != invalid_index && s.generation == get_generation(h);
+}
+
+template<typename T>
+T* slot_map<T>::get(handle h)
+{
+    return contains(h) ? &m_values[m_slots[get_index(h)].dense_index] : nullptr;
+}
+
+template<typename T>
+const T* slot_map<T>::get(handle h) const
+{
+    return contains(h) ? &m_values[m_slots[get_index(h)].dense_index] : nullptr;
+}
+
+template<typename T>
+T& slot_map<T>::operator[](handle h)
+{
+    assert(contains(h));
+    return m_values[m_slots[get_index(h)].dense_index];
+}
+
+template<typename T>
+const T& slot_map<T>::operator[](handle h) const
+{
+    assert(contains(h));
+    return m_values[m_slots[get_index(h)].dense_index];
+}
+
+template<typename T>
+size_t slot_map<T>::dense_index(handle h) const
+{
+    assert(contains(h));
+    return m_slots[get_index(h)].dense_index;
+}
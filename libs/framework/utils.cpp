@@ -7,7 +7,7 @@ namespace frame
         // return number between 0 to 1 of current eighth
         float get_angle_eighth(float radians)
         {
-            return std::fmodf(radians, NVG_PI / 4.0f) / (NVG_PI / 4.0f);
+            return std::fmod(radians, NVG_PI / 4.0f) / (NVG_PI / 4.0f);
         }
 
         direction get_start(float radians)
@@ -1,9 +1,11 @@
 #include "world.h"
 #include "framework.h"
+#include "renderer.h"
+#include "profiler.h"
 #include "point_type.h"
+#include <algorithm>
+#include <cmath>
 
-// scale from screen to world
-constexpr float WorldScale = 50.0f;
 constexpr float WorldScaleSqrt = 7.0710678f; // std::sqrtf(WorldScale);
 
 const float World::RopeData::SegmentHeight = 10.0f;
@@ -27,7 +29,14 @@ frame::vec2 WorldScalePoint(const b2Vec2& p)
 World::World(const frame::vec2& gravity)
     : m_world({ gravity.x, gravity.y })
 {
-
+    // bodies of the framework are mostly boxes and circles resting on each other, wide solver solves stacks
+    // about 2x faster with the same results in one build (see solver-benchmark)
+    m_world.SetWideSolving(true);
+    // changed objects and interpolation skip sleeping bodies
+    m_world.SetBodyMoveEvents(true);
+    // copied to contact events of World after each step
+    m_world.SetContactEvents(true);
+    SetHitEventThreshold(WorldScale); // 1 m/s, the same as default of box2d
 }
 
 void World::SetGravity(const frame::vec2& gravity)
@@ -81,6 +90,10 @@ World::Rope World::CreateRope(const std::vector<frame::vec2>& points, const colo
     Object lastObject = leftAttach ? *leftAttach : 0;
 
     std::vector<Object> objects;
+    // length of rope from first point to center of each object, along the joint anchors
+    std::vector<float> ropeDistances;
+    frame::vec2 lastPoint = points.front();
+    float ropeDistance = 0.0f;
     for (size_t i = 0; i < points.size() - 1; i++)
     {
         frame::vec2 vector = (points[i + 1] - points[i]).normalized();
@@ -112,6 +125,9 @@ World::Rope World::CreateRope(const std::vector<frame::vec2>& points, const colo
             if (lastObject)
                 CreateRevoluteJoint(lastObject, object, anchor);
 
+            ropeDistance += (anchor - lastPoint).length() + (center - anchor).length();
+            lastPoint = center;
+
             return object;
         };
 
@@ -120,11 +136,13 @@ World::Rope World::CreateRope(const std::vector<frame::vec2>& points, const colo
             auto object = createObject();
 
             objects.push_back(object);
+            ropeDistances.push_back(ropeDistance);
             centerDistance += ropeY;
             anchorDistance += ropeY;
             lastObject = object;
         }
     }
+    ropeDistance += (points.back() - lastPoint).length();
 
     if (rightAttach)
     {
@@ -143,27 +161,32 @@ World::Rope World::CreateRope(const std::vector<frame::vec2>& points, const colo
     setFilterMask(leftAttach);
     setFilterMask(rightAttach);
 
-    // prepare distance joints
+    // prepare tethers
 
-    // TODO constant increase
-    for (int32_t i = 0; i < objects.size(); i += 3)
+    // revolute joints alone let long rope stretch under load, each object is tethered to both ends of rope
+    // by distance joint which is active only when object is farther than its length along rope,
+    // number of joints grows linearly with number of objects
+    const Object left = leftAttach ? *leftAttach : objects.front();
+    const Object right = rightAttach ? *rightAttach : objects.back();
+    const frame::vec2 leftAnchor = leftAttach ? points.front() : GetPosition(objects.front());
+    const frame::vec2 rightAnchor = rightAttach ? points.back() : GetPosition(objects.back());
+    const float leftDistance = leftAttach ? 0.0f : ropeDistances.front();
+    const float rightDistance = rightAttach ? ropeDistance : ropeDistances.back();
+
+    for (size_t i = 0; i < objects.size(); i++)
     {
-        frame::vec2 anchorDown = GetPosition(objects[i]) + frame::vec2(0.0f, RopeData::SegmentHeight / 2.0f);
-        for (int32_t j = i + 1; j < objects.size(); j++)
-        {
-            frame::vec2 anchor = GetPosition(objects[j]) - frame::vec2(0.0f, RopeData::SegmentHeight / 2.0f);
-            float length = (float)(std::abs(i - j) + 1) * RopeData::SegmentHeight;
+        frame::vec2 center = GetPosition(objects[i]);
 
-            CreateDistanceJointEx(objects[i], objects[j], anchorDown, anchor, length, 0.0f, length);
+        // joints measure in box2d units
+        if (objects[i] != left)
+        {
+            float length = (ropeDistances[i] - leftDistance) / WorldScale;
+            CreateDistanceJointEx(left, objects[i], leftAnchor, center, length, 0.0f, length);
         }
-
-        frame::vec2 anchorUp = GetPosition(objects[i]) - frame::vec2(0.0f, RopeData::SegmentHeight / 2.0f);
-        for (int32_t j = i - 1; j >= 0; j--)
+        if (objects[i] != right)
         {
-            frame::vec2 anchor = GetPosition(objects[j]) + frame::vec2(0.0f, RopeData::SegmentHeight / 2.0f);
-            float length = (float)(std::abs(i - j) + 1) * RopeData::SegmentHeight;
-
-            CreateDistanceJointEx(objects[i], objects[j], anchorUp, anchor, length, 0.0f, length);
+            float length = (rightDistance - ropeDistances[i]) / WorldScale;
+            CreateDistanceJointEx(objects[i], right, center, rightAnchor, length, 0.0f, length);
         }
     }
 
@@ -171,10 +194,10 @@ World::Rope World::CreateRope(const std::vector<frame::vec2>& points, const colo
     data.segments = std::move(objects);
     data.fillColor = color;
 
-    m_ropes[m_ropeCounter++] = std::move(data);
-    m_layers[LayerDefault].ropes.push_back(m_ropeCounter - 1);
+    Rope handle = m_ropes.insert(std::move(data));
+    AddToLayerRope(handle, LayerDefault);
 
-    return m_ropeCounter - 1;
+    return handle;
 }
 
 World::Object World::CreateObject(const frame::vec2& position, float angle, b2Shape& shape, ObjectData&& data)
@@ -194,21 +217,29 @@ World::Object World::CreateObject(const frame::vec2& position, float angle, b2Sh
     body->CreateFixture(&fixtureDef);
 
     data.body = body;
+    data.state = body->GetStateIndex();
     data.fillColor = color_type::WHITE;
+    data.previousPosition = body->GetPosition();
+    data.previousAngle = body->GetAngle();
 
-    m_objects[m_objectCounter++] = std::move(data);
+    Object handle = m_objects.insert(std::move(data));
+    body->GetUserData().pointer = (uintptr_t)handle;
 
-    Object handle = m_objectCounter - 1;
-    m_layers[LayerDefault].objects.push_back(handle);
+    AddToLayer(handle, LayerDefault);
 
     return handle;
 }
 
 void World::Destroy(Object object)
 {
+    RemoveFromLayers(object);
     m_world.DestroyBody(m_objects[object].body);
     m_objects.erase(object);
-    RemoveFromLayers(object);
+}
+
+bool World::IsValid(Object obj)
+{
+    return m_objects.contains(obj);
 }
 
 void World::SetStatic(Object obj, bool isStatic)
@@ -235,8 +266,7 @@ void World::SetVelocity(Object obj, const frame::vec2& velocity)
 void World::SetLayer(Object obj, Layer layer)
 {
     RemoveFromLayers(obj);
-
-    m_layers[layer].objects.push_back(obj);
+    AddToLayer(obj, layer);
 }
 
 void World::SetBullet(Object obj, bool bullet)
@@ -246,13 +276,13 @@ void World::SetBullet(Object obj, bool bullet)
 
 frame::vec2 World::GetPosition(Object obj)
 {
-    return WorldScalePoint(m_objects[obj].body->GetPosition());
+    return WorldScalePoint(GetBodyStates().transforms[m_objects[obj].state].p);
 }
 
 float World::GetRotation(Object obj)
 {
     // TODO verify if angle should be negative
-    return m_objects[obj].body->GetAngle();
+    return GetBodyStates().sweeps[m_objects[obj].state].a;
 }
 
 float World::GetMass(Object obj)
@@ -284,32 +314,303 @@ void World::SetCollisionMask(Object obj, uint16_t mask)
     m_objects[obj].body->GetFixtureList()->SetFilterData(data);
 }
 
+void World::SetSleeping(bool allowed)
+{
+    m_world.SetAllowSleeping(allowed);
+}
+
+void World::SetSleepTime(float seconds)
+{
+    m_world.SetTimeToSleep(seconds);
+}
+
+void World::SetSleepThreshold(Object obj, float speed)
+{
+    m_objects[obj].body->SetSleepThreshold(speed / WorldScale);
+}
+
+bool World::IsAwake(Object obj)
+{
+    return m_objects[obj].body->IsAwake();
+}
+
+void World::SetStepMode(StepMode mode)
+{
+    // moves are not tracked for interpolation in StepMode::Frame
+    if (mode == StepMode::Fixed && m_stepMode != StepMode::Fixed)
+    {
+        const auto& states = GetBodyStates();
+        for (auto& data : m_objects)
+        {
+            data.previousPosition = states.transforms[data.state].p;
+            data.previousAngle = states.sweeps[data.state].a;
+            data.interpolated = false;
+        }
+        m_interpolatedObjects.clear();
+    }
+
+    m_stepMode = mode;
+    m_accumulator = 0.0f;
+    m_interpolation = 1.0f;
+}
+
+void World::SetTimeStep(float timeStep, int32_t maxSubSteps)
+{
+    assert(timeStep > 0.0f && maxSubSteps > 0);
+
+    m_timeStep = timeStep;
+    m_maxSubSteps = maxSubSteps;
+}
+
+void World::SetIterations(int32_t velocityIterations, int32_t positionIterations)
+{
+    m_velocityIterations = velocityIterations;
+    m_positionIterations = positionIterations;
+}
+
+void World::SetBatching(bool batching)
+{
+    m_batching = batching;
+}
+
+void World::SetThreadCount(int32_t threads)
+{
+    assert(threads > 0);
+
+    m_world.SetTaskScheduler(nullptr);
+    m_scheduler.reset(threads > 1 ? new b2ThreadPoolScheduler(threads) : nullptr);
+    m_world.SetTaskScheduler(m_scheduler.get());
+}
+
 void World::Update()
 {
+    PROFILE_ZONE("World::Update");
+
     UpdateMouseJoints();
 
-    m_world.Step(1.0f / 60.0f, 32, 16);
+    m_updateCount++;
+    m_changedObjects.clear();
+    m_beginContactEvents.clear();
+    m_endContactEvents.clear();
+    m_hitEvents.clear();
+
+    if (m_stepMode == StepMode::Frame)
+    {
+        m_stepCount = 1;
+        m_world.Step(m_timeStep, m_velocityIterations, m_positionIterations);
+        CollectMovedObjects();
+        CollectContactEvents();
+        RecordProfile(m_world.GetProfile(), 1);
+        return;
+    }
+
+    // raw delta, smoothed delta would make simulation time drift from real time
+    m_accumulator += (float)(frame::get_delta_time() / 1000.0);
+
+    b2Profile profile{};
+    int32_t steps = std::min((int32_t)(m_accumulator / m_timeStep), m_maxSubSteps);
+    m_stepCount = steps;
+    for (int32_t i = 0; i < steps; i++)
+    {
+        // only transforms before last step are needed for interpolation
+        if (i == steps - 1)
+            StorePreviousTransforms();
+
+        m_world.Step(m_timeStep, m_velocityIterations, m_positionIterations);
+        CollectMovedObjects();
+        CollectContactEvents();
+
+        const b2Profile& stepProfile = m_world.GetProfile();
+        profile.step += stepProfile.step;
+        profile.collide += stepProfile.collide;
+        profile.solve += stepProfile.solve;
+        profile.solveInit += stepProfile.solveInit;
+        profile.solveVelocity += stepProfile.solveVelocity;
+        profile.solvePosition += stepProfile.solvePosition;
+        profile.broadphase += stepProfile.broadphase;
+        profile.solveTOI += stepProfile.solveTOI;
+        profile.toiRounds += stepProfile.toiRounds;
+        profile.toiEvents += stepProfile.toiEvents;
+        profile.toiCalls += stepProfile.toiCalls;
+        profile.toiIterations += stepProfile.toiIterations;
+        profile.toiRootIterations += stepProfile.toiRootIterations;
+        profile.stackPeak = std::max(profile.stackPeak, stepProfile.stackPeak);
+        profile.stackMallocCount += stepProfile.stackMallocCount;
+        profile.awakeBodies = stepProfile.awakeBodies;
+        profile.sleepingBodies = stepProfile.sleepingBodies;
+        profile.awakeIslands = stepProfile.awakeIslands;
+        profile.asleepIslands += stepProfile.asleepIslands;
+    }
+    RecordProfile(profile, steps);
+
+    m_accumulator -= steps * m_timeStep;
+    if (m_accumulator >= m_timeStep)
+        m_accumulator = std::fmod(m_accumulator, m_timeStep);
+
+    m_interpolation = m_accumulator / m_timeStep;
 }
 
-void World::Draw(Layer layer)
+int32_t World::GetStepCount() const
 {
-    assert(m_layers.find(layer) != std::end(m_layers));
+    return m_stepCount;
+}
 
-    auto& layerObjects = m_layers[layer];
+void World::CollectMovedObjects()
+{
+    // only awake bodies are reported
+    const b2BodyMoveEvents* moves = m_world.GetBodyMoveEvents();
 
-    for (const auto& obj : layerObjects.objects)
+    for (int32_t i = 0; i < moves->count; i++)
     {
-        assert(m_objects.find(obj) != std::end(m_objects));
+        Object obj = GetObjectFromBody(moves->events[i].body);
+        if (!obj)
+            continue;
 
-        DrawObject(m_objects[obj]);
+        auto& data = m_objects[obj];
+        if (data.changedUpdate != m_updateCount)
+        {
+            data.changedUpdate = m_updateCount;
+            m_changedObjects.push_back(obj);
+        }
+
+        if (m_stepMode == StepMode::Fixed && !data.interpolated)
+        {
+            data.interpolated = true;
+            m_interpolatedObjects.push_back(obj);
+        }
     }
+}
 
-    for (const auto& rope : layerObjects.ropes)
+void World::CollectContactEvents()
+{
+    // events of box2d are overwritten by next step
+    const b2ContactEvents* events = m_world.GetContactEvents();
+
+    auto collect = [this](const b2ContactTouchEvent* touchEvents, int32_t count, std::vector<ContactEvent>& result)
     {
-        assert(m_ropes.find(rope) != std::end(m_ropes));
+        for (int32_t i = 0; i < count; i++)
+        {
+            Object object1 = GetObjectFromBody(touchEvents[i].fixtureA->GetBody());
+            Object object2 = GetObjectFromBody(touchEvents[i].fixtureB->GetBody());
+            if (object1 && object2)
+                result.push_back({ object1, object2 });
+        }
+    };
+    collect(events->beginEvents, events->beginCount, m_beginContactEvents);
+    collect(events->endEvents, events->endCount, m_endContactEvents);
 
-        DrawRope(m_ropes[rope]);
+    for (int32_t i = 0; i < events->hitCount; i++)
+    {
+        const auto& hit = events->hitEvents[i];
+        Object object1 = GetObjectFromBody(hit.fixtureA->GetBody());
+        Object object2 = GetObjectFromBody(hit.fixtureB->GetBody());
+        if (object1 && object2)
+            m_hitEvents.push_back({ object1, object2, WorldScalePoint(hit.point), { hit.normal.x, hit.normal.y }, hit.approachSpeed * WorldScale });
+    }
+}
+
+void World::RecordProfile(const b2Profile& profile, int32_t steps)
+{
+    if (!frame::is_profiler_enabled())
+        return;
+
+    // times of all steps of frame [ms]
+    frame::profiler_record_value("b2 steps", steps);
+    frame::profiler_record_value("b2 step", profile.step);
+    frame::profiler_record_value("b2 collide", profile.collide);
+    frame::profiler_record_value("b2 solve", profile.solve);
+    frame::profiler_record_value("b2 solve init", profile.solveInit);
+    frame::profiler_record_value("b2 solve velocity", profile.solveVelocity);
+    frame::profiler_record_value("b2 solve position", profile.solvePosition);
+    frame::profiler_record_value("b2 broadphase", profile.broadphase);
+    frame::profiler_record_value("b2 solve TOI", profile.solveTOI);
+    // continuous collision of all steps, cost grows with fast bodies and bullets
+    frame::profiler_record_value("b2 TOI rounds", profile.toiRounds);
+    frame::profiler_record_value("b2 TOI events", profile.toiEvents);
+    frame::profiler_record_value("b2 TOI calls", profile.toiCalls);
+    frame::profiler_record_value("b2 TOI iterations", profile.toiIterations);
+    frame::profiler_record_value("b2 TOI root iterations", profile.toiRootIterations);
+    // per step temporaries, peak of steps [bytes] and allocations on the heap (only when stack grows)
+    frame::profiler_record_value("b2 stack peak", profile.stackPeak);
+    frame::profiler_record_value("b2 stack mallocs", profile.stackMallocCount);
+    frame::profiler_record_value("b2 bodies", m_world.GetBodyCount());
+    // state after last step, islands which fell asleep in all steps
+    frame::profiler_record_value("b2 awake bodies", profile.awakeBodies);
+    frame::profiler_record_value("b2 sleeping bodies", profile.sleepingBodies);
+    frame::profiler_record_value("b2 awake islands", profile.awakeIslands);
+    frame::profiler_record_value("b2 islands fell asleep", profile.asleepIslands);
+    frame::profiler_record_value("b2 contacts", m_world.GetContactCount());
+
+    b2BlockAllocatorStats memory;
+    m_world.GetMemoryStats(&memory);
+    frame::profiler_record_value("b2 memory chunks [bytes]", memory.chunkBytes);
+    frame::profiler_record_value("b2 memory large [bytes]", memory.largeBytes);
+}
+
+const b2BodyStateArrays& World::GetBodyStates() const
+{
+    return m_world.GetBodyStateArrays();
+}
+
+void World::StorePreviousTransforms()
+{
+    const auto& states = GetBodyStates();
+
+    // sleeping objects did not move, their previous transform is already the current one
+    for (Object obj : m_interpolatedObjects)
+    {
+        if (!m_objects.contains(obj))
+            continue;
+
+        auto& data = m_objects[obj];
+        data.previousPosition = states.transforms[data.state].p;
+        data.previousAngle = states.sweeps[data.state].a;
+        data.interpolated = false;
     }
+    m_interpolatedObjects.clear();
+}
+
+b2Transform World::GetDrawTransform(const ObjectData& data)
+{
+    const auto& states = GetBodyStates();
+
+    if (m_stepMode == StepMode::Frame || !data.interpolated)
+        return states.transforms[data.state];
+
+    const float alpha = m_interpolation;
+    b2Vec2 position = (1.0f - alpha) * data.previousPosition + alpha * states.transforms[data.state].p;
+    float angle = (1.0f - alpha) * data.previousAngle + alpha * states.sweeps[data.state].a;
+
+    return b2Transform(position, b2Rot(angle));
+}
+
+void World::Draw(Layer layer)
+{
+    PROFILE_ZONE("World::Draw");
+
+    if (!renderer::enabled)
+        return;
+
+    auto it = m_layers.find(layer);
+    assert(it != std::end(m_layers));
+    if (it == std::end(m_layers))
+        return;
+
+    auto& layerObjects = it->second;
+    if (layerObjects.dirty)
+        SortLayer(layerObjects);
+
+    if (m_batching)
+        renderer::begin_batch();
+
+    for (const auto& obj : layerObjects.objects)
+        DrawObject(m_objects[obj]);
+
+    if (m_batching)
+        renderer::end_batch();
+
+    for (const auto& rope : layerObjects.ropes)
+        DrawRope(m_ropes[rope]);
 
     // debug
     //DrawJointsDebug();
@@ -317,12 +618,20 @@ void World::Draw(Layer layer)
 
 void World::DrawObject(const ObjectData& data)
 {
-    auto position = WorldScalePoint(data.body->GetPosition());
+    b2Transform transform = GetDrawTransform(data);
+    auto position = WorldScalePoint(transform.p);
 
-    if (data.type == ObjectData::Type::Rectangle)
+    if (m_batching)
+    {
+        if (data.type == ObjectData::Type::Rectangle)
+            renderer::push_rectangle(position, transform.q.GetAngle(), data.shape.rectangle.width, data.shape.rectangle.height, data.fillColor);
+        else
+            renderer::push_circle(position, transform.q.GetAngle(), data.shape.circle.radius, data.fillColor);
+    }
+    else if (data.type == ObjectData::Type::Rectangle)
     {
         frame::draw_rectangle_ex(position,
-            data.body->GetAngle(),
+            transform.q.GetAngle(),
             data.shape.rectangle.width,
             data.shape.rectangle.height,
             data.fillColor, 0.0f, color_type::BLANK);
@@ -330,7 +639,7 @@ void World::DrawObject(const ObjectData& data)
     else
     {
         frame::draw_circle_ex(position,
-            data.body->GetAngle(),
+            transform.q.GetAngle(),
             data.shape.circle.radius,
             data.fillColor, 0.0f, color_type::BLANK);
     }
@@ -338,30 +647,29 @@ void World::DrawObject(const ObjectData& data)
 
 void World::DrawRope(const RopeData& data)
 {
-    for (const auto& rope : m_ropes)
-    {
-        std::vector<frame::vec2> points(data.segments.size() + 2);
+    std::vector<frame::vec2> points(data.segments.size() + 2);
 
-        points[0] = WorldScalePoint(m_objects[data.segments[0]].body->GetWorldPoint(WorldScalePoint(frame::vec2(0.0f, -RopeData::SegmentHeight))));
+    b2Transform first = GetDrawTransform(m_objects[data.segments[0]]);
+    points[0] = WorldScalePoint(b2Mul(first, WorldScalePoint(frame::vec2(0.0f, -RopeData::SegmentHeight))));
 
-        for (size_t i = 0; i < data.segments.size(); i++)
-            points[i + 1] = WorldScalePoint(m_objects[data.segments[i]].body->GetPosition());
+    for (size_t i = 0; i < data.segments.size(); i++)
+        points[i + 1] = WorldScalePoint(GetDrawTransform(m_objects[data.segments[i]]).p);
 
-        points.back() = WorldScalePoint(m_objects[data.segments.back()].body->GetWorldPoint(WorldScalePoint(frame::vec2(0.0f, RopeData::SegmentHeight))));;
+    b2Transform last = GetDrawTransform(m_objects[data.segments.back()]);
+    points.back() = WorldScalePoint(b2Mul(last, WorldScalePoint(frame::vec2(0.0f, RopeData::SegmentHeight))));
 
-        frame::draw_bezier_polyline_ex(points, RopeData::SegmentHeight * 1.0f, data.fillColor);
-    }
+    frame::draw_bezier_polyline_ex(points, RopeData::SegmentHeight * 1.0f, data.fillColor);
 }
 
 void World::DrawJointsDebug()
 {
     for (const auto& joint : m_joints)
     {
-        if (joint.second->GetType() != e_revoluteJoint)
+        if (joint->GetType() != e_revoluteJoint)
             continue;
 
-        auto p1 = WorldScalePoint(joint.second->GetAnchorA());
-        auto p2 = WorldScalePoint(joint.second->GetAnchorB());
+        auto p1 = WorldScalePoint(joint->GetAnchorA());
+        auto p2 = WorldScalePoint(joint->GetAnchorB());
 
         frame::draw_circle_ex(p1, 0.0f, 5.0f, color_type::RGBf(1.0f, 0.0f, 0.0f, 0.5f), 0.0f, color_type::BLANK);
         frame::draw_circle_ex(p2, 0.0f, 5.0f, color_type::RGBf(1.0f, 0.0f, 0.0f, 0.5f), 0.0f, color_type::BLANK);
@@ -372,87 +680,233 @@ void World::DrawJointsDebug()
 void World::SetLayerRope(Rope rope, Layer layer)
 {
     RemoveFromLayersRope(rope);
+    AddToLayerRope(rope, layer);
+}
+
+void World::SetLayerSorted(Layer layer, bool sorted)
+{
+    auto& layerData = m_layers[layer];
+
+    layerData.sorted = sorted;
+    layerData.dirty = sorted;
+}
+
+void World::AddToLayer(Object obj, Layer layer)
+{
+    auto& layerData = m_layers[layer];
+    auto& membership = m_objects[obj].layer;
 
-    m_layers[layer].ropes.push_back(rope);
+    membership.layer = layer;
+    membership.index = (uint32_t)layerData.objects.size();
+    membership.order = m_layerOrderCounter++;
+
+    layerData.objects.push_back(obj);
+}
+
+void World::AddToLayerRope(Rope rope, Layer layer)
+{
+    auto& layerData = m_layers[layer];
+    auto& membership = m_ropes[rope].layer;
+
+    membership.layer = layer;
+    membership.index = (uint32_t)layerData.ropes.size();
+    membership.order = m_layerOrderCounter++;
+
+    layerData.ropes.push_back(rope);
 }
 
 void World::RemoveFromLayersRope(Rope rope)
 {
-    for (auto& [layer, layerObjects] : m_layers)
-    {
-        auto it = std::find(std::begin(layerObjects.ropes), std::end(layerObjects.ropes), rope);
-        if (it != std::end(layerObjects.ropes))
-        {
-            layerObjects.ropes.erase(it);
-            break;
-        }
-    }
+    const auto& membership = m_ropes[rope].layer;
+    auto& layerData = m_layers[membership.layer];
+
+    assert(layerData.ropes[membership.index] == rope);
+
+    // swap with last and pop
+    Rope last = layerData.ropes.back();
+    layerData.ropes[membership.index] = last;
+    m_ropes[last].layer.index = membership.index;
+    layerData.ropes.pop_back();
+
+    layerData.dirty = layerData.sorted;
 }
 
 void World::RemoveFromLayers(Object obj)
 {
-    for (auto& [layer, layerObjects] : m_layers)
+    const auto& membership = m_objects[obj].layer;
+    auto& layerData = m_layers[membership.layer];
+
+    assert(layerData.objects[membership.index] == obj);
+
+    // swap with last and pop
+    Object last = layerData.objects.back();
+    layerData.objects[membership.index] = last;
+    m_objects[last].layer.index = membership.index;
+    layerData.objects.pop_back();
+
+    layerData.dirty = layerData.sorted;
+}
+
+void World::SortLayer(LayerData& layerData)
+{
+    std::sort(std::begin(layerData.objects), std::end(layerData.objects), [this](Object a, Object b)
     {
-        auto it = std::find(std::begin(layerObjects.objects), std::end(layerObjects.objects), obj);
-        if (it != std::end(layerObjects.objects))
-        {
-            layerObjects.objects.erase(it);
-            break;
-        }
-    }
+        return m_objects[a].layer.order < m_objects[b].layer.order;
+    });
+    for (size_t i = 0; i < layerData.objects.size(); i++)
+        m_objects[layerData.objects[i]].layer.index = (uint32_t)i;
+
+    std::sort(std::begin(layerData.ropes), std::end(layerData.ropes), [this](Rope a, Rope b)
+    {
+        return m_ropes[a].layer.order < m_ropes[b].layer.order;
+    });
+    for (size_t i = 0; i < layerData.ropes.size(); i++)
+        m_ropes[layerData.ropes[i]].layer.index = (uint32_t)i;
+
+    layerData.dirty = false;
 }
 
 void World::Clear()
 {
-    for (auto& [_, obj] : m_objects)
+    for (auto& obj : m_objects)
         m_world.DestroyBody(obj.body);
 
+    // joints are destroyed together with bodies
     m_objects.clear();
+    m_joints.clear();
+    m_ropes.clear();
     m_layers.clear();
+    m_changedObjects.clear();
+    m_interpolatedObjects.clear();
+
+    // memory of destroyed bodies would stay with the world until it is destroyed
+    m_world.CompactMemory();
 }
 
 World::Object World::GetObjectFromBody(b2Body* body)
 {
-    for (auto& [obj, data] : m_objects)
+    // bodies not created through World (e.g. ground of mouse joint) have null handle
+    return (Object)body->GetUserData().pointer;
+}
+
+std::vector<World::Object> World::QueryObjects(const frame::vec2& position)
+{
+    std::vector<QueryHit> hits(4);
+    size_t count = QueryObjects(&position, 1, hits.data(), hits.size());
+    if (count > hits.size())
     {
-        if (data.body == body)
-            return obj;
+        hits.resize(count);
+        QueryObjects(&position, 1, hits.data(), hits.size());
     }
-    assert(false);
-    return -1;
+
+    std::vector<World::Object> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; i++)
+        result.push_back(hits[i].object);
+
+    return result;
 }
 
-class QueryObjectsCallback : public b2QueryCallback
+size_t World::QueryObjects(const frame::vec2* positions, size_t count, QueryHit* hits, size_t capacity)
 {
-    virtual bool ReportFixture(b2Fixture* f)
+    m_queryBoxes.resize(count);
+    for (size_t i = 0; i < count; i++)
     {
-        if (f->TestPoint(point))
-            bodies.push_back(f->GetBody());
-        return true;
+        b2Vec2 point = WorldScalePoint(positions[i]);
+        m_queryBoxes[i].lowerBound = point - b2Vec2(0.1f, 0.1f);
+        m_queryBoxes[i].upperBound = point + b2Vec2(0.1f, 0.1f);
     }
-public:
-    std::vector<b2Body*> bodies;
-    b2Vec2 point;
-};
 
-std::vector<World::Object> World::QueryObjects(const frame::vec2& position)
-{
-    QueryObjectsCallback callback;
-    callback.point = WorldScalePoint(position);
+    // fixtures overlapping the boxes are not known up front, query again if they don't fit
+    m_queryHits.resize(std::max(m_queryHits.size(), count));
+    int32_t fixtureCount = m_world.QueryAABBBatch(m_queryBoxes.data(), (int32_t)count, m_queryHits.data(), (int32_t)m_queryHits.size());
+    if ((size_t)fixtureCount > m_queryHits.size())
+    {
+        m_queryHits.resize(fixtureCount);
+        m_world.QueryAABBBatch(m_queryBoxes.data(), (int32_t)count, m_queryHits.data(), fixtureCount);
+    }
 
-    b2AABB aabb;
-    aabb.lowerBound = callback.point - b2Vec2(0.1f, 0.1f);
-    aabb.upperBound = callback.point + b2Vec2(0.1f, 0.1f);
+    size_t result = 0;
+    for (int32_t i = 0; i < fixtureCount; i++)
+    {
+        const auto& hit = m_queryHits[i];
+        const b2Vec2 point = m_queryBoxes[hit.index].GetCenter();
+        if (!hit.fixture->TestPoint(point))
+            continue;
 
-    m_world.QueryAABB(&callback, aabb);
+        Object obj = GetObjectFromBody(hit.fixture->GetBody());
+        if (!obj)
+            continue;
 
-    std::vector<World::Object> result;
-    for (auto body : callback.bodies)
-        result.push_back(GetObjectFromBody(body));
+        if (result < capacity)
+            hits[result] = { (size_t)hit.index, obj };
+        result++;
+    }
 
     return result;
 }
 
+void World::RayCastObjects(const frame::vec2* start, const frame::vec2* end, size_t count, RayHit* hits)
+{
+    m_rayInputs.resize(count);
+    m_rayHits.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        auto& input = m_rayInputs[i];
+        input.p1 = WorldScalePoint(start[i]);
+        input.p2 = WorldScalePoint(end[i]);
+        // empty ray hits nothing
+        input.maxFraction = (input.p2 - input.p1).LengthSquared() > 0.0f ? 1.0f : 0.0f;
+    }
+
+    m_world.RayCastClosest(m_rayInputs.data(), (int32_t)count, m_rayHits.data());
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto& hit = m_rayHits[i];
+        hits[i] = RayHit{};
+        if (!hit.fixture)
+            continue;
+
+        hits[i].object = GetObjectFromBody(hit.fixture->GetBody());
+        hits[i].point = WorldScalePoint(hit.point);
+        hits[i].normal = { hit.normal.x, hit.normal.y };
+        hits[i].fraction = hit.fraction;
+    }
+}
+
+const std::vector<World::ContactEvent>& World::GetBeginContactEvents() const
+{
+    return m_beginContactEvents;
+}
+
+const std::vector<World::ContactEvent>& World::GetEndContactEvents() const
+{
+    return m_endContactEvents;
+}
+
+const std::vector<World::HitEvent>& World::GetHitEvents() const
+{
+    return m_hitEvents;
+}
+
+void World::SetHitEventThreshold(float speed)
+{
+    m_world.SetHitEventThreshold(speed / WorldScale);
+}
+
+const std::vector<World::Object>& World::GetChangedObjects() const
+{
+    return m_changedObjects;
+}
+
+World::SleepStats World::GetSleepStats() const
+{
+    const b2Profile& profile = m_world.GetProfile();
+
+    return { profile.awakeBodies, profile.sleepingBodies, profile.awakeIslands, profile.asleepIslands };
+}
+
 void World::EnsureGroundObjectCreated()
 {
     if (m_ground)
@@ -477,10 +931,10 @@ World::Joint World::CreateMouseJoint(Object obj, const frame::vec2& target)
     def.maxForce = MaxForceFactor * m_objects[obj].body->GetMass();
     b2LinearStiffness(def.stiffness, def.damping, FrequencyHz, DampingRatio, def.bodyA, def.bodyB);
 
-    m_joints[m_jointCounter++] = m_world.CreateJoint(&def);
+    Joint handle = m_joints.insert(m_world.CreateJoint(&def));
     def.bodyB->SetAwake(true);
 
-    return m_jointCounter - 1;
+    return handle;
 }
 
 World::Joint World::CreateRevoluteJoint(Object obj1, Object obj2, const frame::vec2& target)
@@ -492,9 +946,7 @@ World::Joint World::CreateRevoluteJoint(Object obj1, Object obj2, const frame::v
     def.localAnchorA = m_objects[obj1].body->GetLocalPoint(WorldScalePoint(target));
     def.localAnchorB = m_objects[obj2].body->GetLocalPoint(WorldScalePoint(target));
 
-    m_joints[m_jointCounter++] = m_world.CreateJoint(&def);
-
-    return m_jointCounter - 1;
+    return m_joints.insert(m_world.CreateJoint(&def));
 }
 
 World::Joint World::CreateDistanceJoint(Object obj1, Object obj2, const frame::vec2& point1, const frame::vec2& point2, bool allowSmallerDistance)
@@ -510,9 +962,7 @@ World::Joint World::CreateDistanceJoint(Object obj1, Object obj2, const frame::v
     def.minLength = allowSmallerDistance ? 0.0f : def.length;
     //b2LinearStiffness(def.stiffness, def.damping, 1.0f, 1.0f, def.bodyA, def.bodyB);
 
-    m_joints[m_jointCounter++] = m_world.CreateJoint(&def);
-
-    return m_jointCounter - 1;
+    return m_joints.insert(m_world.CreateJoint(&def));
 }
 
 World::Joint World::CreateDistanceJointEx(Object obj1, Object obj2, const frame::vec2& point1, const frame::vec2& point2, float length, float minLength, float maxLength)
@@ -528,9 +978,7 @@ World::Joint World::CreateDistanceJointEx(Object obj1, Object obj2, const frame:
     def.minLength = minLength;
     //b2LinearStiffness(def.stiffness, def.damping, 1.0f, 1.0f, def.bodyA, def.bodyB);
 
-    m_joints[m_jointCounter++] = m_world.CreateJoint(&def);
-
-    return m_jointCounter - 1;
+    return m_joints.insert(m_world.CreateJoint(&def));
 }
 
 void World::DestroyJoint(Joint joint)
@@ -541,7 +989,7 @@ void World::DestroyJoint(Joint joint)
 
 void World::UpdateMouseJoints()
 {
-    for (auto& [_, joint] : m_joints)
+    for (auto joint : m_joints)
     {
         if (joint->GetType() == e_mouseJoint)
         {
@@ -1,11 +1,16 @@
 #pragma once
 #include "point_type.h"
 #include "color_type.h"
+#include "slot_map.h"
 #include <box2d/box2d.h>
 #include <nanovg.h>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
+// scale from screen to world
+constexpr float WorldScale = 50.0f;
+
 b2Vec2 ConvertVector(const point_type<float>& v);
 b2Vec2 WorldScalePoint(const point_type<float>& p);
 point_type<float> WorldScalePoint(const b2Vec2& p);
@@ -26,6 +31,7 @@ public:
 class World
 {
 public:
+    // handles, 0 is null handle
     using Object = int32_t;
     using Layer = int32_t;
     using Joint = int32_t;
@@ -33,6 +39,12 @@ public:
 
     static constexpr Layer LayerDefault = 0;
 
+    enum class StepMode
+    {
+        Frame, // single step of fixed time step per Update call
+        Fixed, // frame delta time is accumulated and simulated in fixed time steps, drawing interpolates between last two steps
+    };
+
     World(const point_type<float>& gravity = { 0.0f, -9.89f });
 
     void SetGravity(const point_type<float>& gravity);
@@ -43,6 +55,9 @@ public:
 
     void Destroy(Object object);
 
+    // false for destroyed object
+    bool IsValid(Object obj);
+
     point_type<float> GetPosition(Object obj);
     float GetRotation(Object obj);
     float GetMass(Object obj);
@@ -56,18 +71,97 @@ public:
     void SetVelocity(Object obj, const point_type<float>& velocity);
     void SetLayer(Object obj, Layer layer = LayerDefault);
     void SetLayerRope(Rope rope, Layer layer = LayerDefault);
+    // objects and ropes of sorted layer are drawn in order in which they were added to layer,
+    // otherwise order changes when something is removed from layer
+    void SetLayerSorted(Layer layer, bool sorted);
     void SetBullet(Object obj, bool bullet);
     void SetDensity(Object obj, float density);
 
     void SetCollisionMask(Object obj, uint16_t mask);
 
+    // objects which stay slower than their sleep threshold for sleep time fall asleep (together with objects touching them),
+    // sleeping objects are not simulated and don't move until something wakes them
+    void SetSleeping(bool allowed);
+    void SetSleepTime(float seconds);
+    void SetSleepThreshold(Object obj, float speed);
+    bool IsAwake(Object obj);
+
+    // StepMode::Fixed by default, simulation runs at real time speed for any frame rate
+    void SetStepMode(StepMode mode);
+    // maxSubSteps limits number of steps per Update in StepMode::Fixed, time which could not be simulated is dropped
+    void SetTimeStep(float timeStep, int32_t maxSubSteps = 8);
+    void SetIterations(int32_t velocityIterations, int32_t positionIterations);
+
+    // objects of layer are drawn by single instanced draw call instead of nanovg path per object
+    void SetBatching(bool batching);
+    // contact manifolds and islands of bodies are computed in parallel by given number of threads (including the calling one), 1 solves on calling thread,
+    // results are the same for any number of threads (web build has no threads, keep 1 there)
+    void SetThreadCount(int32_t threads);
+
     void Update();
     void Draw(Layer layer = LayerDefault);
 
+    // steps simulated by last Update, 0 or more in StepMode::Fixed, e.g. for stepping ParticleSystem along
+    int32_t GetStepCount() const;
+
+    // objects moved by last Update (awake ones and those which fell asleep in it), sleeping objects can be skipped
+    const std::vector<Object>& GetChangedObjects() const;
+
+    struct SleepStats
+    {
+        int32_t awakeBodies;
+        int32_t sleepingBodies;
+        int32_t awakeIslands;  // islands of touching or jointed bodies simulated in last step
+        int32_t asleepIslands; // islands which fell asleep in last step
+    };
+    SleepStats GetSleepStats() const;
+
     void Clear();
 
     std::vector<Object> QueryObjects(const point_type<float>& position);
 
+    struct QueryHit
+    {
+        size_t query; // index of position
+        Object object;
+    };
+    // objects at each of positions, queried together without allocation (scratch buffers are reused),
+    // returns number of hits which may be greater than capacity, hits over capacity are not written
+    size_t QueryObjects(const point_type<float>* positions, size_t count, QueryHit* hits, size_t capacity);
+
+    struct RayHit
+    {
+        Object object = 0; // 0 when ray hit nothing
+        point_type<float> point;
+        point_type<float> normal;
+        float fraction = 1.0f; // from start to end of ray
+    };
+    // closest object hit by each ray from start[i] to end[i], e.g. line of sight or trajectory preview of many objects,
+    // rays are traversed together, sensors and objects containing start of ray are not hit
+    void RayCastObjects(const point_type<float>* start, const point_type<float>* end, size_t count, RayHit* hits);
+
+    struct ContactEvent
+    {
+        Object object1;
+        Object object2;
+    };
+    struct HitEvent
+    {
+        Object object1;
+        Object object2;
+        point_type<float> point;
+        point_type<float> normal; // from object1 to object2
+        float approachSpeed;
+    };
+    // contacts which started or stopped touching in all steps of last Update, filled without callbacks, read them after Update,
+    // objects may be already destroyed (check IsValid if objects were destroyed since Update)
+    const std::vector<ContactEvent>& GetBeginContactEvents() const;
+    const std::vector<ContactEvent>& GetEndContactEvents() const;
+    // contacts which started touching with approach speed over threshold, e.g. sounds or damage
+    const std::vector<HitEvent>& GetHitEvents() const;
+    // minimal approach speed of hit events
+    void SetHitEventThreshold(float speed);
+
     // target is initial position on object which will be dragged to mouse
     Joint CreateMouseJoint(Object obj, const point_type<float>& target);
     void DestroyJoint(Joint joint);
@@ -80,14 +174,56 @@ public:
 
     //private:
     b2World m_world;
-    Object m_objectCounter = 1;
-    Joint m_jointCounter = 1;
-    Rope m_ropeCounter = 1;
+
+    // position of object or rope in layer
+    struct LayerMembership
+    {
+        Layer layer = LayerDefault;
+        uint32_t index = 0; // in LayerData::objects or LayerData::ropes
+        uint32_t order = 0; // for sorted layers
+    };
+
+    StepMode m_stepMode = StepMode::Fixed;
+    float m_timeStep = 1.0f / 60.0f;
+    int32_t m_maxSubSteps = 8;
+    int32_t m_velocityIterations = 32;
+    int32_t m_positionIterations = 16;
+    float m_accumulator = 0.0f;
+    int32_t m_stepCount = 0; // of last Update
+    float m_interpolation = 1.0f; // between previous and current transform of bodies
+    bool m_batching = false;
+    std::unique_ptr<b2ThreadPoolScheduler> m_scheduler; // null when single threaded
+
+    // scratch buffers of batch queries, keep their capacity
+    std::vector<b2AABB> m_queryBoxes;
+    std::vector<b2QueryHit> m_queryHits;
+    std::vector<b2RayCastInput> m_rayInputs;
+    std::vector<b2RayCastHit> m_rayHits;
+
+    // objects moved by last Update, see ObjectData::changedUpdate
+    uint32_t m_updateCount = 0;
+    std::vector<Object> m_changedObjects;
+    // objects which moved since their previous transform was stored, previous transform of others is the current one
+    std::vector<Object> m_interpolatedObjects;
+
+    // contact events of last Update
+    std::vector<ContactEvent> m_beginContactEvents;
+    std::vector<ContactEvent> m_endContactEvents;
+    std::vector<HitEvent> m_hitEvents;
 
     struct ObjectData
     {
         b2Body* body;
+        int32_t state; // slot of body in body state arrays, transforms are read from there
         color_type fillColor;
+        LayerMembership layer;
+
+        // transform before last step, used for interpolation
+        b2Vec2 previousPosition;
+        float previousAngle;
+        bool interpolated = false; // in m_interpolatedObjects
+
+        uint32_t changedUpdate = 0; // m_updateCount of last Update which moved object
 
         enum class Type
         {
@@ -117,16 +253,26 @@ public:
 
         color_type fillColor;
         std::vector<Object> segments;
+        LayerMembership layer;
     };
 
     Object CreateObject(const point_type<float>& position, float angle, b2Shape& shape, ObjectData&& data);
+    const b2BodyStateArrays& GetBodyStates() const;
+    void StorePreviousTransforms();
+    void CollectMovedObjects();
+    void CollectContactEvents();
+    void RecordProfile(const b2Profile& profile, int32_t steps);
+    b2Transform GetDrawTransform(const ObjectData& data);
     void DrawObject(const ObjectData& data);
     void DrawRope(const RopeData& data);
     void DrawJointsDebug();
 
+    void AddToLayer(Object obj, Layer layer);
+    void AddToLayerRope(Rope rope, Layer layer);
     void RemoveFromLayers(Object obj);
     void RemoveFromLayersRope(Rope obj);
 
+    // constant time, handle is stored in body user data
     Object GetObjectFromBody(b2Body* body);
 
     // TODO joints are attached to bodies, if body is destroyed, joints may get destroyed also
@@ -137,11 +283,18 @@ public:
     {
         std::vector<Object> objects;
         std::vector<Rope> ropes;
+
+        bool sorted = false;
+        bool dirty = false; // sorted layer needs to be sorted before drawing
     };
+    uint32_t m_layerOrderCounter = 0;
+
+    void SortLayer(LayerData& layerData);
 
-    std::unordered_map<Object, ObjectData> m_objects;
-    std::unordered_map<Joint, b2Joint*> m_joints;
-    std::unordered_map<Rope, RopeData> m_ropes;
+    slot_map<ObjectData> m_objects;
+    slot_map<b2Joint*> m_joints;
+    slot_map<RopeData> m_ropes;
+    // layers are identified by user chosen numbers, not handles
     std::unordered_map<Layer, LayerData> m_layers;
 
     b2Body* m_ground = nullptr;
@@ -0,0 +1,157 @@
+// Test of thread-safe b2BlockAllocator shared by threads through a b2BlockCache each. Every thread
+// allocates blocks of all size classes through its cache and directly from the allocator, fills them with
+// its own pattern and frees part of them to the cache of another thread. Blocks must not be handed out
+// twice (patterns stay intact), and all blocks must be returned at the end, so Compact frees every chunk.
+// The test fails with exit code 1 otherwise. Build with -fsanitize=thread to check the locking.
+//
+//     allocator-test [--threads 4] [--rounds 200]
+
+#include "box2d/box2d.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct options
+{
+    int32_t threads = 4;
+    int32_t rounds = 200;
+};
+
+const int32_t blocks_per_round = 500;
+
+struct allocation
+{
+    void* memory;
+    int32_t size;
+};
+
+// blocks freed by other threads are passed through these, one per thread
+struct handoff
+{
+    std::vector<allocation> blocks;
+    std::atomic<bool> full{ false };
+};
+
+int32_t get_size(int32_t i)
+{
+    // all size classes and some large allocations
+    return 1 + (i * 37) % 700;
+}
+
+bool check_pattern(const allocation& a, uint8_t pattern)
+{
+    const uint8_t* bytes = (const uint8_t*)a.memory;
+    for (int32_t i = 0; i < a.size; i++)
+    {
+        if (bytes[i] != pattern)
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    options opts;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--threads") == 0)
+            opts.threads = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--rounds") == 0)
+            opts.rounds = std::atoi(argv[i + 1]);
+    }
+
+    b2BlockAllocator allocator;
+    allocator.SetThreadSafe(true);
+
+    std::unique_ptr<handoff[]> handoffs(new handoff[opts.threads]);
+    std::atomic<int32_t> corrupted{ 0 };
+
+    auto work = [&](int32_t thread)
+    {
+        b2BlockCache cache(&allocator);
+        const uint8_t pattern = (uint8_t)(thread + 1);
+        std::vector<allocation> blocks(blocks_per_round);
+
+        for (int32_t round = 0; round < opts.rounds; round++)
+        {
+            for (int32_t i = 0; i < blocks_per_round; i++)
+            {
+                int32_t size = get_size(i + round);
+                void* memory = (i + thread) % 3 == 0 ? allocator.Allocate(size) : cache.Allocate(size);
+                std::memset(memory, pattern, size);
+                blocks[i] = { memory, size };
+            }
+
+            // blocks of previous thread are freed to this cache
+            handoff& incoming = handoffs[thread];
+            if (incoming.full.load(std::memory_order_acquire))
+            {
+                for (const auto& a : incoming.blocks)
+                    cache.Free(a.memory, a.size);
+                incoming.blocks.clear();
+                incoming.full.store(false, std::memory_order_release);
+            }
+
+            handoff& outgoing = handoffs[(thread + 1) % opts.threads];
+            bool handed = false;
+            for (int32_t i = 0; i < blocks_per_round; i++)
+            {
+                if (!check_pattern(blocks[i], pattern))
+                    corrupted++;
+
+                // every tenth block goes to the next thread if it took the previous ones
+                if (i % 10 == 0 && !outgoing.full.load(std::memory_order_acquire))
+                {
+                    outgoing.blocks.push_back(blocks[i]);
+                    handed = true;
+                }
+                else if ((i + thread) % 3 == 0)
+                {
+                    allocator.Free(blocks[i].memory, blocks[i].size);
+                }
+                else
+                {
+                    cache.Free(blocks[i].memory, blocks[i].size);
+                }
+            }
+            if (handed)
+                outgoing.full.store(true, std::memory_order_release);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int32_t i = 0; i < opts.threads; i++)
+        threads.emplace_back(work, i);
+    for (auto& thread : threads)
+        thread.join();
+
+    // blocks still waiting for a thread which already finished
+    for (int32_t i = 0; i < opts.threads; i++)
+    {
+        for (const auto& a : handoffs[i].blocks)
+            allocator.Free(a.memory, a.size);
+    }
+
+    b2BlockAllocatorStats stats;
+    allocator.GetStats(&stats);
+
+    int32_t used = stats.largeCount;
+    for (int32_t i = 0; i < b2_blockSizeCount; i++)
+        used += stats.blockCounts[i];
+    const int32_t chunks = stats.chunkCount;
+
+    allocator.Compact();
+    allocator.GetStats(&stats);
+
+    std::printf("threads %d, chunks %d, used after test %d, chunks after compact %d, corrupted %d\n",
+        opts.threads, chunks, used, stats.chunkCount, corrupted.load());
+
+    bool passed = corrupted == 0 && used == 0 && stats.chunkCount == 0;
+    std::printf("%s\n", passed ? "passed" : "failed");
+
+    return passed ? 0 : 1;
+}
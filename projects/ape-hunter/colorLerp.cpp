@@ -1,6 +1,7 @@
 #include "colorLerp.h"
 
-float LerpTimeIncrement = 0.05f;
+// 20 frames at 60 FPS
+double LerpDuration = 1000.0 / 3.0; // [ms]
 
 extern World world;
 
@@ -10,7 +11,8 @@ ColorLerp::Lerper::Lerper(const frame::col4& source, const frame::col4& destinat
 }
 bool ColorLerp::Lerper::Update()
 {
-    time += LerpTimeIncrement;
+    // smoothed delta, so the lerp doesn't stutter with frame time jitter
+    time += (float)(frame::get_smoothed_delta_time() / LerpDuration);
     return time < 1.0f;
 }
 frame::col4 ColorLerp::Lerper::CurrentColor()
@@ -41,6 +43,10 @@ struct ColorLerp::LerperObject : public ColorLerp::Lerper
     }
     virtual bool Update() override
     {
+        // object may get destroyed while lerping
+        if (!world.IsValid(object))
+            return false;
+
         world.SetFill(object, CurrentColor());
         return Lerper::Update();
     }
@@ -105,6 +105,17 @@ void stopSimulation()
     objects = createObjects();
 }
 
+// hunter takes color of projectile when it's hit
+void handleHits()
+{
+    for (const auto& contact : world.GetBeginContactEvents())
+    {
+        if ((contact.object1 == objects.projectile && contact.object2 == objects.hunter) ||
+            (contact.object1 == objects.hunter && contact.object2 == objects.projectile))
+            colorLerp.LerpObject(objects.hunter, world.GetFill(objects.projectile));
+    }
+}
+
 void createTexts()
 {
     texts.heading = textsManager->Text(u8"Kruh a Štvorec")
@@ -225,18 +236,18 @@ void drawTrajectories(Objects& obj)
     float g = GravityAcceleration;
 
     // dlzka vrhu
-    float d = (v0 * v0 * std::sinf(2.0f * a)) / g;
+    float d = (v0 * v0 * std::sin(2.0f * a)) / g;
     frame::vec2 dp(obj.projectilePosition.x + d, obj.projectilePosition.y);
 
     frame::draw_circle(dp, 2.0f, frame::col4::RGB(80, 80, 80));
 
     // vyska vrhu
-    float h = (v0 * v0 * std::powf(std::sinf(a), 2.0f)) / (2.0f * g);
+    float h = (v0 * v0 * std::pow(std::sin(a), 2.0f)) / (2.0f * g);
     frame::vec2 hp(obj.projectilePosition.x + d / 2.0f, obj.projectilePosition.y + h);
 
     frame::draw_circle(hp, 2.0f, frame::col4::RGB(80, 80, 80));
 
-    float o = std::tanf(a) * (d / 2.0f);
+    float o = std::tan(a) * (d / 2.0f);
     frame::vec2 ohp(obj.projectilePosition.x + d / 2.0f, obj.projectilePosition.y + o);
 
     frame::draw_quad_bezier(obj.projectilePosition, ohp, dp, TrajectoryColor);
@@ -278,7 +289,10 @@ void update()
         drawTrajectories(objects);
 
     if (state == State::Running)
+    {
         world.Update();
+        handleHits();
+    }
 
     world.Draw();
 
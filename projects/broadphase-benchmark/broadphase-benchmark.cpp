@@ -0,0 +1,162 @@
+// Compares cost of broad-phase pair update of b2DynamicTree and b2UniformGrid. Bodies of given size
+// distribution are dropped into a box and simulated, the b2Profile broad-phase time (proxy moves and
+// pair update) and the whole step time are averaged over all steps.
+//
+//     broadphase-benchmark [--steps 120] [--cell 2.0] [--threads 1]
+
+#include "box2d/box2d.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <random>
+
+enum class distribution
+{
+    same_circles,   // circles of one size, e.g. spawners of kladkostroj and rope
+    mixed,          // circles and boxes of 0.5 to 2 times the base size
+    few_large       // same circles and 2% of boxes 8 times the base size
+};
+
+const char* get_name(distribution d)
+{
+    switch (d)
+    {
+    case distribution::same_circles: return "same circles";
+    case distribution::mixed: return "mixed";
+    case distribution::few_large: return "few large";
+    }
+    return "";
+}
+
+struct options
+{
+    int32_t steps = 120;
+    float cell_size = b2_gridCellSize;
+    int32_t threads = 1;
+};
+
+struct result
+{
+    double broadphase = 0.0; // average per step [ms]
+    double step = 0.0;
+    int32_t contacts = 0;    // at the last step
+};
+
+void create_bodies(b2World& world, distribution d, int32_t count)
+{
+    const float size = 0.5f; // radius of base circle
+    const int32_t columns = (int32_t)std::sqrt((float)count);
+    const float width = columns * 2.5f * size;
+
+    // container
+    b2BodyDef ground_def;
+    b2Body* ground = world.CreateBody(&ground_def);
+    b2PolygonShape wall;
+    wall.SetAsBox(width, 1.0f, { 0.0f, -1.0f }, 0.0f);
+    ground->CreateFixture(&wall, 0.0f);
+    wall.SetAsBox(1.0f, 4.0f * width, { -width - 1.0f, 4.0f * width }, 0.0f);
+    ground->CreateFixture(&wall, 0.0f);
+    wall.SetAsBox(1.0f, 4.0f * width, { width + 1.0f, 4.0f * width }, 0.0f);
+    ground->CreateFixture(&wall, 0.0f);
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+    for (int32_t i = 0; i < count; i++)
+    {
+        b2BodyDef def;
+        def.type = b2_dynamicBody;
+        def.position.Set(-width + (i % columns + 0.5f) * 2.0f * width / columns, 2.0f + (i / columns) * 2.5f * size);
+        b2Body* body = world.CreateBody(&def);
+
+        float radius = size;
+        bool box = false;
+        if (d == distribution::mixed)
+        {
+            radius *= scale(random);
+            box = random() % 2 == 0;
+        }
+        else if (d == distribution::few_large && random() % 50 == 0)
+        {
+            radius *= 8.0f;
+            box = true;
+        }
+
+        if (box)
+        {
+            b2PolygonShape shape;
+            shape.SetAsBox(radius, radius);
+            body->CreateFixture(&shape, 1.0f);
+        }
+        else
+        {
+            b2CircleShape shape;
+            shape.m_radius = radius;
+            body->CreateFixture(&shape, 1.0f);
+        }
+    }
+}
+
+result run(b2BroadPhaseType type, distribution d, int32_t count, const options& opts, b2TaskScheduler* scheduler)
+{
+    b2World world({ 0.0f, -10.0f });
+    world.SetBroadPhaseType(type);
+    world.SetGridCellSize(opts.cell_size);
+    world.SetTaskScheduler(scheduler);
+
+    create_bodies(world, d, count);
+
+    result r;
+    for (int32_t i = 0; i < opts.steps; i++)
+    {
+        world.Step(1.0f / 60.0f, 8, 3);
+
+        const b2Profile& profile = world.GetProfile();
+        r.broadphase += profile.broadphase;
+        r.step += profile.step;
+    }
+
+    r.broadphase /= opts.steps;
+    r.step /= opts.steps;
+    r.contacts = world.GetContactCount();
+
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    options opts;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--steps") == 0)
+            opts.steps = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--cell") == 0)
+            opts.cell_size = (float)std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--threads") == 0)
+            opts.threads = std::atoi(argv[i + 1]);
+    }
+
+    b2ThreadPoolScheduler scheduler(opts.threads);
+
+    const int32_t counts[] = { 500, 2000, 8000 };
+    const distribution distributions[] = { distribution::same_circles, distribution::mixed, distribution::few_large };
+
+    std::printf("%-14s %6s | %17s | %17s | %15s\n", "distribution", "bodies", "broadphase [ms]", "step [ms]", "contacts");
+    std::printf("%-14s %6s | %8s %8s | %8s %8s | %7s %7s\n", "", "", "tree", "grid", "tree", "grid", "tree", "grid");
+
+    for (auto d : distributions)
+    {
+        for (auto count : counts)
+        {
+            result tree = run(b2_dynamicTreeBroadPhase, d, count, opts, &scheduler);
+            result grid = run(b2_uniformGridBroadPhase, d, count, opts, &scheduler);
+
+            std::printf("%-14s %6d | %8.3f %8.3f | %8.3f %8.3f | %7d %7d\n", get_name(d), count,
+                tree.broadphase, grid.broadphase, tree.step, grid.step, tree.contacts, grid.contacts);
+            std::fflush(stdout);
+        }
+    }
+
+    return 0;
+}
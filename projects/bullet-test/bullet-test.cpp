@@ -0,0 +1,112 @@
+// Regression test of continuous collision against a static wall. Fast circle bullets are shot through
+// slower boxes at one static wall, TOI events of many bodies share the wall in one step. Scenes of
+// different random seeds are simulated, the test fails with exit code 1 if any bullet passes through.
+//
+//     bullet-test [--scenes 100] [--steps 60] [--threads 1]
+
+#include "box2d/box2d.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+struct options
+{
+    int32_t scenes = 100;
+    int32_t steps = 60;
+    int32_t threads = 1;
+};
+
+// number of bullets behind the wall at the end of simulation
+int32_t run(uint32_t seed, const options& opts, b2TaskScheduler* scheduler)
+{
+    b2World world({ 0.0f, -10.0f });
+    world.SetTaskScheduler(scheduler);
+
+    b2BodyDef wall_def;
+    b2Body* wall = world.CreateBody(&wall_def);
+    b2PolygonShape wall_shape;
+    wall_shape.SetAsBox(0.1f, 20.0f);
+    wall->CreateFixture(&wall_shape, 0.0f);
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+    // bullets cross the wall tens of times in one step
+    std::vector<b2Body*> bullets;
+    for (int32_t i = 0; i < 40; i++)
+    {
+        b2BodyDef def;
+        def.type = b2_dynamicBody;
+        def.bullet = true;
+        def.position.Set(-1.0f - 10.0f * uniform(random), -10.0f + 20.0f * uniform(random));
+        def.linearVelocity.Set(400.0f + 195.0f * uniform(random), 20.0f * (uniform(random) - 0.5f));
+
+        b2CircleShape shape;
+        shape.m_radius = 0.1f;
+
+        b2Body* body = world.CreateBody(&def);
+        body->CreateFixture(&shape, 1.0f);
+        bullets.push_back(body);
+    }
+
+    // boxes in front of the wall, bullets hit them and the wall in the same steps
+    for (int32_t i = 0; i < 30; i++)
+    {
+        b2BodyDef def;
+        def.type = b2_dynamicBody;
+        def.position.Set(-0.5f - 3.0f * uniform(random), -10.0f + 20.0f * uniform(random));
+        def.linearVelocity.Set(60.0f * uniform(random), 0.0f);
+
+        b2PolygonShape shape;
+        shape.SetAsBox(0.3f, 0.3f);
+
+        b2Body* body = world.CreateBody(&def);
+        body->CreateFixture(&shape, 1.0f);
+    }
+
+    for (int32_t i = 0; i < opts.steps; i++)
+        world.Step(1.0f / 60.0f, 8, 3);
+
+    int32_t passed = 0;
+    for (b2Body* bullet : bullets)
+    {
+        if (bullet->GetPosition().x > 0.0f)
+            passed++;
+    }
+
+    return passed;
+}
+
+int main(int argc, char** argv)
+{
+    options opts;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--scenes") == 0)
+            opts.scenes = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--steps") == 0)
+            opts.steps = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--threads") == 0)
+            opts.threads = std::atoi(argv[i + 1]);
+    }
+
+    b2ThreadPoolScheduler scheduler(opts.threads);
+
+    int32_t failed = 0;
+    for (int32_t i = 0; i < opts.scenes; i++)
+    {
+        const uint32_t seed = 100 + i;
+        int32_t passed = run(seed, opts, &scheduler);
+        if (passed > 0)
+        {
+            std::printf("seed %u: %d bullets passed through wall\n", seed, passed);
+            failed++;
+        }
+    }
+
+    std::printf("%d of %d scenes failed\n", failed, opts.scenes);
+
+    return failed == 0 ? 0 : 1;
+}
@@ -1,6 +1,7 @@
 #include "framework.h"
 #include "imgui.h"
 #include "world.h"
+#include "profiler.h"
 
 int32_t circles_count = 0;
 int32_t squares_count = 0;
@@ -9,6 +10,7 @@ World world;
 World::Joint mouse_joint = 0;
 
 bool create_on_hold = false;
+bool show_profiler = false;
 
 void create_square()
 {
@@ -37,6 +39,8 @@ void create_ground()
 
 void setup()
 {
+    world.SetBatching(true);
+
     create_ground();
 
     frame::set_screen_background(frame::col4::RGBf(0.1f, 0.1f, 0.1f));
@@ -88,8 +92,13 @@ void draw_gui()
     ImGui::Text("%.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 
     ImGui::Checkbox("Create while holding button", &create_on_hold);
+    if (ImGui::Checkbox("Profiler", &show_profiler))
+        frame::set_profiler_enabled(show_profiler);
 
     ImGui::End();
+
+    if (show_profiler)
+        frame::draw_profiler_overlay();
 }
 
 void update()
@@ -0,0 +1,82 @@
+// Solve time of World ropes of 10 to 1000 segments. Rope is laid horizontally between static anchor and
+// weight and falls down, b2Profile times are averaged over all steps of one rope. One step per frame,
+// batch run with headless framework:
+//
+//     rope-benchmark --frames 2000
+
+#include "framework.h"
+#include "world.h"
+#include <cstdio>
+#include <memory>
+
+const int32_t segment_counts[] = { 10, 50, 100, 250, 500, 1000 };
+const int32_t segment_count_size = sizeof(segment_counts) / sizeof(segment_counts[0]);
+const int32_t steps_per_rope = 300;
+
+struct
+{
+    std::unique_ptr<World> world;
+    int32_t rope = 0;   // index to segment_counts
+    int32_t step = 0;   // of current rope
+
+    double solve = 0.0; // summed over steps of current rope [ms]
+    double step_time = 0.0;
+} benchmark;
+
+void create_rope(int32_t segments)
+{
+    benchmark.world = std::make_unique<World>();
+    benchmark.world->SetStepMode(World::StepMode::Frame);
+    benchmark.step = 0;
+    benchmark.solve = 0.0;
+    benchmark.step_time = 0.0;
+
+    World& world = *benchmark.world;
+    const frame::vec2 start = { 50.0f, 500.0f };
+    const frame::vec2 end = start + frame::vec2(segments * World::RopeData::SegmentHeight, 0.0f);
+
+    auto anchor = world.CreateRectangle(start, 20.0f, 20.0f);
+    world.SetStatic(anchor, true);
+
+    auto weight = world.CreateCircle(end, 15.0f);
+    world.SetStatic(weight, false);
+
+    world.CreateRope({ start, end }, frame::col4::DARKGRAY, &anchor, &weight);
+}
+
+void setup()
+{
+    std::printf("%8s %8s | %10s %10s | %14s\n", "segments", "joints", "solve [ms]", "step [ms]", "solve/seg [us]");
+
+    create_rope(segment_counts[0]);
+
+    frame::set_world_transform(frame::translation({ 0.0f, frame::get_screen_size().y }) * frame::scale({ 1.0f, -1.0f }));
+}
+
+void update()
+{
+    if (benchmark.rope == segment_count_size)
+    {
+        benchmark.world->Draw();
+        return;
+    }
+
+    benchmark.world->Update();
+    benchmark.world->Draw();
+
+    const b2Profile& profile = benchmark.world->m_world.GetProfile();
+    benchmark.solve += profile.solve;
+    benchmark.step_time += profile.step;
+
+    if (++benchmark.step < steps_per_rope)
+        return;
+
+    int32_t segments = segment_counts[benchmark.rope];
+    double solve = benchmark.solve / steps_per_rope;
+    std::printf("%8d %8d | %10.3f %10.3f | %14.3f\n", segments, benchmark.world->m_world.GetJointCount(),
+        solve, benchmark.step_time / steps_per_rope, 1000.0 * solve / segments);
+    std::fflush(stdout);
+
+    if (++benchmark.rope < segment_count_size)
+        create_rope(segment_counts[benchmark.rope]);
+}
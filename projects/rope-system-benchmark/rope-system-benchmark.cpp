@@ -0,0 +1,207 @@
+// Compares stepping many ropes one by one with b2Rope and all at once with b2RopeSystem. Ropes hang from a
+// fixed first particle and swing under gravity, step times are averaged over all steps. b2RopeSystem runs
+// on the calling thread and on 1, 2, 4 ... threads up to the given number.
+//
+// Vertices of b2RopeSystem must be bit-equal between the run on the calling thread, a repeated run and the
+// runs on more threads, the benchmark fails with exit code 1 otherwise. b2Rope solves stretch constraints
+// in a different order, so its results are not compared.
+//
+//     rope-system-benchmark [--steps 300] [--threads 4]
+
+#include "box2d/box2d.h"
+#include "box2d/b2_rope.h"
+#include "box2d/b2_rope_system.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct options
+{
+    int32_t steps = 300;
+    int32_t threads = 4;
+    int32_t iterations = 8;
+};
+
+struct result
+{
+    double step = 0.0; // average per step [ms]
+    uint64_t hash = 0; // of vertices at the last step
+};
+
+// vertices and masses of all ropes, first particle is fixed
+struct rope_shape
+{
+    std::vector<b2Vec2> vertices;
+    std::vector<float> masses;
+};
+
+rope_shape create_shape(int32_t particles)
+{
+    rope_shape shape;
+    for (int32_t i = 0; i < particles; i++)
+    {
+        shape.vertices.push_back({ 0.1f * i, 0.0f });
+        shape.masses.push_back(i == 0 ? 0.0f : 1.0f);
+    }
+    return shape;
+}
+
+b2RopeDef get_def(rope_shape& shape, b2StretchingModel model, int32_t rope)
+{
+    b2RopeDef def;
+    def.position.Set(0.5f * rope, 0.0f);
+    def.vertices = shape.vertices.data();
+    def.masses = shape.masses.data();
+    def.count = (int32_t)shape.vertices.size();
+    def.gravity.Set(0.0f, -10.0f);
+    def.tuning.stretchingModel = model;
+    def.tuning.stretchHertz = 30.0f;
+    def.tuning.stretchDamping = 0.1f;
+    return def;
+}
+
+result run_ropes(int32_t ropes, int32_t particles, b2StretchingModel model, const options& opts)
+{
+    rope_shape shape = create_shape(particles);
+
+    std::unique_ptr<b2Rope[]> all(new b2Rope[ropes]);
+    for (int32_t i = 0; i < ropes; i++)
+        all[i].Create(get_def(shape, model, i));
+
+    result r;
+    for (int32_t step = 0; step < opts.steps; step++)
+    {
+        b2Timer timer;
+        for (int32_t i = 0; i < ropes; i++)
+            all[i].Step(1.0f / 60.0f, opts.iterations, { 0.5f * i, 0.0f });
+        r.step += timer.GetMilliseconds();
+    }
+
+    r.step /= opts.steps;
+    return r;
+}
+
+// FNV-1a of the bits of vertices
+uint64_t hash_vertices(const b2RopeSystem& system)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (int32_t i = 0; i < 4; i++)
+        {
+            hash ^= (bits >> (8 * i)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    };
+
+    for (int32_t rope = 0; rope < system.GetRopeCount(); rope++)
+    {
+        for (int32_t i = 0; i < system.GetVertexCount(rope); i++)
+        {
+            b2Vec2 v = system.GetVertex(rope, i);
+            add(v.x);
+            add(v.y);
+        }
+    }
+
+    return hash;
+}
+
+result run_system(int32_t ropes, int32_t particles, b2StretchingModel model, const options& opts, b2TaskScheduler* scheduler)
+{
+    rope_shape shape = create_shape(particles);
+
+    b2RopeSystem system;
+    system.SetTaskScheduler(scheduler);
+    for (int32_t i = 0; i < ropes; i++)
+        system.CreateRope(get_def(shape, model, i));
+
+    result r;
+    for (int32_t step = 0; step < opts.steps; step++)
+    {
+        b2Timer timer;
+        system.Step(1.0f / 60.0f, opts.iterations);
+        r.step += timer.GetMilliseconds();
+    }
+
+    r.step /= opts.steps;
+    r.hash = hash_vertices(system);
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    options opts;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--steps") == 0)
+            opts.steps = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--threads") == 0)
+            opts.threads = std::atoi(argv[i + 1]);
+    }
+
+    std::vector<int32_t> thread_counts;
+    for (int32_t threads = 1; threads < opts.threads; threads *= 2)
+        thread_counts.push_back(threads);
+    thread_counts.push_back(opts.threads);
+
+    std::vector<std::unique_ptr<b2ThreadPoolScheduler>> schedulers;
+    for (int32_t threads : thread_counts)
+        schedulers.push_back(std::make_unique<b2ThreadPoolScheduler>(threads));
+
+    struct
+    {
+        int32_t ropes;
+        int32_t particles;
+    } const cases[] = { { 16, 40 }, { 256, 40 }, { 1024, 40 }, { 64, 400 } };
+
+    const b2StretchingModel models[] = { b2_pbdStretchingModel, b2_xpbdStretchingModel };
+
+    std::printf("%-5s %5s %9s | %8s %8s", "model", "ropes", "particles", "b2Rope", "system");
+    for (int32_t threads : thread_counts)
+        std::printf(" %5d thr", threads);
+    std::printf(" | %7s\n", "speedup");
+
+    int32_t failed = 0;
+    for (b2StretchingModel model : models)
+    {
+        for (const auto& c : cases)
+        {
+            result ropes = run_ropes(c.ropes, c.particles, model, opts);
+            result system = run_system(c.ropes, c.particles, model, opts, nullptr);
+
+            std::printf("%-5s %5d %9d | %8.3f %8.3f", model == b2_pbdStretchingModel ? "pbd" : "xpbd",
+                c.ropes, c.particles, ropes.step, system.step);
+
+            bool repeated = run_system(c.ropes, c.particles, model, opts, nullptr).hash == system.hash;
+            bool threaded = true;
+            double best = system.step;
+            for (const auto& scheduler : schedulers)
+            {
+                result r = run_system(c.ropes, c.particles, model, opts, scheduler.get());
+                threaded = threaded && r.hash == system.hash;
+                best = r.step < best ? r.step : best;
+                std::printf(" %9.3f", r.step);
+            }
+
+            std::printf(" | %6.2fx\n", ropes.step / best);
+
+            // the same build must give the same bits, repeated and on more threads
+            if (!repeated || !threaded)
+            {
+                std::printf("    rope system is not reproducible:%s%s\n",
+                    repeated ? "" : " repeated run differs", threaded ? "" : " threaded run differs");
+                failed++;
+            }
+
+            std::fflush(stdout);
+        }
+    }
+
+    return failed == 0 ? 0 : 1;
+}
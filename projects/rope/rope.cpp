@@ -1,9 +1,7 @@
 #include "framework.h"
 #include "imgui.h"
 #include "world.h"
-#include <memory>
-
-#include <box2d/b2_rope.h>
+#include "particles.h"
 
 int32_t circles_count = 0;
 int32_t squares_count = 0;
@@ -11,151 +9,12 @@ int32_t squares_count = 0;
 World world;
 World::Joint mouse_joint = 0;
 
-struct VerletNode
-{
-    b2Vec2 position;
-    b2Vec2 oldPosition;
-
-    VerletNode() {}
-    VerletNode(const b2Vec2& startPos)
-        : position(startPos), oldPosition(startPos)
-    {
-    }
-};
-
-struct Separation
-{
-    b2Body* body;
-    b2Vec2 vector;
-};
-
-std::vector<Separation> g_separations;
+ParticleSystem particles(world);
+ParticleSystem::Particle rope = 0;
 
-struct Rope
-{
-    static const int iterations = 80;
-    static const int totalNodes = 160;
-    const float nodeDistance = .1f;
-    const b2Vec2 gravity = b2Vec2(0.0f, -9.89f);
-
-    b2Vec2 position = b2Vec2(0.0f, 0.0f);
-
-    VerletNode nodes[totalNodes];
-
-    b2Body* bodies[totalNodes] = {};
-
-    Rope(const b2Vec2& position)
-        : position(position)
-    {
-        b2Vec2 tmpPosition = position;
-        for (int i = 0; i < totalNodes; i++)
-        {
-            nodes[i] = VerletNode(tmpPosition);
-            tmpPosition.y -= nodeDistance;
-        }
-
-        CreateFixtures();
-    }
-
-    void CreateFixtures()
-    {
-        b2BodyDef bodyDef;
-        bodyDef.type = b2_dynamicBody;
-
-        b2CircleShape shape;
-        shape.m_radius = nodeDistance * 0.5f;
-        b2FixtureDef fixtureDef;
-        fixtureDef.shape = &shape;
-        fixtureDef.density = 0.5f;
-        fixtureDef.userData.type = b2FixtureUserData::Type::Rope;
-
-        for (int i = 0; i < totalNodes; i++)
-        {
-            bodyDef.position = nodes[i].position;
-            bodies[i] = world.m_world.CreateBody(&bodyDef);
-
-            fixtureDef.userData.ropeIndex = i;
-            auto fixture = bodies[i]->CreateFixture(&fixtureDef);
-        }
-    }
-
-    void Draw()
-    {
-        for (int i = 0; i < totalNodes; i++)
-        {
-            //auto position = WorldScalePoint(nodes[i].position);
-            auto position = WorldScalePoint(bodies[i]->GetPosition());
-            frame::draw_circle(position, 2.0f, frame::col4::ORANGE);
-        }
-    }
-
-    void Update(float dt)
-    {
-        Simulate(dt);
-        for (int i = 0; i < iterations; i++)
-        {
-            ApplyConstraints();
-
-            const_cast<b2ContactManager&>(world.m_world.GetContactManager()).FindNewContacts();
-
-            for (auto& separation : g_separations)
-                separation.body->SetTransform(separation.body->GetPosition() + separation.vector, separation.body->GetAngle());
-            g_separations.clear();
-        }
-    }
-
-    void Simulate(float dt)
-    {
-        b2Vec2 gravityDt = gravity;
-        gravityDt *= (dt * dt);
-
-        for (int i = 0; i < totalNodes; i++)
-        {
-            VerletNode& node = nodes[i];
-
-            b2Vec2 temp = node.position;
-            node.position += (node.position - node.oldPosition) + gravityDt;
-            node.oldPosition = temp;
-        }
-    }
-
-    void ApplyConstraints()
-    {
-        for (int i = 0; i < totalNodes - 1; i++)
-        {
-            VerletNode& node1 = nodes[i];
-            VerletNode& node2 = nodes[i + 1];
-
-            // First node follows the mouse, for debugging.
-            if (i == 0 && frame::is_mouse_down(frame::mouse_button::middle))
-            {
-                node1.position = WorldScalePoint(frame::get_mouse_world_position());
-            }
-
-            // Current distance between rope nodes.
-            b2Vec2 diff;
-            diff.x = node1.position.x - node2.position.x;
-            diff.y = node1.position.y - node2.position.y;
-            float dist = b2Distance(node1.position, node2.position);
-            float difference = 0;
-            // Guard against divide by 0.
-            if (dist > 0)
-            {
-                difference = (nodeDistance - dist) / dist;
-            }
-
-            diff *= (0.5f * difference);
-
-            node1.position += diff;
-            node2.position -= diff;
-
-            bodies[i]->SetTransform(node1.position, 0.0f);
-            bodies[i + 1]->SetTransform(node2.position, 0.0f);
-        }
-    }
-};
-
-std::unique_ptr<Rope> g_rope2;
+const int32_t RopeNodes = 160;
+const float RopeNodeRadius = 2.5f;
+const float RopeNodeMass = 0.01f;
 
 void create_square()
 {
@@ -182,52 +41,12 @@ void create_ground()
     world.SetFill(ground, frame::col4::RGB(80, 80, 80));
 }
 
-class ContactListener : public b2ContactListener
-{
-public:
-    //void PreSolve(b2Contact* contact, const b2Manifold* oldManifold) override
-    void BeginContact(b2Contact* contact) override
-    {
-        if (!contact->IsTouching())
-            return;
-
-        if (contact->GetFixtureA()->GetUserData().type == b2FixtureUserData::Type::Rope &&
-            contact->GetFixtureB()->GetUserData().type == b2FixtureUserData::Type::Rope)
-            return;
-
-        if (contact->GetFixtureA()->GetUserData().type != b2FixtureUserData::Type::Rope &&
-            contact->GetFixtureB()->GetUserData().type != b2FixtureUserData::Type::Rope)
-            return;
-
-        b2Fixture* ropeFixture = contact->GetFixtureA()->GetUserData().type == b2FixtureUserData::Type::Rope ? contact->GetFixtureA() : contact->GetFixtureB();
-        b2Fixture* otherFixture = contact->GetFixtureA()->GetUserData().type != b2FixtureUserData::Type::Rope ? contact->GetFixtureA() : contact->GetFixtureB();
-
-        b2WorldManifold manifold;
-        contact->GetWorldManifold(&manifold);
-
-        b2Vec2 separation = manifold.normal;
-        separation *= manifold.separations[0];
-
-        if (contact->GetFixtureA() == otherFixture)
-        {
-            g_separations.push_back({ ropeFixture->GetBody(), -separation });
-            //ropeFixture->GetBody()->SetTransform(ropeFixture->GetBody()->GetPosition() + separation, ropeFixture->GetBody()->GetAngle());
-        }
-        else
-        {
-            g_separations.push_back({ ropeFixture->GetBody(), separation });
-            //ropeFixture->GetBody()->SetTransform(ropeFixture->GetBody()->GetPosition() - separation, ropeFixture->GetBody()->GetAngle());
-        }
-        contact->SetEnabled(false);
-    }
-
-} g_listener;
-
 void setup()
 {
-    g_rope2 = std::make_unique<Rope>(WorldScalePoint(frame::vec2(400.0f, 300.0f)));
-
-    world.m_world.SetContactListener(&g_listener);
+    particles.SetRadius(RopeNodeRadius);
+    particles.SetIterations(40);
+    rope = particles.CreateRope(frame::get_world_position_screen_relative({ 0.05f, 0.8f }),
+                                frame::get_world_position_screen_relative({ 0.95f, 0.8f }), RopeNodes, RopeNodeMass);
 
     create_ground();
 
@@ -259,6 +78,16 @@ void handle_mouse()
             world.DestroyJoint(mouse_joint);
         mouse_joint = 0;
     }
+
+    // first node of rope follows the mouse
+    if (frame::is_mouse_down(frame::mouse_button::middle))
+    {
+        particles.SetMass(rope, 0.0f);
+        particles.SetPosition(rope, frame::get_mouse_world_position());
+    }
+
+    if (frame::is_mouse_released(frame::mouse_button::middle))
+        particles.SetMass(rope, RopeNodeMass);
 }
 
 void draw_gui()
@@ -275,6 +104,7 @@ void draw_gui()
     ImGui::SameLine();
     ImGui::Text("%d", squares_count);
     ImGui::TextColored(ImVec4(0, 1, 1, 1), "Use right mouse button to grab objects");
+    ImGui::TextColored(ImVec4(0, 1, 1, 1), "Use middle mouse button to drag rope");
 
     ImGui::TextColored(ImVec4(1, 1, 0, 1), "Average");
     ImGui::SameLine();
@@ -291,9 +121,11 @@ void update()
 
     world.Update();
 
-    g_rope2->Update(1.0f/ 60.0f);
+    // particles are stepped along with world
+    for (int32_t i = 0; i < world.GetStepCount(); i++)
+        particles.Step(world.m_timeStep);
 
     world.Draw();
 
-    g_rope2->Draw();
+    particles.Draw(frame::col4::ORANGE);
 }
@@ -47,6 +47,7 @@ struct body_data
 
     // trajectory
     std::vector<vec2> trajectory;
+    shape trajectory_shape = 0;
 };
 
 struct ephemeris_data
@@ -72,7 +73,7 @@ void draw_ephemeris_trajectories(ephemeris_data& data)
             if (std::isnan(position.x) || std::isnan(position.y))
                 position = {};
 
-            draw_bezier_polyline_ex(data.trajectory, scale_independent(1.0f), col4::GREEN);
+            draw_shape(data.trajectory_shape);
             draw_circle(position, scale_independent(5.0f), col4::RED);
             //draw_text(data.name.c_str(), position, 15.0f, col4::GRAY, frame::text_align::bottom_left);
 
@@ -226,6 +227,18 @@ void setup()
     setup_units();
 
     ephem_data = load_ephemeris_data();
+
+    // trajectories don't change, they are tessellated only when zoom changes
+    for (auto& body : ephem_data.bodies)
+    {
+        shape_desc desc;
+        desc.points = body.trajectory;
+        desc.smooth = true;
+        desc.stroke_thickness = 1.0f;
+        desc.stroke_color = col4::GREEN;
+
+        body.trajectory_shape = create_shape(desc);
+    }
 }
 
 void draw_debug_gui()
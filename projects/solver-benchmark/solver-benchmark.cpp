@@ -0,0 +1,194 @@
+// Compares the scalar and the wide (SIMD) contact solver on stacked boxes. Pyramids and columns of boxes
+// stand on the ground and are simulated with sleeping disabled, the b2Profile velocity, position and whole
+// solve times are averaged over all steps. Iterations are the same as of framework World.
+//
+// Every scene is simulated twice with each solver and on 1 and the given number of threads. Positions,
+// angles and velocities of all bodies must be bit-equal between those runs, the benchmark fails with exit
+// code 1 otherwise.
+//
+//     solver-benchmark [--steps 300] [--threads 4]
+
+#include "box2d/box2d.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+enum class scene
+{
+    pyramid,    // one pyramid, contacts of many pairs share bodies
+    columns     // many narrow columns, like stacks of kladkostroj
+};
+
+const char* get_name(scene s)
+{
+    switch (s)
+    {
+    case scene::pyramid: return "pyramid";
+    case scene::columns: return "columns";
+    }
+    return "";
+}
+
+struct options
+{
+    int32_t steps = 300;
+    int32_t threads = 4;
+    int32_t velocity_iterations = 32;
+    int32_t position_iterations = 16;
+};
+
+struct result
+{
+    double velocity = 0.0; // average per step [ms]
+    double position = 0.0;
+    double solve = 0.0;
+    uint64_t hash = 0;     // of body state at the last step
+};
+
+// size is rows of pyramid, or columns and their height
+void create_bodies(b2World& world, scene s, int32_t size)
+{
+    b2BodyDef ground_def;
+    b2Body* ground = world.CreateBody(&ground_def);
+    b2PolygonShape ground_shape;
+    ground_shape.SetAsBox(10.0f * size, 1.0f, { 0.0f, -1.0f }, 0.0f);
+    ground->CreateFixture(&ground_shape, 0.0f);
+
+    const float half_size = 0.5f;
+    b2PolygonShape box;
+    box.SetAsBox(half_size, half_size);
+
+    auto create_box = [&](float x, float y)
+    {
+        b2BodyDef def;
+        def.type = b2_dynamicBody;
+        def.position.Set(x, y);
+        world.CreateBody(&def)->CreateFixture(&box, 1.0f);
+    };
+
+    if (s == scene::pyramid)
+    {
+        for (int32_t row = 0; row < size; row++)
+        {
+            for (int32_t i = 0; i < size - row; i++)
+                create_box((i - 0.5f * (size - row - 1)) * 2.0f * half_size, half_size + row * 2.0f * half_size);
+        }
+    }
+    else
+    {
+        for (int32_t column = 0; column < size; column++)
+        {
+            for (int32_t i = 0; i < size; i++)
+                create_box((column - 0.5f * size) * 4.0f * half_size, half_size + i * 2.0f * half_size);
+        }
+    }
+}
+
+// FNV-1a of the bits of body state
+uint64_t hash_bodies(const b2World& world)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (int32_t i = 0; i < 4; i++)
+        {
+            hash ^= (bits >> (8 * i)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    };
+
+    for (const b2Body* body = world.GetBodyList(); body; body = body->GetNext())
+    {
+        add(body->GetPosition().x);
+        add(body->GetPosition().y);
+        add(body->GetAngle());
+        add(body->GetLinearVelocity().x);
+        add(body->GetLinearVelocity().y);
+        add(body->GetAngularVelocity());
+    }
+
+    return hash;
+}
+
+result run(bool wide, scene s, int32_t size, const options& opts, b2TaskScheduler* scheduler)
+{
+    b2World world({ 0.0f, -10.0f });
+    world.SetWideSolving(wide);
+    world.SetAllowSleeping(false);
+    world.SetTaskScheduler(scheduler);
+
+    create_bodies(world, s, size);
+
+    result r;
+    for (int32_t i = 0; i < opts.steps; i++)
+    {
+        world.Step(1.0f / 60.0f, opts.velocity_iterations, opts.position_iterations);
+
+        const b2Profile& profile = world.GetProfile();
+        r.velocity += profile.solveVelocity;
+        r.position += profile.solvePosition;
+        r.solve += profile.solve;
+    }
+
+    r.velocity /= opts.steps;
+    r.position /= opts.steps;
+    r.solve /= opts.steps;
+    r.hash = hash_bodies(world);
+
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    options opts;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--steps") == 0)
+            opts.steps = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--threads") == 0)
+            opts.threads = std::atoi(argv[i + 1]);
+    }
+
+    b2ThreadPoolScheduler scheduler(opts.threads);
+
+    struct
+    {
+        scene s;
+        int32_t size;
+    } const cases[] = { { scene::pyramid, 20 }, { scene::pyramid, 40 }, { scene::columns, 10 }, { scene::columns, 30 } };
+
+    std::printf("%-8s %4s | %17s | %17s | %17s | %7s\n", "scene", "size", "velocity [ms]", "position [ms]", "solve [ms]", "speedup");
+    std::printf("%-8s %4s | %8s %8s | %8s %8s | %8s %8s | %7s\n", "", "", "scalar", "wide", "scalar", "wide", "scalar", "wide", "");
+
+    int32_t failed = 0;
+    for (const auto& c : cases)
+    {
+        result scalar = run(false, c.s, c.size, opts, nullptr);
+        result wide = run(true, c.s, c.size, opts, nullptr);
+
+        std::printf("%-8s %4d | %8.3f %8.3f | %8.3f %8.3f | %8.3f %8.3f | %6.2fx\n", get_name(c.s), c.size,
+            scalar.velocity, wide.velocity, scalar.position, wide.position, scalar.solve, wide.solve, scalar.solve / wide.solve);
+
+        // the same build must give the same bits, repeated and on more threads
+        const bool flags[] = { false, true };
+        const uint64_t hashes[] = { scalar.hash, wide.hash };
+        for (int32_t i = 0; i < 2; i++)
+        {
+            bool repeated = run(flags[i], c.s, c.size, opts, nullptr).hash == hashes[i];
+            bool threaded = run(flags[i], c.s, c.size, opts, &scheduler).hash == hashes[i];
+            if (!repeated || !threaded)
+            {
+                std::printf("    %s solver is not reproducible:%s%s\n", flags[i] ? "wide" : "scalar",
+                    repeated ? "" : " repeated run differs", threaded ? "" : " threaded run differs");
+                failed++;
+            }
+        }
+
+        std::fflush(stdout);
+    }
+
+    return failed == 0 ? 0 : 1;
+}